@@ -32,6 +32,7 @@
 #include <Utility.H>
 #include <DistributionMapping.H>
 #include <FabSet.H>
+#include <MemProfiler.H>
 
 #ifdef BL_USE_ARRAYVIEW
 #include <DatasetClient.H>
@@ -73,6 +74,9 @@ namespace
     int  regrid_on_restart;
     int  use_efficient_regrid;
     bool refine_grid_layout;
+    int  cluster_in_parallel;
+    int  async_output;
+    int  chunked_restart;
     int  plotfile_on_restart;
     int  checkpoint_on_restart;
     bool checkpoint_files_output;
@@ -95,6 +99,9 @@ Amr::Initialize ()
     regrid_on_restart        = 0;
     use_efficient_regrid     = 0;
     refine_grid_layout       = true;
+    cluster_in_parallel      = 0;
+    async_output             = 0;
+    chunked_restart          = 1;
     plotfile_on_restart      = 0;
     checkpoint_on_restart    = 0;
     checkpoint_files_output  = true;
@@ -266,7 +273,12 @@ Amr::InitAmr (int max_level_in, Array<int> n_cell_in)
 
     pp.query("refine_grid_layout", refine_grid_layout);
 
+    pp.query("cluster_in_parallel", cluster_in_parallel);
+
+    pp.query("async_output", async_output);
+
     pp.query("mffile_nstreams", mffile_nstreams);
+    pp.query("chunked_restart", chunked_restart);
     pp.query("probinit_natonce", probinit_natonce);
 
     probinit_natonce = std::max(1, std::min(ParallelDescriptor::NProcs(), probinit_natonce));
@@ -723,6 +735,8 @@ Amr::deleteDerivePlotVar (const std::string& name)
 
 Amr::~Amr ()
 {
+    finishAsyncOutput();
+
     levelbld->variableCleanUp();
 
     Amr::Finalize();
@@ -837,6 +851,10 @@ Amr::writePlotFile ()
 
     BL_PROFILE_REGION_START("Amr::writePlotFile()");
     BL_PROFILE("Amr::writePlotFile()");
+    //
+    // Only one lot of asynchronous output is ever outstanding.
+    //
+    finishAsyncOutput();
 
     VisMF::SetNOutFiles(plot_nfiles);
 
@@ -856,8 +874,14 @@ Amr::writePlotFile ()
     if (record_run_info && ParallelDescriptor::IOProcessor())
         runlog << "PLOTFILE: file = " << pltfile << '\n';
 
+  //
+  // No retries with asynchronous output: the FAB writes are still in
+  // flight when the loop comes round, so a retry would clean out the
+  // directory under them, and their errors aren't known until
+  // finishAsyncOutput() anyway.
+  //
   BoxLib::StreamRetry sretry(pltfile, abort_on_stream_retry_failure,
-                             stream_max_tries);
+                             async_output ? 1 : stream_max_tries);
 
   const std::string pltfileTemp(pltfile + ".temp");
 
@@ -894,9 +918,13 @@ Amr::writePlotFile ()
         old_prec = HeaderFile.precision(15);
     }
 
+    VisMF::SetAsyncWrite(async_output);
+
     for (int k(0); k <= finest_level; ++k)
         amr_level[k].writePlotFile(pltfileTemp, HeaderFile);
 
+    VisMF::SetAsyncWrite(false);
+
     if (ParallelDescriptor::IOProcessor())
     {
         HeaderFile.precision(old_prec);
@@ -916,6 +944,15 @@ Amr::writePlotFile ()
         if (ParallelDescriptor::IOProcessor())
             std::cout << "Write plotfile time = " << dPlotFileTime << "  seconds" << "\n\n";
     }
+    if (async_output)
+    {
+        //
+        // The FABs are still being written; rename it when they're done.
+        //
+        async_renames.push_back(std::make_pair(pltfileTemp,pltfile));
+        continue;
+    }
+
     ParallelDescriptor::Barrier("Amr::writePlotFile::end");
 
     if(ParallelDescriptor::IOProcessor()) {
@@ -930,6 +967,60 @@ Amr::writePlotFile ()
   BL_PROFILE_REGION_STOP("Amr::writePlotFile()");
 }
 
+void
+Amr::finishAsyncOutput ()
+{
+    if (async_renames.empty()) return;
+
+    BL_PROFILE("Amr::finishAsyncOutput()");
+
+    Real dWaitTime0 = ParallelDescriptor::second();
+
+    const int nerrors = VisMF::AsyncWait();
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        for (std::list< std::pair<std::string,std::string> >::const_iterator it = async_renames.begin(),
+                 End = async_renames.end();
+             it != End;
+             ++it)
+        {
+            if (nerrors == 0)
+            {
+                std::rename(it->first.c_str(), it->second.c_str());
+            }
+            else
+            {
+                //
+                // Leave it with the temporary name so no one restarts from it.
+                //
+                std::cout << nerrors << " asynchronous write errors: leaving "
+                          << it->first << " incomplete" << std::endl;
+            }
+        }
+    }
+
+    async_renames.clear();
+    //
+    // Asynchronous output isn't retried, so this is the only place the
+    // errors are seen; treat them as a failed retry would be.
+    //
+    if (nerrors > 0 && abort_on_stream_retry_failure)
+        BoxLib::Abort("STREAMERROR : asynchronous plotfile or checkpoint write failed.");
+
+    if (verbose > 0)
+    {
+        Real dWaitTime = ParallelDescriptor::second() - dWaitTime0;
+
+        ParallelDescriptor::ReduceRealMax(dWaitTime,ParallelDescriptor::IOProcessorNumber());
+
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << "Waited for asynchronous output for " << dWaitTime << " secs." << '\n';
+    }
+
+    ParallelDescriptor::Barrier("Amr::finishAsyncOutput");
+}
+
 void
 Amr::checkInput ()
 {
@@ -1264,6 +1355,14 @@ Amr::restart (const std::string& filename)
 
 
     VisMF::SetMFFileInStreams(mffile_nstreams);
+    //
+    // Read the state with chunked reads, which spread the reading over
+    // all the CPUs whatever the number of CPUs that wrote the checkpoint.
+    // amr.chunked_restart = 0 turns them off.
+    //
+    const bool thePrevChunkedRead = VisMF::GetChunkedRead();
+
+    VisMF::SetChunkedRead(chunked_restart);
 
     int i;
 
@@ -1515,6 +1614,8 @@ Amr::restart (const std::string& filename)
     station.findGrid(amr_level,geom);
 #endif
 
+    VisMF::SetChunkedRead(thePrevChunkedRead);
+
     if (verbose > 0)
     {
         Real dRestartTime = ParallelDescriptor::second() - dRestartTime0;
@@ -1535,6 +1636,8 @@ Amr::checkPoint ()
     BL_PROFILE_REGION_START("Amr::checkPoint()");
     BL_PROFILE("Amr::checkPoint()");
 
+    finishAsyncOutput();
+
     VisMF::SetNOutFiles(checkpoint_nfiles);
     //
     // In checkpoint files always write out FABs in NATIVE format.
@@ -1554,8 +1657,14 @@ Amr::checkPoint ()
         runlog << "CHECKPOINT: file = " << ckfile << '\n';
 
 
+  //
+  // No retries with asynchronous output: the FAB writes are still in
+  // flight when the loop comes round, so a retry would clean out the
+  // directory under them, and their errors aren't known until
+  // finishAsyncOutput() anyway.
+  //
   BoxLib::StreamRetry sretry(ckfile, abort_on_stream_retry_failure,
-                             stream_max_tries);
+                             async_output ? 1 : stream_max_tries);
 
   const std::string ckfileTemp(ckfile + ".temp");
 
@@ -1617,9 +1726,13 @@ Amr::checkPoint ()
         HeaderFile << '\n';
     }
 
+    VisMF::SetAsyncWrite(async_output);
+
     for (i = 0; i <= finest_level; ++i)
         amr_level[i].checkPoint(ckfileTemp, HeaderFile);
 
+    VisMF::SetAsyncWrite(false);
+
     if (ParallelDescriptor::IOProcessor())
     {
         HeaderFile.precision(old_prec);
@@ -1647,6 +1760,12 @@ Amr::checkPoint ()
         if (ParallelDescriptor::IOProcessor())
             std::cout << "checkPoint() time = " << dCheckPointTime << " secs." << '\n';
     }
+    if (async_output)
+    {
+        async_renames.push_back(std::make_pair(ckfileTemp,ckfile));
+        continue;
+    }
+
     ParallelDescriptor::Barrier("Amr::checkPoint::end");
 
     if(ParallelDescriptor::IOProcessor()) {
@@ -1905,11 +2024,11 @@ Amr::coarseTimeStep (Real stop_time)
                       << max_fab_kilobytes
                       << "]\n";
         }
-        //
-        // Reset to zero to calculate high-water-mark for next timestep.
-        //
-        BoxLib::ResetTotalBytesAllocatedInFabsHWM();
     }
+    //
+    // Records this step's memory and starts the high-water marks for the next.
+    //
+    MemProfiler::ReportStep(level_steps[0]);
 
     BL_PROFILE_ADD_STEP(level_steps[0]);
     BL_PROFILE_REGION_STOP("Amr::coarseTimeStep()");
@@ -2187,6 +2306,7 @@ Amr::regrid (int  lbase,
     Geometry::FlushPIRMCache();
     FabArrayBase::CPC::FlushCache();
     DistributionMapping::FlushCache();
+    AmrLevel::FlushFPICache();
 
     //
     // Define the new grids from level start up to new_finest.
@@ -2528,6 +2648,134 @@ Amr::ProjPeriodic (BoxList&        blout,
     }
 }
 
+namespace
+{
+    //
+    // Parts are never split below this many (coarsened) cells on a side,
+    // since clustering on smaller pieces costs us too much efficiency.
+    //
+    const int MinClusterPartSize = 8;
+    //
+    // The distributed version of the tag collation and clustering in
+    // grid_places().  The coarsened problem domain is split into about
+    // one part per CPU, each tag is sent to the CPU owning its part and
+    // each CPU clusters its own parts.  Only the resulting boxes are
+    // gathered to all CPUs, so no CPU ever sees all the tags.
+    //
+    void
+    ClusterTagsInParallel (const TagBoxArray& tags,
+                           const Box&         pc_domain,
+                           const BoxList&     p_n,
+                           Real               grid_eff,
+                           BoxList&           new_bx)
+    {
+        BL_PROFILE("ClusterTagsInParallel()");
+
+        const int NProcs = ParallelDescriptor::NProcs();
+
+        BoxArray parts(pc_domain);
+        IntVect  chunk = pc_domain.size();
+
+        while (parts.size() < NProcs)
+        {
+            int dir = 0;
+
+            for (int n = 1; n < BL_SPACEDIM; n++)
+                if (chunk[n] > chunk[dir]) dir = n;
+
+            if (chunk[dir] < 2*MinClusterPartSize) break;
+
+            chunk[dir] = (chunk[dir]+1)/2;
+
+            parts = BoxArray(pc_domain);
+            parts.maxSize(chunk);
+        }
+
+        std::map< int,std::vector<IntVect> > ptags;
+
+        tags.collate(parts,ptags);
+
+        BoxList bl;
+
+        for (std::map< int,std::vector<IntVect> >::iterator it = ptags.begin(), End = ptags.end();
+             it != End;
+             ++it)
+        {
+            std::vector<IntVect>& pts = it->second;
+
+            ClusterList clist(&pts[0],pts.size());
+            clist.chop(grid_eff);
+            BoxDomain bd;
+            bd.add(BoxLib::intersect(p_n,parts[it->first]));
+            clist.intersect(bd);
+
+            BoxList cbl;
+            clist.boxList(cbl);
+            bl.catenate(cbl);
+
+            std::vector<IntVect>().swap(pts);
+        }
+        //
+        // Gather the boxes in CPU order so everyone ends up with the same list.
+        //
+        Array<int> sndbuf;
+
+        sndbuf.reserve(bl.size()*2*BL_SPACEDIM);
+
+        for (BoxList::const_iterator bli = bl.begin(), End = bl.end(); bli != End; ++bli)
+        {
+            for (int n = 0; n < BL_SPACEDIM; n++) sndbuf.push_back(bli->smallEnd(n));
+            for (int n = 0; n < BL_SPACEDIM; n++) sndbuf.push_back(bli->bigEnd(n));
+        }
+
+        Array<int> rcvbuf;
+
+#if BL_USE_MPI
+        int        nsnd = sndbuf.size();
+        Array<int> rcvcnt(NProcs,0), rcvoff(NProcs,0);
+
+        BL_MPI_REQUIRE( MPI_Allgather(&nsnd,
+                                      1,
+                                      ParallelDescriptor::Mpi_typemap<int>::type(),
+                                      rcvcnt.dataPtr(),
+                                      1,
+                                      ParallelDescriptor::Mpi_typemap<int>::type(),
+                                      ParallelDescriptor::Communicator()) );
+
+        for (int i = 1; i < NProcs; i++)
+            rcvoff[i] = rcvoff[i-1] + rcvcnt[i-1];
+
+        rcvbuf.resize(rcvoff[NProcs-1] + rcvcnt[NProcs-1]);
+
+        if (rcvbuf.size() > 0)
+        {
+            BL_MPI_REQUIRE( MPI_Allgatherv(nsnd == 0 ? 0 : sndbuf.dataPtr(),
+                                           nsnd,
+                                           ParallelDescriptor::Mpi_typemap<int>::type(),
+                                           rcvbuf.dataPtr(),
+                                           rcvcnt.dataPtr(),
+                                           rcvoff.dataPtr(),
+                                           ParallelDescriptor::Mpi_typemap<int>::type(),
+                                           ParallelDescriptor::Communicator()) );
+        }
+#else
+        rcvbuf = sndbuf;
+#endif
+        new_bx.clear();
+
+        for (int i = 0, N = rcvbuf.size(); i < N; i += 2*BL_SPACEDIM)
+        {
+            const IntVect lo(&rcvbuf[i]), hi(&rcvbuf[i+BL_SPACEDIM]);
+
+            new_bx.push_back(Box(lo,hi));
+        }
+        //
+        // Glue back together boxes that were cut at part boundaries.
+        //
+        new_bx.simplify();
+    }
+}
+
 void
 Amr::grid_places (int              lbase,
                   Real             time,
@@ -2833,14 +3081,52 @@ Amr::grid_places (int              lbase,
         //
         tags.setVal(p_n_comp[levc],TagBox::CLEAR);
         //
-        // Create initial cluster containing all tagged points.
+        // Cluster the tagged points into efficient boxes, intersected
+        // with the proper nesting domain.
         //
-        long     len = 0;
-        IntVect* pts = tags.collate(len);
+        BoxList new_bx;
+        bool    have_tags = false;
+
+        if (cluster_in_parallel && ParallelDescriptor::NProcs() > 1)
+        {
+            ClusterTagsInParallel(tags, pc_domain[levc], p_n[levc], grid_eff, new_bx);
+
+            tags.clear();
+
+            have_tags = !new_bx.isEmpty();
+        }
+        else
+        {
+            //
+            // Create initial cluster containing all tagged points.
+            //
+            long     len = 0;
+            IntVect* pts = tags.collate(len);
 
-        tags.clear();
+            tags.clear();
 
-        if (len > 0)
+            if (len > 0)
+            {
+                //
+                // Construct initial cluster.
+                //
+                ClusterList clist(pts,len);
+                clist.chop(grid_eff);
+                BoxDomain bd;
+                bd.add(p_n[levc]);
+                clist.intersect(bd);
+                bd.clear();
+                clist.boxList(new_bx);
+
+                have_tags = true;
+            }
+            //
+            // Don't forget to get rid of space used for collate()ing.
+            //
+            delete [] pts;
+        }
+
+        if (have_tags)
         {
             //
             // Created new level, now generate efficient grids.
@@ -2848,20 +3134,9 @@ Amr::grid_places (int              lbase,
             if ( !(useFixedCoarseGrids && levc<useFixedUpToLevel) )
                 new_finest = std::max(new_finest,levf);
             //
-            // Construct initial cluster.
-            //
-            ClusterList clist(pts,len);
-            clist.chop(grid_eff);
-            BoxDomain bd;
-            bd.add(p_n[levc]);
-            clist.intersect(bd);
-            bd.clear();
-            //
             // Efficient properly nested Clusters have been constructed
             // now generate list of grids at level levf.
             //
-            BoxList new_bx;
-            clist.boxList(new_bx);
             new_bx.refine(bf_lev[levc]);
             new_bx.simplify();
             BL_ASSERT(new_bx.isDisjoint());
@@ -2905,10 +3180,6 @@ Amr::grid_places (int              lbase,
             if (levf > useFixedUpToLevel)
                 new_grids[levf].define(new_bx);
         }
-        //
-        // Don't forget to get rid of space used for collate()ing.
-        //
-        delete [] pts;
     }
 
     // If Nprocs > Ngrids and refine_grid_layout == 1 then break up the grids
@@ -1,6 +1,7 @@
 
 #include <winstd.H>
 #include <sstream>
+#include <list>
 
 #include <AmrLevel.H>
 #include <Derive.H>
@@ -16,6 +17,102 @@ DeriveList     AmrLevel::derive_lst;
 SlabStatList   AmrLevel::slabstat_lst;
 #endif
 
+namespace
+{
+    //
+    // The cached FillPatch plans of each AmrLevel, most recently used first.
+    //
+    typedef std::list<FillPatchPlan*> FPPlanList;
+
+    std::map<const AmrLevel*,FPPlanList> TheFPPlans;
+    //
+    // Set from "amr.fillpatch_plans" on first use.
+    //
+    int max_fp_plans = -1;
+
+    void
+    DeleteFPPlans (FPPlanList& plans)
+    {
+        for (FPPlanList::iterator it = plans.begin(), End = plans.end(); it != End; ++it)
+            delete *it;
+        plans.clear();
+    }
+    //
+    // Returns the cached plan for this FillPatch, building an empty one
+    // if we don't have it.  Returns null if the caching is turned off.
+    //
+    FillPatchPlan*
+    GetFPPlan (const AmrLevel& amrlevel,
+               const MultiFab& leveldata,
+               int             boxGrow,
+               int             index,
+               int             scomp,
+               int             ncomp)
+    {
+        if (max_fp_plans < 0)
+        {
+            max_fp_plans = 8;
+            ParmParse pp("amr");
+            pp.query("fillpatch_plans", max_fp_plans);
+            max_fp_plans = std::max(max_fp_plans,0);
+        }
+
+        if (max_fp_plans == 0) return 0;
+
+        FPPlanList& plans = TheFPPlans[&amrlevel];
+
+        for (FPPlanList::iterator it = plans.begin(), End = plans.end(); it != End; ++it)
+        {
+            if ((*it)->matches(leveldata,boxGrow,index,scomp,ncomp))
+            {
+                plans.splice(plans.begin(), plans, it);
+
+                return plans.front();
+            }
+        }
+        //
+        // Make room by dropping the least recently used plan not in use.
+        //
+        if (int(plans.size()) >= max_fp_plans)
+        {
+            for (FPPlanList::iterator it = plans.end(); it != plans.begin(); )
+            {
+                if (!(*--it)->inUse())
+                {
+                    delete *it;
+                    plans.erase(it);
+                    break;
+                }
+            }
+        }
+
+        plans.push_front(new FillPatchPlan(leveldata,boxGrow,index,scomp,ncomp));
+
+        return plans.front();
+    }
+}
+
+void
+AmrLevel::FlushFPICache ()
+{
+    for (std::map<const AmrLevel*,FPPlanList>::iterator it = TheFPPlans.begin(), End = TheFPPlans.end();
+         it != End;
+         ++it)
+    {
+        DeleteFPPlans(it->second);
+    }
+
+    TheFPPlans.clear();
+}
+
+void
+AmrLevel::SetFillPatchPlans (int nplans)
+{
+    FlushFPICache();
+
+    max_fp_plans = std::max(nplans,0);
+}
+
 void
 AmrLevel::postCoarseTimeStep (Real time)
 {}
@@ -386,6 +483,14 @@ AmrLevel::checkPoint (const std::string& dir,
 
 AmrLevel::~AmrLevel ()
 {
+    std::map<const AmrLevel*,FPPlanList>::iterator it = TheFPPlans.find(this);
+
+    if (it != TheFPPlans.end())
+    {
+        DeleteFPPlans(it->second);
+        TheFPPlans.erase(it);
+    }
+
     parent = 0;
 }
 
@@ -450,14 +555,49 @@ AmrLevel::setPhysBoundaryValues (FArrayBox& dest,
                                    geom.ProbDomain(),dest_comp,src_comp,num_comp);
 }
 
-FillPatchIteratorHelper::FillPatchIteratorHelper (AmrLevel& amrlevel,
-                                                  MultiFab& leveldata)
+FillPatchPlan::FillPatchPlan (const MultiFab& leveldata,
+                              int             boxGrow,
+                              int             index,
+                              int             scomp,
+                              int             ncomp)
+    :
+    m_grids(leveldata.boxArray()),
+    m_dmap(leveldata.DistributionMap()),
+    m_grow(boxGrow),
+    m_index(index),
+    m_scomp(scomp),
+    m_ncomp(ncomp),
+    m_in_use(false)
+{}
+
+bool
+FillPatchPlan::matches (const MultiFab& leveldata,
+                        int             boxGrow,
+                        int             index,
+                        int             scomp,
+                        int             ncomp) const
+{
+    return m_grow  == boxGrow &&
+           m_index == index   &&
+           m_scomp == scomp   &&
+           m_ncomp == ncomp   &&
+           m_grids == leveldata.boxArray() &&
+           m_dmap  == leveldata.DistributionMap();
+}
+
+FillPatchIteratorHelper::FillPatchIteratorHelper (AmrLevel&             amrlevel,
+                                                  MultiFab&             leveldata,
+                                                  FillPatchPlan::Range& plan)
     :
     MFIter(leveldata),
     m_amrlevel(amrlevel),
     m_leveldata(leveldata),
+    m_plan(plan),
     m_mfid(m_amrlevel.level+1),
-    m_init(false)
+    m_ba(plan.m_ba),
+    m_init(false),
+    m_fbox(plan.m_fbox),
+    m_cbox(plan.m_cbox)
 {}
 
 FillPatchIterator::FillPatchIterator (AmrLevel& amrlevel,
@@ -466,28 +606,35 @@ FillPatchIterator::FillPatchIterator (AmrLevel& amrlevel,
     MFIter(leveldata),
     m_amrlevel(amrlevel),
     m_leveldata(leveldata),
+    m_mf(&m_fabs),
+    m_plan(0),
     m_ncomp(0)
 {}
 
-FillPatchIteratorHelper::FillPatchIteratorHelper (AmrLevel&     amrlevel,
-                                                  MultiFab&     leveldata,
-                                                  int           boxGrow,
-                                                  Real          time,
-                                                  int           index,
-                                                  int           scomp,
-                                                  int           ncomp,
-                                                  Interpolater* mapper)
+FillPatchIteratorHelper::FillPatchIteratorHelper (AmrLevel&             amrlevel,
+                                                  MultiFab&             leveldata,
+                                                  FillPatchPlan::Range& plan,
+                                                  int                   boxGrow,
+                                                  Real                  time,
+                                                  int                   index,
+                                                  int                   scomp,
+                                                  int                   ncomp,
+                                                  Interpolater*         mapper)
     :
     MFIter(leveldata),
     m_amrlevel(amrlevel),
     m_leveldata(leveldata),
+    m_plan(plan),
     m_mfid(m_amrlevel.level+1),
+    m_ba(plan.m_ba),
     m_time(time),
     m_growsize(boxGrow),
     m_index(index),
     m_scomp(scomp),
     m_ncomp(ncomp),
-    m_init(false)
+    m_init(false),
+    m_fbox(plan.m_fbox),
+    m_cbox(plan.m_cbox)
 {
     Initialize(boxGrow,time,index,scomp,ncomp,mapper);
 }
@@ -503,6 +650,8 @@ FillPatchIterator::FillPatchIterator (AmrLevel& amrlevel,
     MFIter(leveldata),
     m_amrlevel(amrlevel),
     m_leveldata(leveldata),
+    m_mf(&m_fabs),
+    m_plan(0),
     m_ncomp(ncomp)
 {
     BL_ASSERT(scomp >= 0);
@@ -565,6 +714,56 @@ FillPatchIteratorHelper::Initialize (int           boxGrow,
     {
         amrLevels[l].state[m_index].RegisterData(m_mfcd, m_mfid[l]);
     }
+
+    if (m_plan.m_built)
+    {
+        //
+        // The boxes are known.  Add them in the same order as when the plan
+        // was built so CollectData() can reuse the communication schedule.
+        //
+        typedef std::map<int,Array<Array<Box> > >::const_iterator IntAABoxMapConstIter;
+
+        typedef std::map<int,Array<Array<Array<FillBoxId> > > >::value_type IntAAAFBIDMapValType;
+
+        for (IntAABoxMapConstIter it = m_cbox.begin(), End = m_cbox.end(); it != End; ++it)
+        {
+            IntAAAFBIDMapValType v1(it->first,Array<Array<Array<FillBoxId> > >());
+
+            Array< Array< Array<FillBoxId> > >& TheFBIDs = m_fbid.insert(m_fbid.end(),v1)->second;
+
+            TheFBIDs.resize(m_amrlevel.level+1);
+
+            for (int l = m_amrlevel.level; l >= 0; --l)
+            {
+                StateData&                 theState  = amrLevels[l].state[m_index];
+                const Array<Box>&          CrseBoxes = it->second[l];
+                Array< Array<FillBoxId> >& FBIDs     = TheFBIDs[l];
+
+                FBIDs.resize(CrseBoxes.size());
+
+                for (int i = 0, M = CrseBoxes.size(); i < M; i++)
+                {
+                    theState.InterpAddBox(m_mfcd,
+                                          m_mfid[l],
+                                          0,
+                                          FBIDs[i],
+                                          CrseBoxes[i],
+                                          m_time,
+                                          m_scomp,
+                                          0,
+                                          m_ncomp,
+                                          extrap);
+                }
+            }
+        }
+
+        m_mfcd.CollectData(m_plan.m_schedules);
+
+        m_init = true;
+
+        return;
+    }
+
     for (int i = 0, N = m_leveldata.boxArray().size(); i < N; ++i)
     {
         //
@@ -783,7 +982,9 @@ FillPatchIteratorHelper::Initialize (int           boxGrow,
         }
     }
 
-    m_mfcd.CollectData();
+    m_mfcd.CollectData(m_plan.m_schedules);
+
+    m_plan.m_built = true;
 
     m_init = true;
 }
@@ -804,23 +1005,60 @@ FillPatchIterator::Initialize (int  boxGrow,
     m_ncomp = ncomp;
     m_range = desc.sameInterps(scomp,ncomp);
 
-    BoxArray nba = m_leveldata.boxArray();
+    m_plan = GetFPPlan(m_amrlevel,m_leveldata,boxGrow,index,scomp,ncomp);
+
+    if (m_plan && m_plan->m_ranges.size() != m_range.size())
+    {
+        m_plan->m_ranges.resize(m_range.size());
+    }
+    //
+    // Use the plan's destination MultiFab unless another
+    // FillPatchIterator is holding it.
+    //
+    if (m_plan && !m_plan->m_in_use)
+    {
+        if (m_plan->m_fabs.size() == 0)
+        {
+            BoxArray nba = m_leveldata.boxArray();
+
+            nba.grow(boxGrow);
+
+            m_plan->m_fabs.define(nba,m_ncomp,0,Fab_allocate);
+        }
+
+        m_plan->m_in_use = true;
+
+        m_mf = &m_plan->m_fabs;
+    }
+    else
+    {
+        BoxArray nba = m_leveldata.boxArray();
 
-    nba.grow(boxGrow);
+        nba.grow(boxGrow);
 
-    m_fabs.define(nba,m_ncomp,0,Fab_allocate);
+        m_fabs.define(nba,m_ncomp,0,Fab_allocate);
 
-    BL_ASSERT(m_leveldata.DistributionMap() == m_fabs.DistributionMap());
+        m_mf = &m_fabs;
+    }
+
+    BL_ASSERT(m_leveldata.DistributionMap() == m_mf->DistributionMap());
 
     FillPatchIteratorHelper* fph = 0;
 
+    FillPatchPlan::Range unplanned;
+
     for (int i = 0, DComp = 0; i < m_range.size(); i++)
     {
         const int SComp = m_range[i].first;
         const int NComp = m_range[i].second;
+        //
+        // Without a plan each range builds its boxes from scratch.
+        //
+        if (!m_plan) unplanned = FillPatchPlan::Range();
 
         fph = new FillPatchIteratorHelper(m_amrlevel,
                                           m_leveldata,
+                                          m_plan ? m_plan->m_ranges[i] : unplanned,
                                           boxGrow,
                                           time,
                                           index,
@@ -828,9 +1066,9 @@ FillPatchIterator::Initialize (int  boxGrow,
                                           NComp,
                                           desc.interp(SComp));
 
-        for (MFIter mfi(m_fabs); mfi.isValid(); ++mfi)
+        for (MFIter mfi(*m_mf); mfi.isValid(); ++mfi)
         {
-            fph->fill(m_fabs[mfi],DComp,mfi.index());
+            fph->fill((*m_mf)[mfi],DComp,mfi.index());
         }
 
         DComp += NComp;
@@ -840,7 +1078,7 @@ FillPatchIterator::Initialize (int  boxGrow,
     //
     // Call hack to touch up fillPatched data.
     //
-    m_amrlevel.set_preferred_boundary_values(m_fabs,
+    m_amrlevel.set_preferred_boundary_values(*m_mf,
                                              index,
                                              scomp,
                                              0,
@@ -1238,7 +1476,13 @@ FillPatchIteratorHelper::fill (FArrayBox& fab,
 
 FillPatchIteratorHelper::~FillPatchIteratorHelper () {}
 
-FillPatchIterator::~FillPatchIterator () {}
+FillPatchIterator::~FillPatchIterator ()
+{
+    if (m_plan && m_mf == &m_plan->m_fabs)
+    {
+        m_plan->m_in_use = false;
+    }
+}
 
 void
 AmrLevel::FillCoarsePatch (MultiFab& mf,
@@ -1284,22 +1528,26 @@ AmrLevel::FillCoarsePatch (MultiFab& mf,
         MultiFab crseMF(crseBA,NComp,0,Fab_noallocate);
 
         FillPatchIterator fpi(clev,crseMF,0,time,index,SComp,NComp);
+        //
+        // The filled data may be in the FillPatchIterator's cached plan.
+        //
+        const MultiFab& crse = fpi.get_mf();
 
-        const int N = fpi.m_fabs.IndexMap().size();
+        const int N = crse.IndexMap().size();
 
 #ifdef _OPENMP
 #pragma omp parallel for
 #endif
         for (int i = 0; i < N; i++)
         {
-            const int  idx = fpi.m_fabs.IndexMap()[i];
+            const int  idx = crse.IndexMap()[i];
             const Box& dbx = mf_BA[idx];
 
             Array<BCRec> bcr(ncomp);
 
             BoxLib::setBC(dbx,pdomain,SComp,0,NComp,desc.getBCs(),bcr);
 
-            mapper->interp(fpi.m_fabs[idx],
+            mapper->interp(crse[idx],
                            0,
                            mf[idx],
                            DComp,
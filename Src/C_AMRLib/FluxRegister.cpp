@@ -9,6 +9,7 @@
 #include <ccse-mpi.H>
 
 #include <vector>
+#include <algorithm>
 
 FluxRegister::FluxRegister ()
 {
@@ -167,40 +168,12 @@ FluxRegister::copyTo (FArrayBox& flx,
     hifabs.copyTo(flx,scomp,dcomp,ncomp);
 }
 
-struct Rec
-{
-    Rec (int         dIndex,
-         int         sIndex,
-         Orientation face,
-         FillBoxId   fbid)
-        :
-        m_dIndex(dIndex),
-        m_sIndex(sIndex),
-        m_face(face),
-        m_fbid(fbid) {}
-
-    Rec (const IntVect& shift,
-         int            dIndex,
-         int            sIndex,
-         Orientation    face,
-         FillBoxId      fbid)
-        :
-        m_shift(shift),
-        m_dIndex(dIndex),
-        m_sIndex(sIndex),
-        m_face(face),
-        m_fbid(fbid) {}
-
-    IntVect     m_shift;
-    int         m_dIndex;
-    int         m_sIndex;
-    Orientation m_face;
-    FillBoxId   m_fbid;
-};
-
 static
 void
-RefluxIt (const Rec&       rf,
+RefluxIt (const IntVect&   shift,
+          int              dIndex,
+          int              sIndex,
+          Orientation      face,
           Real             scale,
           const Real*      multf,
           const BoxArray&  grids,
@@ -211,27 +184,27 @@ RefluxIt (const Rec&       rf,
           int              dcomp,
           int              ncomp)
 {
-    BL_ASSERT(S.DistributionMap()[rf.m_dIndex] == ParallelDescriptor::MyProc());
-    BL_ASSERT(volume.DistributionMap()[rf.m_dIndex] == ParallelDescriptor::MyProc());
+    BL_ASSERT(S.DistributionMap()[dIndex] == ParallelDescriptor::MyProc());
+    BL_ASSERT(volume.DistributionMap()[dIndex] == ParallelDescriptor::MyProc());
 
     Real mult;
     if (multf == 0)
-        mult = rf.m_face.isLow() ? -scale : scale;
+        mult = face.isLow() ? -scale : scale;
     else
         mult = (*multf)*scale;
 
-    FArrayBox&       fab_S      = S[rf.m_dIndex];
-    const FArrayBox& fab_volume = volume[rf.m_dIndex];
+    FArrayBox&       fab_S      = S[dIndex];
+    const FArrayBox& fab_volume = volume[dIndex];
     Real*            s_dat      = fab_S.dataPtr(dcomp);
     const int*       slo        = fab_S.loVect();
     const int*       shi        = fab_S.hiVect();
     const Real*      vol_dat    = fab_volume.dataPtr();
-    const Box&       fine_face  = BoxLib::adjCell(grids[rf.m_sIndex],rf.m_face);
-    const Box&       sftbox     = S.box(rf.m_dIndex) + rf.m_shift;
+    const Box&       fine_face  = BoxLib::adjCell(grids[sIndex],face);
+    const Box&       sftbox     = S.box(dIndex) + shift;
     const Box&       ovlp       = sftbox & fine_face;
     const int*       lo         = ovlp.loVect();
     const int*       hi         = ovlp.hiVect();
-    const int*       shft       = rf.m_shift.getVect();
+    const int*       shft       = shift.getVect();
     const int*       vlo        = fab_volume.loVect();
     const int*       vhi        = fab_volume.hiVect();
     const Real*      reg_dat    = reg.dataPtr(scomp);
@@ -244,21 +217,36 @@ RefluxIt (const Rec&       rf,
                   lo,hi,shft,&ncomp,&mult);
 }
 
-void
-FluxRegister::Reflux (MultiFab&       S,
-                      const MultiFab& volume,
-                      Real            scale,
-                      int             src_comp,
-                      int             dest_comp,
-                      int             num_comp, 
-                      const Geometry& geom,
-		      const Real*     multf)
+const FluxRegister::RefluxPlan&
+FluxRegister::TheRefluxPlan (const MultiFab& S,
+                             const Geometry& geom)
 {
-    BL_PROFILE("FluxRegister::Reflux()");
+    IntVect periodic;
+
+    for (int d = 0; d < BL_SPACEDIM; d++)
+        periodic[d] = geom.isPeriodic(d);
+
+    if (m_plan.m_built                             &&
+        BoxArray::SameRefs(m_plan.m_regs, grids)   &&
+        m_plan.m_grids    == S.boxArray()          &&
+        m_plan.m_dmap     == S.DistributionMap()   &&
+        m_plan.m_domain   == geom.Domain()         &&
+        m_plan.m_periodic == periodic)
+    {
+        return m_plan;
+    }
+
+    BL_PROFILE("FluxRegister::TheRefluxPlan()");
+
+    m_plan = RefluxPlan();
 
-    FabSetId                          fsid[2*BL_SPACEDIM];
-    std::vector<Rec>                  Recs;
-    FabSetCopyDescriptor              fscd;
+    m_plan.m_regs     = grids;
+    m_plan.m_grids    = S.boxArray();
+    m_plan.m_dmap     = S.DistributionMap();
+    m_plan.m_domain   = geom.Domain();
+    m_plan.m_periodic = periodic;
+
+    std::vector<Rec>&                 Recs = m_plan.m_recs;
     std::vector< std::pair<int,Box> > isects;
     //
     // We use this to help "find" FluxRegisters with which we may intersect.
@@ -266,9 +254,6 @@ FluxRegister::Reflux (MultiFab&       S,
     //
     BoxArray ba = grids; ba.grow(1);
 
-    for (OrientationIter fi; fi; ++fi)
-        fsid[fi()] = fscd.RegisterFabSet(&bndry[fi()]);
-
     for (MFIter mfi(S); mfi.isValid(); ++mfi)
     {
         const int  idx = mfi.index();
@@ -302,49 +287,59 @@ FluxRegister::Reflux (MultiFab&       S,
 
                     sbx &= bndry[face].box(k);
 
-                    FillBoxId fbid = fscd.AddBox(fsid[face],
-                                                 sbx,
-                                                 0,
-                                                 k,
-                                                 src_comp,
-                                                 0,
-                                                 num_comp);
+                    Rec rf;
+
+                    rf.m_dIndex = idx;
+                    rf.m_sIndex = k;
+                    rf.m_face   = face;
+                    rf.m_sbx    = sbx;
 
-                    Recs.push_back(Rec(idx,k,face,fbid));
+                    Recs.push_back(rf);
                 }
             }
         }
     }
     //
-    // Add periodic possibilities.
+    // Add periodic possibilities.  Rather than trying every register
+    // against every shift of the grid, we look for the registers that
+    // intersect each shift of the grid that touches the grown domain.
+    // They're put in the order we used to find them in, register by
+    // register, so the corrections are applied in the same order.
     //
     if (geom.isAnyPeriodic())
     {
+        const Box       gdomain = BoxLib::grow(geom.Domain(),1);
         Array<IntVect>  pshifts(27);
+        //
+        // (register, which shift, position) of each periodic Rec of a grid.
+        //
+        std::vector< std::pair<std::pair<int,int>,int> > order;
+        std::vector<Rec>                                 precs;
 
         for (MFIter mfi(S); mfi.isValid(); ++mfi)
         {
-            const int  idx  = mfi.index();
-            const Box& vbx  = mfi.validbox();
+            const int  idx = mfi.index();
+            const Box& vbx = mfi.validbox();
 
-            for (int k = 0, N = grids.size(); k < N; k++)
-            {
-                const Box& bx = ba[k];
+            geom.periodicShift(gdomain,vbx,pshifts);
 
-                if (geom.Domain().contains(bx)) continue;
+            order.clear();
+            precs.clear();
 
-                geom.periodicShift(bx,vbx,pshifts);
+            for (int j = 0, M = pshifts.size(); j < M; j++)
+            {
+                const IntVect& iv     = pshifts[j];
+                const Box&     sftbox = vbx + iv;
 
-                const Box& kgrid = grids[k];
+                ba.intersections(sftbox,isects);
 
-                for (Array<IntVect>::const_iterator it = pshifts.begin(), End = pshifts.end();
-                     it != End;
-                     ++it)
+                for (int i = 0, N = isects.size(); i < N; i++)
                 {
-                    const IntVect& iv     = *it;
-                    const Box&     sftbox = vbx + iv;
+                    const int k = isects[i].first;
+
+                    if (geom.Domain().contains(ba[k])) continue;
 
-                    BL_ASSERT(bx.intersects(sftbox));
+                    const Box& kgrid = grids[k];
 
                     for (OrientationIter fi; fi; ++fi)
                     {
@@ -366,42 +361,92 @@ FluxRegister::Reflux (MultiFab&       S,
 
                             sbx &= bndry[face].box(k);
 
-                            FillBoxId fbid = fscd.AddBox(fsid[face],
-                                                         sbx,
-                                                         0,
-                                                         k,
-                                                         src_comp,
-                                                         0,
-                                                         num_comp);
+                            Rec rf;
 
-                            Recs.push_back(Rec(iv,idx,k,face,fbid));
+                            rf.m_shift  = iv;
+                            rf.m_dIndex = idx;
+                            rf.m_sIndex = k;
+                            rf.m_face   = face;
+                            rf.m_sbx    = sbx;
+
+                            order.push_back(std::make_pair(std::make_pair(k,j),int(precs.size())));
+                            precs.push_back(rf);
                         }
                     }
                 }
             }
+
+            std::sort(order.begin(), order.end());
+
+            for (int i = 0, N = order.size(); i < N; i++)
+                Recs.push_back(precs[order[i].second]);
         }
     }
 
     ba.clear_hash_bin();
 
-    fscd.CollectData();
+    m_plan.m_built = true;
+
+    return m_plan;
+}
+
+void
+FluxRegister::Reflux (MultiFab&       S,
+                      const MultiFab& volume,
+                      Real            scale,
+                      int             src_comp,
+                      int             dest_comp,
+                      int             num_comp, 
+                      const Geometry& geom,
+		      const Real*     multf)
+{
+    BL_PROFILE("FluxRegister::Reflux()");
+
+    const RefluxPlan&       plan = TheRefluxPlan(S,geom);
+    const std::vector<Rec>& Recs = plan.m_recs;
+    const int               N    = Recs.size();
+
+    FabSetId               fsid[2*BL_SPACEDIM];
+    FabSetCopyDescriptor   fscd;
+    std::vector<FillBoxId> fbids(N);
+
+    for (OrientationIter fi; fi; ++fi)
+        fsid[fi()] = fscd.RegisterFabSet(&bndry[fi()]);
+
+    for (int i = 0; i < N; i++)
+    {
+        const Rec& rf = Recs[i];
+
+        fbids[i] = fscd.AddBox(fsid[rf.m_face],
+                               rf.m_sbx,
+                               0,
+                               rf.m_sIndex,
+                               src_comp,
+                               0,
+                               num_comp);
+    }
 
-    const int N = Recs.size();
+    fscd.CollectData(m_plan.m_schedules);
+    //
+    // One FAB for the registers, resized as need be.
+    //
+    FArrayBox reg;
 
     for (int i = 0; i < N; i++)
     {
         const Rec&       rf   = Recs[i];
-        const FillBoxId& fbid = rf.m_fbid;
+        const FillBoxId& fbid = fbids[i];
 
         BL_ASSERT(bndry[rf.m_face].box(rf.m_sIndex).contains(fbid.box()));
         BL_ASSERT(S.DistributionMap()[rf.m_dIndex] == ParallelDescriptor::MyProc());
         BL_ASSERT(volume.DistributionMap()[rf.m_dIndex] == ParallelDescriptor::MyProc());
 
-        FArrayBox reg(fbid.box(), num_comp);
+        reg.resize(fbid.box(), num_comp);
 
         fscd.FillFab(fsid[rf.m_face], fbid, reg);
 
-        RefluxIt(rf,scale,multf,grids,S,volume,reg,0,dest_comp,num_comp);
+        RefluxIt(rf.m_shift,rf.m_dIndex,rf.m_sIndex,rf.m_face,
+                 scale,multf,grids,S,volume,reg,0,dest_comp,num_comp);
     }
 }
 
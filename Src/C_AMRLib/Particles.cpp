@@ -1,6 +1,7 @@
 #include <Particles.H>
 #include <ParmParse.H>
 #include <limits>
+#include <set>
 
 void
 ParticleBase::CIC_Cells_Fracs_Basic (const ParticleBase& p,
@@ -468,6 +469,463 @@ ParticleBase::MaxParticlesPerRead ()
     return Max_Particles_Per_Read;
 }
 
+namespace
+{
+    bool Sparse_Redistribute;
+    bool Sparse_Redistribute_Set = false;
+}
+
+bool
+ParticleBase::SparseRedistribute ()
+{
+    if (!Sparse_Redistribute_Set)
+    {
+        Sparse_Redistribute_Set = true;
+
+        ParmParse pp("particles");
+
+        int sparse = 1;
+
+        pp.query("sparse_redistribute", sparse);
+
+        Sparse_Redistribute = sparse;
+    }
+
+    return Sparse_Redistribute;
+}
+
+void
+ParticleBase::SetSparseRedistribute (bool sparse)
+{
+    Sparse_Redistribute_Set = true;
+
+    Sparse_Redistribute = sparse;
+}
+
+namespace
+{
+    //
+    // NeighborProcs() and what it was worked out from.
+    //
+    Array<int>          neighbor_procs;
+    Array<BoxArray>     neighbor_grids;
+    Array< Array<int> > neighbor_pmaps;
+    //
+    // The refinement ratio from level crse to level fine.
+    //
+    IntVect
+    RatioBetween (const Amr* amr,
+                  int        crse,
+                  int        fine)
+    {
+        IntVect ratio = IntVect::TheUnitVector();
+
+        for (int lev = crse; lev < fine; lev++)
+            ratio *= amr->refRatio(lev);
+
+        return ratio;
+    }
+
+#ifdef BL_USE_MPI
+    //
+    // The three ways ExchangeParticles() can move the bytes.  All of them
+    // fill rcv in order of CPU number.
+    //
+    void
+    PostRecvs (const std::map<int,int>& cnts,
+               Array<char>&             rcv,
+               int                      tag,
+               Array<MPI_Request>&      reqs)
+    {
+        long total = 0;
+
+        for (std::map<int,int>::const_iterator it = cnts.begin(), End = cnts.end(); it != End; ++it)
+            total += it->second;
+
+        rcv.resize(total);
+
+        long off = 0;
+
+        for (std::map<int,int>::const_iterator it = cnts.begin(), End = cnts.end(); it != End; ++it)
+        {
+            reqs.push_back(ParallelDescriptor::Arecv(&rcv[off],it->second,it->first,tag).req());
+
+            off += it->second;
+        }
+    }
+
+    void
+    PostSends (std::map<int,Array<char> >& snd,
+               int                         tag,
+               Array<MPI_Request>&         reqs)
+    {
+        for (std::map<int,Array<char> >::iterator it = snd.begin(), End = snd.end(); it != End; ++it)
+        {
+            if (it->second.empty()) continue;
+
+            reqs.push_back(ParallelDescriptor::Asend(it->second.dataPtr(),it->second.size(),it->first,tag).req());
+        }
+    }
+
+    void
+    WaitAll (Array<MPI_Request>& reqs)
+    {
+        if (!reqs.empty())
+            BL_MPI_REQUIRE( MPI_Waitall(reqs.size(), reqs.dataPtr(), MPI_STATUSES_IGNORE) );
+
+        reqs.clear();
+    }
+    //
+    // Every CPU tells every other CPU how much to expect.
+    //
+    void
+    DenseExchange (std::map<int,Array<char> >& snd,
+                   Array<char>&                rcv)
+    {
+        const int NProcs = ParallelDescriptor::NProcs();
+
+        Array<int> Snds(NProcs,0), Rcvs(NProcs,0);
+
+        for (std::map<int,Array<char> >::const_iterator it = snd.begin(), End = snd.end(); it != End; ++it)
+            Snds[it->first] = it->second.size();
+
+        BL_COMM_PROFILE(BLProfiler::Alltoall, sizeof(int),
+                        ParallelDescriptor::MyProc(), BLProfiler::BeforeCall());
+
+        BL_MPI_REQUIRE( MPI_Alltoall(Snds.dataPtr(),
+                                     1,
+                                     ParallelDescriptor::Mpi_typemap<int>::type(),
+                                     Rcvs.dataPtr(),
+                                     1,
+                                     ParallelDescriptor::Mpi_typemap<int>::type(),
+                                     ParallelDescriptor::Communicator()) );
+
+        BL_COMM_PROFILE(BLProfiler::Alltoall, sizeof(int),
+                        ParallelDescriptor::MyProc(), BLProfiler::AfterCall());
+
+        std::map<int,int> cnts;
+
+        for (int i = 0; i < NProcs; i++)
+            if (Rcvs[i] > 0)
+                cnts[i] = Rcvs[i];
+
+        const int SeqNum = ParallelDescriptor::SeqNum();
+
+        Array<MPI_Request> reqs;
+
+        PostRecvs(cnts, rcv, SeqNum, reqs);
+        PostSends(snd, SeqNum, reqs);
+        WaitAll(reqs);
+    }
+    //
+    // Only neighbors talk to one another.  As neighbors are mutual each
+    // CPU knows whom to expect a count from, even if it's zero.
+    //
+    void
+    NeighborExchange (std::map<int,Array<char> >& snd,
+                      const Array<int>&           nbrs,
+                      Array<char>&                rcv)
+    {
+        const int NN = nbrs.size();
+
+        Array<int> Snds(NN,0), Rcvs(NN,0);
+
+        for (int i = 0; i < NN; i++)
+        {
+            std::map<int,Array<char> >::const_iterator it = snd.find(nbrs[i]);
+
+            if (it != snd.end())
+                Snds[i] = it->second.size();
+        }
+
+        const int CntSeqNum = ParallelDescriptor::SeqNum();
+
+        Array<MPI_Request> reqs;
+
+        for (int i = 0; i < NN; i++)
+            reqs.push_back(ParallelDescriptor::Arecv(&Rcvs[i],1,nbrs[i],CntSeqNum).req());
+
+        for (int i = 0; i < NN; i++)
+            reqs.push_back(ParallelDescriptor::Asend(&Snds[i],1,nbrs[i],CntSeqNum).req());
+
+        WaitAll(reqs);
+
+        std::map<int,int> cnts;
+
+        for (int i = 0; i < NN; i++)
+            if (Rcvs[i] > 0)
+                cnts[nbrs[i]] = Rcvs[i];
+
+        const int SeqNum = ParallelDescriptor::SeqNum();
+
+        PostRecvs(cnts, rcv, SeqNum, reqs);
+        PostSends(snd, SeqNum, reqs);
+        WaitAll(reqs);
+    }
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    //
+    // The "non-blocking consensus" exchange.  We send with synchronous
+    // sends and take whatever arrives.  Once all our sends have been
+    // matched we enter a non-blocking barrier; once everyone's in it all
+    // the messages have been received and we're done.
+    //
+    void
+    DynamicExchange (std::map<int,Array<char> >& snd,
+                     Array<char>&                rcv)
+    {
+        const int      SeqNum = ParallelDescriptor::SeqNum();
+        const MPI_Comm Comm   = ParallelDescriptor::Communicator();
+
+        Array<MPI_Request> sreqs;
+
+        for (std::map<int,Array<char> >::iterator it = snd.begin(), End = snd.end(); it != End; ++it)
+        {
+            if (it->second.empty()) continue;
+
+            MPI_Request req;
+
+            BL_MPI_REQUIRE( MPI_Issend(it->second.dataPtr(),
+                                       it->second.size(),
+                                       MPI_CHAR,
+                                       it->first,
+                                       SeqNum,
+                                       Comm,
+                                       &req) );
+            sreqs.push_back(req);
+        }
+
+        std::map<int,Array<char> > got;
+
+        MPI_Request barrier    = MPI_REQUEST_NULL;
+        bool        in_barrier = false;
+
+        for (int done = 0; !done; )
+        {
+            int        flag;
+            MPI_Status status;
+
+            BL_MPI_REQUIRE( MPI_Iprobe(MPI_ANY_SOURCE, SeqNum, Comm, &flag, &status) );
+
+            if (flag)
+            {
+                int cnt;
+
+                BL_MPI_REQUIRE( MPI_Get_count(&status, MPI_CHAR, &cnt) );
+
+                Array<char>& buf = got[status.MPI_SOURCE];
+
+                buf.resize(cnt);
+
+                BL_MPI_REQUIRE( MPI_Recv(buf.dataPtr(),
+                                         cnt,
+                                         MPI_CHAR,
+                                         status.MPI_SOURCE,
+                                         SeqNum,
+                                         Comm,
+                                         MPI_STATUS_IGNORE) );
+            }
+
+            if (in_barrier)
+            {
+                BL_MPI_REQUIRE( MPI_Test(&barrier, &done, MPI_STATUS_IGNORE) );
+            }
+            else
+            {
+                int sent = 1;
+
+                if (!sreqs.empty())
+                    BL_MPI_REQUIRE( MPI_Testall(sreqs.size(), sreqs.dataPtr(), &sent, MPI_STATUSES_IGNORE) );
+
+                if (sent)
+                {
+                    BL_MPI_REQUIRE( MPI_Ibarrier(Comm, &barrier) );
+
+                    in_barrier = true;
+                }
+            }
+        }
+
+        long total = 0;
+
+        for (std::map<int,Array<char> >::const_iterator it = got.begin(), End = got.end(); it != End; ++it)
+            total += it->second.size();
+
+        rcv.resize(total);
+
+        long off = 0;
+
+        for (std::map<int,Array<char> >::const_iterator it = got.begin(), End = got.end(); it != End; ++it)
+        {
+            std::copy(it->second.begin(), it->second.end(), rcv.begin() + off);
+
+            off += it->second.size();
+        }
+    }
+#endif
+#endif /*BL_USE_MPI*/
+}
+
+const Array<int>&
+ParticleBase::NeighborProcs (Amr* amr,
+                             int  finest_level)
+{
+    bool same = (neighbor_grids.size() == finest_level+1);
+
+    for (int lev = 0; same && lev <= finest_level; lev++)
+    {
+        same = BoxArray::SameRefs(neighbor_grids[lev], amr->ParticleBoxArray(lev)) &&
+               neighbor_pmaps[lev] == amr->getLevel(lev).ParticleDistributionMap().ProcessorMap();
+    }
+
+    if (same) return neighbor_procs;
+
+    neighbor_grids.resize(finest_level+1);
+    neighbor_pmaps.resize(finest_level+1);
+
+    for (int lev = 0; lev <= finest_level; lev++)
+    {
+        neighbor_grids[lev] = amr->ParticleBoxArray(lev);
+        neighbor_pmaps[lev] = amr->getLevel(lev).ParticleDistributionMap().ProcessorMap();
+    }
+
+    neighbor_procs = NeighborProcs(amr, finest_level, neighbor_pmaps, ParallelDescriptor::MyProc());
+
+    return neighbor_procs;
+}
+
+Array<int>
+ParticleBase::NeighborProcs (Amr*                       amr,
+                             int                        finest_level,
+                             const Array< Array<int> >& pmaps,
+                             int                        proc)
+{
+    BL_ASSERT(pmaps.size() > finest_level);
+    //
+    // Two grids are neighbors if, at the finer of their levels, they're
+    // no more than a cell of the coarser level apart.  That's symmetric,
+    // so whatever side works it out gets the same answer.
+    //
+    std::set<int>                     procs;
+    std::vector< std::pair<int,Box> > isects;
+    Array<IntVect>                    pshifts;
+
+    for (int la = 0; la <= finest_level; la++)
+    {
+        const BoxArray&   ba = amr->ParticleBoxArray(la);
+        const Array<int>& pa = pmaps[la];
+
+        for (int i = 0, N = ba.size(); i < N; i++)
+        {
+            if (pa[i] != proc) continue;
+
+            for (int lb = 0; lb <= finest_level; lb++)
+            {
+                const int       L  = std::max(la,lb);
+                const Geometry& gm = amr->Geom(L);
+
+                Box bx = BoxLib::refine(ba[i], RatioBetween(amr,la,L));
+
+                bx.grow(RatioBetween(amr,std::min(la,lb),L));
+
+                std::vector<Box> images(1,bx);
+
+                if (gm.isAnyPeriodic())
+                {
+                    gm.periodicShift(gm.Domain(), bx, pshifts);
+
+                    for (int k = 0; k < pshifts.size(); k++)
+                        images.push_back(bx + pshifts[k]);
+                }
+
+                const IntVect ratio = RatioBetween(amr,lb,L);
+
+                for (int k = 0; k < images.size(); k++)
+                {
+                    amr->ParticleBoxArray(lb).intersections(BoxLib::coarsen(images[k],ratio), isects);
+
+                    for (int j = 0, M = isects.size(); j < M; j++)
+                    {
+                        const int who = pmaps[lb][isects[j].first];
+
+                        if (who != proc)
+                            procs.insert(who);
+                    }
+                }
+            }
+        }
+    }
+
+    Array<int> result;
+
+    result.assign(procs.begin(), procs.end());
+
+    return result;
+}
+
+void
+ParticleBase::ExchangeParticles (Amr*                        amr,
+                                 int                         finest_level,
+                                 std::map<int,Array<char> >& snd,
+                                 Array<char>&                rcv)
+{
+    BL_PROFILE("ParticleBase::ExchangeParticles()");
+
+    rcv.clear();
+
+#ifdef BL_USE_MPI
+    if (ParallelDescriptor::NProcs() == 1) return;
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    const bool sparse = ParticleBase::SparseRedistribute();
+#else
+    const bool sparse = false;
+#endif
+    const Array<int>* nbrs = sparse ? &ParticleBase::NeighborProcs(amr,finest_level) : 0;
+    //
+    // flags[0]: does anyone have anything to send?
+    // flags[1]: does anyone have anything for a CPU that isn't a neighbor?
+    //
+    int flags[2] = { 0, 0 };
+
+    for (std::map<int,Array<char> >::const_iterator it = snd.begin(), End = snd.end(); it != End; ++it)
+    {
+        if (it->second.empty()) continue;
+
+        if (it->second.size() > std::size_t(std::numeric_limits<int>::max()))
+            BoxLib::Abort("ParticleBase::ExchangeParticles(): too many particles for one CPU");
+
+        flags[0] = 1;
+
+        if (sparse && !std::binary_search(nbrs->begin(), nbrs->end(), it->first))
+            flags[1] = 1;
+    }
+
+    ParallelDescriptor::ReduceIntMax(flags, 2);
+
+    if (flags[0] == 0)
+        //
+        // There's no parallel work to do.
+        //
+        return;
+
+    if (!sparse)
+    {
+        DenseExchange(snd, rcv);
+    }
+    else if (flags[1] == 0)
+    {
+        NeighborExchange(snd, *nbrs, rcv);
+    }
+    else
+    {
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+        DynamicExchange(snd, rcv);
+#endif
+    }
+#endif /*BL_USE_MPI*/
+}
+
 const std::string&
 ParticleBase::DataPrefix ()
 {
@@ -584,6 +1042,205 @@ ParticleBase::Where (ParticleBase& p,
     return false;
 }
 
+namespace
+{
+    //
+    // Which particle grid at a level covers each block of ratio cells.
+    // The blocks tile the smallest box holding the grids and are no
+    // more than MaxBlocks in number.  A block's entry is the grid that
+    // covers all of it, -1 if no grid touches it, or -2 if it's only
+    // partly covered, in which case we have to ask the BoxArray.  Grids
+    // respect the blocking factor, so -2 is rare.
+    //
+    const long MaxBlocks = 1L << 21;
+
+    struct GridTable
+    {
+        BoxArray   grids;
+        Box        blocks;
+        IntVect    ratio;
+        IntVect    lo;
+        Array<int> grid;
+
+        void build (const BoxArray& ba)
+        {
+            grids = ba;
+
+            grid.clear();
+
+            if (ba.size() == 0)
+            {
+                blocks = Box();
+                return;
+            }
+
+            const Box bx = ba.minimalBox();
+
+            ratio = IntVect::TheUnitVector();
+
+            while (BoxLib::coarsen(bx,ratio).numPts() > MaxBlocks)
+                ratio *= 2;
+
+            blocks = BoxLib::coarsen(bx,ratio);
+            lo     = BoxLib::refine(blocks,ratio).smallEnd();
+
+            grid.resize(blocks.numPts(),-1);
+
+            for (int j = 0, N = ba.size(); j < N; j++)
+            {
+                const Box& gbx = ba[j];
+                const Box  cbx = BoxLib::coarsen(gbx,ratio);
+
+                for (IntVect iv = cbx.smallEnd(); iv <= cbx.bigEnd(); cbx.next(iv))
+                {
+                    int& g = grid[blocks.index(iv)];
+
+                    const Box b(iv*ratio, iv*ratio + ratio - 1);
+
+                    g = (g == -1 && gbx.contains(b)) ? j : -2;
+                }
+            }
+        }
+
+        int find (const IntVect& iv) const
+        {
+            if (grid.empty()) return -1;
+
+            int k = 0;
+
+            for (int d = BL_SPACEDIM-1; d >= 0; d--)
+            {
+                const int off = iv[d] - lo[d];
+
+                if (off < 0) return -1;
+
+                const int b = off / ratio[d];
+
+                if (b >= blocks.length(d)) return -1;
+
+                k = k*blocks.length(d) + b;
+            }
+
+            const int g = grid[k];
+
+            if (g != -2) return g;
+
+            std::vector< std::pair<int,Box> > isects;
+
+            grids.intersections(Box(iv,iv),isects,true);
+
+            return isects.empty() ? -1 : isects[0].first;
+        }
+    };
+
+    Array<GridTable> grid_tables;
+
+    const GridTable&
+    TheGridTable (const Amr* amr,
+                  int        lev)
+    {
+        if (grid_tables.size() <= lev)
+            grid_tables.resize(lev+1);
+
+        GridTable& t = grid_tables[lev];
+
+        if (!BoxArray::SameRefs(t.grids, amr->ParticleBoxArray(lev)))
+            t.build(amr->ParticleBoxArray(lev));
+
+        return t;
+    }
+}
+
+void
+ParticleBase::Where (const std::vector<ParticleBase*>& prts,
+                     const Amr*                        amr,
+                     Array<int>&                       found,
+                     int                               lev_min,
+                     int                               finest_level)
+{
+    BL_PROFILE("ParticleBase::Where(batch)");
+
+    BL_ASSERT(amr != 0);
+
+    if (finest_level == -1)
+        finest_level = amr->finestLevel();
+
+    BL_ASSERT(finest_level <= amr->finestLevel());
+
+    const int n = prts.size();
+
+    found.resize(n);
+
+    for (int i = 0; i < n; i++)
+        found[i] = 0;
+
+    if (n == 0) return;
+
+    Array<const GridTable*> tables(finest_level+1,0);
+    //
+    // Size the cache first so the pointers into it stay good.
+    //
+    if (grid_tables.size() <= finest_level)
+        grid_tables.resize(finest_level+1);
+
+    for (int lev = lev_min; lev <= finest_level; lev++)
+        tables[lev] = &TheGridTable(amr,lev);
+    //
+    // The positions, a dimension at a time, so the cells vectorize.
+    //
+    Array<RealType> pos(BL_SPACEDIM*n);
+    Array<int>      cell(BL_SPACEDIM*n);
+
+    for (int i = 0; i < n; i++)
+        for (int d = 0; d < BL_SPACEDIM; d++)
+            pos[d*n+i] = prts[i]->m_pos[d];
+
+    for (int lev = finest_level; lev >= lev_min; lev--)
+    {
+        const Geometry&  geom  = amr->Geom(lev);
+        const GridTable& table = *tables[lev];
+
+        if (table.grid.empty()) continue;
+
+        for (int d = 0; d < BL_SPACEDIM; d++)
+        {
+            const RealType* x     = &pos[d*n];
+            int*            c     = &cell[d*n];
+            const Real      plo   = geom.ProbLo(d);
+            const Real      dx    = geom.CellSize(d);
+            const int       dlo   = geom.Domain().smallEnd(d);
+            //
+            // The same arithmetic as Index().
+            //
+            for (int i = 0; i < n; i++)
+                c[i] = int(floor((x[i]-plo)/dx)) + dlo;
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < n; i++)
+        {
+            if (found[i]) continue;
+
+            const IntVect iv(D_DECL(cell[i],cell[n+i],cell[2*n+i]));
+
+            const int g = table.find(iv);
+
+            if (g >= 0)
+            {
+                ParticleBase& p = *prts[i];
+
+                p.m_lev  = lev;
+                p.m_grid = g;
+                p.m_cell = iv;
+
+                found[i] = 1;
+            }
+        }
+    }
+}
+
 bool
 ParticleBase::PeriodicWhere (ParticleBase& p,
                              const Amr*    amr,
@@ -882,3 +1539,62 @@ operator<< (std::ostream& os, const ParticleBase& p)
 }
 
 ParticleContainerBase::~ParticleContainerBase () {}
+
+bool
+ParticleContainerBase::OK (bool full_where,
+                           int  lev_min,
+                           int  ngrow,
+                           int  finest_level) const
+{
+    BoxLib::Error("ParticleContainerBase::OK() not implemented");
+    return false;
+}
+
+long
+ParticleContainerBase::NumberOfParticlesAtLevel (int  level,
+                                                 bool only_valid,
+                                                 bool only_local) const
+{
+    BoxLib::Error("ParticleContainerBase::NumberOfParticlesAtLevel() not implemented");
+    return 0;
+}
+
+long
+ParticleContainerBase::TotalNumberOfParticles (bool only_valid,
+                                               bool only_local) const
+{
+    BoxLib::Error("ParticleContainerBase::TotalNumberOfParticles() not implemented");
+    return 0;
+}
+
+void
+ParticleContainerBase::AdvectWithUmac (MultiFab* umac,
+                                       int       level,
+                                       Real      dt,
+                                       const int vcomp)
+{
+    BoxLib::Error("ParticleContainerBase::AdvectWithUmac() not implemented");
+}
+
+void
+ParticleContainerBase::Checkpoint (const std::string& dir,
+                                   const std::string& name,
+                                   bool               is_checkpoint) const
+{
+    BoxLib::Error("ParticleContainerBase::Checkpoint() not implemented");
+}
+
+void
+ParticleContainerBase::Restart (const std::string& dir,
+                                const std::string& file,
+                                bool               is_checkpoint)
+{
+    BoxLib::Error("ParticleContainerBase::Restart() not implemented");
+}
+
+void
+ParticleContainerBase::WritePlotFile (const std::string& dir,
+                                      const std::string& name) const
+{
+    BoxLib::Error("ParticleContainerBase::WritePlotFile() not implemented");
+}
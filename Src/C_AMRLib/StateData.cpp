@@ -7,6 +7,7 @@
 #include <StateData.H>
 #include <StateDescriptor.H>
 #include <ParallelDescriptor.H>
+#include <MemProfiler.H>
 
 const Real INVALID_TIME = -1.0e200;
 
@@ -67,6 +68,8 @@ StateData::define (const Box&             p_domain,
     }
     int ncomp = desc->nComp();
 
+    MemProfiler::TagScope mts(MemProfiler::State);
+
     new_data = new MultiFab(grids,ncomp,desc->nExtra(),Fab_allocate);
 
     old_data = 0;
@@ -108,6 +111,8 @@ StateData::define (const Box&             p_domain,
     }
     int ncomp = desc->nComp();
 
+    MemProfiler::TagScope mts(MemProfiler::State);
+
     new_data = new MultiFab(grids,ncomp,desc->nExtra(),dm,Fab_allocate);
 
     old_data = 0;
@@ -157,6 +162,8 @@ StateData::restart (std::istream&          is,
 
     old_data = 0;
     new_data = 0;
+
+    MemProfiler::TagScope mts(MemProfiler::State);
     //
     // If no data is written then we just allocate the MF instead of reading it in. 
     // This assumes that the application will do something with it.
@@ -218,6 +225,8 @@ StateData::allocOldData ()
 {
     if (old_data == 0)
     {
+        MemProfiler::TagScope mts(MemProfiler::State);
+
         old_data = new MultiFab(grids,desc->nComp(),desc->nExtra());
     }
 }
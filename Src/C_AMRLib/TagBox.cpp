@@ -257,6 +257,42 @@ TagBox::collate (IntVect* ar,
     return count;
 }
 
+int
+TagBox::collate (std::vector<IntVect>& ar,
+                 const Box&            bx) const
+{
+    const Box region = bx & domain;
+
+    if (!region.ok()) return 0;
+
+    int count        = 0;
+    IntVect d_length = domain.size();
+    const int* len   = d_length.getVect();
+    const int* dlo   = domain.loVect();
+    const int* lo    = region.loVect();
+    const int* hi    = region.hiVect();
+    const TagType* d = dataPtr();
+    int klo = 0, khi = 0, jlo = 0, jhi = 0;
+    D_TERM(, jlo = lo[1]-dlo[1]; jhi = hi[1]-dlo[1]; , klo = lo[2]-dlo[2]; khi = hi[2]-dlo[2];)
+
+    for (int k = klo; k <= khi; k++)
+    {
+        for (int j = jlo; j <= jhi; j++)
+        {
+            for (int i = lo[0]-dlo[0]; i <= hi[0]-dlo[0]; i++)
+            {
+                const TagType* dn = d + D_TERM(i, +j*len[0], +k*len[0]*len[1]);
+                if (*dn != TagBox::CLEAR)
+                {
+                    ar.push_back(IntVect(D_DECL(dlo[0]+i,dlo[1]+j,dlo[2]+k)));
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
 Array<int>
 TagBox::tags () const
 {
@@ -580,7 +616,8 @@ TagBoxArray::collate (long& numtags) const
     //
     // This holds all tags after they've been gather'd and unique'ified.
     //
-    // Each CPU needs an identical copy since they all must go through grid_places() which isn't parallelized.
+    // Each CPU needs an identical copy since they all go through the serial clustering in grid_places().
+    // See the other collate() for the distributed alternative used with amr.cluster_in_parallel.
     //
     // The caller of collate() is responsible for delete[]ing this space.
     //
@@ -678,6 +715,137 @@ TagBoxArray::collate (long& numtags) const
     return TheGlobalCollateSpace;
 }
 
+void
+TagBoxArray::collate (const BoxArray&                        parts,
+                      std::map< int,std::vector<IntVect> >& ptags) const
+{
+    BL_PROFILE("TagBoxArray::collate(parts)");
+
+    ptags.clear();
+
+    const int NProcs = ParallelDescriptor::NProcs();
+    const int MyProc = ParallelDescriptor::MyProc();
+    //
+    // Bin our tags by the CPU owning the part they're in.
+    //
+    Array< std::vector<IntVect> > snd(NProcs);
+
+    std::vector< std::pair<int,Box> > isects;
+
+    for (MFIter fai(*this); fai.isValid(); ++fai)
+    {
+        //
+        // Search the whole TagBox, as collate() does, buffer cells and
+        // all, rather than counting on validbox() to cover it.
+        //
+        parts.intersections(get(fai).box(),isects);
+
+        for (int i = 0, N = isects.size(); i < N; i++)
+        {
+            get(fai).collate(snd[isects[i].first % NProcs], isects[i].second);
+        }
+    }
+
+    parts.clear_hash_bin();
+    //
+    // Remove duplicate IntVects from the overlapping TagBoxes.
+    //
+    for (int i = 0; i < NProcs; i++)
+    {
+        std::sort(snd[i].begin(), snd[i].end(), IntVect::Compare());
+        snd[i].erase(std::unique(snd[i].begin(), snd[i].end()), snd[i].end());
+    }
+
+    std::vector<IntVect> rcv;
+
+#if BL_USE_MPI
+    BL_ASSERT(sizeof(IntVect) == BL_SPACEDIM * sizeof(int));
+
+    Array<int> sndcnt(NProcs,0), sndoff(NProcs,0), rcvcnt(NProcs,0), rcvoff(NProcs,0);
+
+    for (int i = 0; i < NProcs; i++)
+        sndcnt[i] = snd[i].size() * BL_SPACEDIM;
+
+    BL_COMM_PROFILE(BLProfiler::Alltoall, sizeof(int), MyProc, BLProfiler::BeforeCall());
+
+    BL_MPI_REQUIRE( MPI_Alltoall(sndcnt.dataPtr(),
+                                 1,
+                                 ParallelDescriptor::Mpi_typemap<int>::type(),
+                                 rcvcnt.dataPtr(),
+                                 1,
+                                 ParallelDescriptor::Mpi_typemap<int>::type(),
+                                 ParallelDescriptor::Communicator()) );
+
+    BL_COMM_PROFILE(BLProfiler::Alltoall, sizeof(int), MyProc, BLProfiler::AfterCall());
+
+    for (int i = 1; i < NProcs; i++)
+    {
+        sndoff[i] = sndoff[i-1] + sndcnt[i-1];
+        rcvoff[i] = rcvoff[i-1] + rcvcnt[i-1];
+    }
+
+    const int nsnd = (sndoff[NProcs-1] + sndcnt[NProcs-1]) / BL_SPACEDIM;
+    const int nrcv = (rcvoff[NProcs-1] + rcvcnt[NProcs-1]) / BL_SPACEDIM;
+
+    std::vector<IntVect> sndbuf;
+
+    sndbuf.reserve(nsnd);
+
+    for (int i = 0; i < NProcs; i++)
+    {
+        sndbuf.insert(sndbuf.end(), snd[i].begin(), snd[i].end());
+        std::vector<IntVect>().swap(snd[i]);
+    }
+
+    rcv.resize(nrcv);
+
+    BL_COMM_PROFILE(BLProfiler::Alltoallv, nrcv * sizeof(IntVect), MyProc, BLProfiler::BeforeCall());
+
+    BL_MPI_REQUIRE( MPI_Alltoallv(nsnd == 0 ? 0 : reinterpret_cast<int*>(&sndbuf[0]),
+                                  sndcnt.dataPtr(),
+                                  sndoff.dataPtr(),
+                                  ParallelDescriptor::Mpi_typemap<int>::type(),
+                                  nrcv == 0 ? 0 : reinterpret_cast<int*>(&rcv[0]),
+                                  rcvcnt.dataPtr(),
+                                  rcvoff.dataPtr(),
+                                  ParallelDescriptor::Mpi_typemap<int>::type(),
+                                  ParallelDescriptor::Communicator()) );
+
+    BL_COMM_PROFILE(BLProfiler::Alltoallv, nrcv * sizeof(IntVect), MyProc, BLProfiler::AfterCall());
+#else
+    rcv.swap(snd[0]);
+#endif
+    //
+    // Sort what we got into the parts we own, removing yet more duplicates.
+    //
+    std::vector<IntVect>::iterator beg = rcv.begin();
+
+    for (int i = MyProc, N = parts.size(); i < N && beg != rcv.end(); i += NProcs)
+    {
+        const Box& bx = parts[i];
+
+        std::vector<IntVect>::iterator end = beg;
+
+        for (std::vector<IntVect>::iterator it = beg; it != rcv.end(); ++it)
+        {
+            if (bx.contains(*it))
+                std::iter_swap(it, end++);
+        }
+
+        if (end != beg)
+        {
+            std::vector<IntVect>& v = ptags[i];
+
+            v.assign(beg,end);
+
+            std::sort(v.begin(), v.end(), IntVect::Compare());
+            v.erase(std::unique(v.begin(), v.end()), v.end());
+        }
+
+        beg = end;
+    }
+}
+
 void
 TagBoxArray::setVal (const BoxList& bl,
                      TagBox::TagVal val)
@@ -4,6 +4,8 @@
 
 Arena::~Arena () {}
 
+const std::size_t Arena::DataAlignment;
+
 std::size_t
 Arena::align (std::size_t s)
 {
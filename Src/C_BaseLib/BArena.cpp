@@ -1,15 +1,31 @@
 
+#include <cstdlib>
+
 #include <BArena.H>
 #include <BoxLib.H>
+#include <Utility.H>
 
 void*
 BArena::alloc (std::size_t _sz)
 {
+#ifdef WIN32
     return ::operator new(_sz);
+#else
+    void* pt = 0;
+
+    if (posix_memalign(&pt, Arena::DataAlignment, _sz == 0 ? 1 : _sz) != 0)
+        BoxLib::OutOfMemory();
+
+    return pt;
+#endif
 }
 
 void
 BArena::free (void* pt)
 {
+#ifdef WIN32
     ::operator delete(pt);
+#else
+    std::free(pt);
+#endif
 }
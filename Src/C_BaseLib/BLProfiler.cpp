@@ -5,6 +5,7 @@
 #include <Utility.H>
 #include <ParallelDescriptor.H>
 #include <Array.H>
+#include <MemProfiler.H>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -678,6 +679,21 @@ void BLProfiler::Finalize() {
 
     ParallelDescriptor::Barrier("BLProfiler::Finalize");
   }
+
+  // --------------------------------------- write the per-step memory stats
+  if( ! blProfDirCreated) {
+    BoxLib::UtilCreateCleanDirectory(blProfDirName);
+    blProfDirCreated = true;
+  }
+  if(ParallelDescriptor::IOProcessor()) {
+    std::string msFileName(blProfDirName + "/bl_mem_stats");
+    std::ofstream msFile(msFileName.c_str(), std::ios::out | std::ios::trunc);
+    if( ! msFile.good()) {
+      BoxLib::FileOpenFailed(msFileName);
+    }
+    MemProfiler::WriteStats(msFile);
+  }
+
   if(ParallelDescriptor::IOProcessor()) {
     std::cout << "BLProfiler::Finalize():  time:  "   // time the timer
               << ParallelDescriptor::second() - finalizeStart << std::endl;
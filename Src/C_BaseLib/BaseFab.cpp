@@ -2,20 +2,19 @@
 #include <winstd.H>
 
 #include <cstring>
+#include <iostream>
 #include <cstdlib>
 
 #include <BaseFab.H>
 #include <BArena.H>
 #include <CArena.H>
+#include <TArena.H>
+#include <ParmParse.H>
+#include <ParallelDescriptor.H>
 #if !(defined(BL_NO_FORT) || defined(WIN32))
 #include <SPECIALIZE_F.H>
 #endif
 
-long BoxLib::private_total_bytes_allocated_in_fabs     = 0;
-long BoxLib::private_total_bytes_allocated_in_fabs_hwm = 0;
-long BoxLib::private_total_cells_allocated_in_fabs     = 0;
-long BoxLib::private_total_cells_allocated_in_fabs_hwm = 0;
-
 int BoxLib::BF_init::m_cnt = 0;
 
 namespace
@@ -34,16 +33,6 @@ BoxLib::BF_init::BF_init ()
 #else
         the_arena = new BArena;
 #endif
-
-#ifdef _OPENMP
-#pragma omp parallel
-	{
-	    BoxLib::private_total_bytes_allocated_in_fabs     = 0;
-	    BoxLib::private_total_bytes_allocated_in_fabs_hwm = 0;
-	    BoxLib::private_total_cells_allocated_in_fabs     = 0;
-	    BoxLib::private_total_cells_allocated_in_fabs_hwm = 0;
-	}
-#endif
     }
 }
 
@@ -56,134 +45,128 @@ BoxLib::BF_init::~BF_init ()
 long 
 BoxLib::TotalBytesAllocatedInFabs()
 {
-#ifdef _OPENMP
-    long r=0;
-#pragma omp parallel reduction(+:r)
-    {
-	r += private_total_bytes_allocated_in_fabs;
-    }
-    return r;
-#else
-    return private_total_bytes_allocated_in_fabs;
-#endif
+    return MemProfiler::FabBytes();
 }
 
 long 
 BoxLib::TotalBytesAllocatedInFabsHWM()
 {
-#ifdef _OPENMP
-    long r=0;
-#pragma omp parallel reduction(+:r)
-    {
-	r += private_total_bytes_allocated_in_fabs_hwm;
-    }
-    return r;
-#else
-    return private_total_bytes_allocated_in_fabs_hwm;
-#endif
+    return MemProfiler::FabBytesHWM();
 }
 
 long 
 BoxLib::TotalCellsAllocatedInFabs()
 {
-#ifdef _OPENMP
-    long r=0;
-#pragma omp parallel reduction(+:r)
-    {
-	r += private_total_cells_allocated_in_fabs;
-    }
-    return r;
-#else
-    return private_total_cells_allocated_in_fabs;
-#endif
+    return MemProfiler::FabCells();
 }
 
 long 
 BoxLib::TotalCellsAllocatedInFabsHWM()
 {
-#ifdef _OPENMP
-    long r=0;
-#pragma omp parallel reduction(+:r)
-    {
-	r += private_total_cells_allocated_in_fabs_hwm;
-    }
-    return r;
-#else
-    return private_total_cells_allocated_in_fabs_hwm;
-#endif
+    return MemProfiler::FabCellsHWM();
 }
 
 void 
 BoxLib::ResetTotalBytesAllocatedInFabsHWM()
 {
-#ifdef _OPENMP
-#pragma omp parallel
-#endif
-    {
-	private_total_bytes_allocated_in_fabs_hwm = 0;
-    }
+    MemProfiler::ResetHWM();
 }
 
-Arena*
-BoxLib::The_Arena ()
+namespace
 {
-    BL_ASSERT(the_arena != 0);
+    void
+    ReportArenaUsage ()
+    {
+        const TArena* arena = dynamic_cast<const TArena*>(the_arena);
 
-    return the_arena;
+        if (arena == 0) return;
+
+        long heap = arena->heap_space_used();
+
+        ParallelDescriptor::ReduceLongMax(heap,ParallelDescriptor::IOProcessorNumber());
+
+        if (ParallelDescriptor::IOProcessor())
+        {
+            std::cout << "TArena: max heap space used: " << heap
+                      << ", hit rate (IOProc): "        << arena->hit_rate()
+                      << ", thread hit rate (IOProc): " << arena->thread_hit_rate()
+                      << ", fragmentation (IOProc): "   << arena->fragmentation()
+                      << '\n';
+        }
+    }
 }
 
-#if !(defined(BL_NO_FORT) || defined(WIN32))
-template<>
 void
-BaseFab<Real>::performCopy (const BaseFab<Real>& src,
-                            const Box&           srcbox,
-                            int                  srccomp,
-                            const Box&           destbox,
-                            int                  destcomp,
-                            int                  numcomp)
+BoxLib::InitializeArena ()
 {
-    BL_ASSERT(destbox.ok());
-    BL_ASSERT(src.box().contains(srcbox));
-    BL_ASSERT(box().contains(destbox));
-    BL_ASSERT(destbox.sameSize(srcbox));
-    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
-    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
-
-    if (destbox == domain && srcbox == src.box())
+    ParmParse pp("arena");
+
+    std::string type;
+
+    if (!pp.query("type", type)) return;
+
+    Arena* arena = 0;
+
+    if (type == "BArena")
+    {
+        arena = new BArena;
+    }
+    else if (type == "CArena")
+    {
+        arena = new CArena;
+    }
+    else if (type == "TArena")
     {
-        Real*       data_dst = dataPtr(destcomp);
-        const Real* data_src = src.dataPtr(srccomp);
+        int  thread_cache_size = TArena::DefaultThreadCacheSize;
+        int  max_cached_size   = TArena::DefaultMaxCachedSize;
+        bool use_huge_pages    = false;
+        int  huge_page_size    = TArena::DefaultHugePageSize;
 
-        for (long i = 0, N = numcomp*numpts; i < N; i++)
-        {
-            *data_dst++ = *data_src++;
-        }
+        pp.query("thread_cache_size", thread_cache_size);
+        pp.query("max_cached_size",   max_cached_size);
+        pp.query("use_huge_pages",    use_huge_pages);
+        pp.query("huge_page_size",    huge_page_size);
+
+        arena = new TArena(thread_cache_size,max_cached_size,use_huge_pages,huge_page_size);
+
+        bool verbose = false;
+
+        pp.query("verbose", verbose);
+
+        if (verbose)
+            BoxLib::ExecOnFinalize(ReportArenaUsage);
     }
     else
     {
-        const int* destboxlo  = destbox.loVect();
-        const int* destboxhi  = destbox.hiVect();
-        const int* _th_plo    = loVect();
-        const int* _th_phi    = hiVect();
-        const int* _x_lo      = srcbox.loVect();
-        const int* _x_plo     = src.loVect();
-        const int* _x_phi     = src.hiVect();
-        Real*       _th_p     = dataPtr(destcomp);
-        const Real* _x_p      = src.dataPtr(srccomp);
-
-        FORT_FASTCOPY(_th_p,
-                      ARLIM(_th_plo),
-                      ARLIM(_th_phi),
-                      D_DECL(destboxlo[0],destboxlo[1],destboxlo[2]),
-                      D_DECL(destboxhi[0],destboxhi[1],destboxhi[2]),
-                      _x_p,
-                      ARLIM(_x_plo),
-                      ARLIM(_x_phi),
-                      D_DECL(_x_lo[0],_x_lo[1],_x_lo[2]),
-                      &numcomp);
+        BoxLib::Error("BoxLib::InitializeArena(): arena.type must be BArena, CArena or TArena");
+    }
+    //
+    // Blocks already handed out must go back to the arena they came from.
+    //
+    if (TotalBytesAllocatedInFabs() != 0)
+    {
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << "BoxLib::InitializeArena(): FABs already allocated, keeping the default arena\n";
+
+        delete arena;
+
+        return;
     }
+
+    delete the_arena;
+
+    the_arena = arena;
+}
+
+Arena*
+BoxLib::The_Arena ()
+{
+    BL_ASSERT(the_arena != 0);
+
+    return the_arena;
 }
 
+#if !(defined(BL_NO_FORT) || defined(WIN32))
 template <>
 void
 BaseFab<Real>::copyToMem (const Box& srcbox,
@@ -240,372 +223,4 @@ BaseFab<Real>::copyFromMem (const Box&  dstbox,
     }
 }
 
-template<>
-void
-BaseFab<Real>::performSetVal (Real       val,
-                              const Box& bx,
-                              int        comp,
-                              int        ncomp)
-{
-    BL_ASSERT(domain.contains(bx));
-    BL_ASSERT(comp >= 0 && comp + ncomp <= nvar);
-
-    Real* data = dataPtr(comp);
-
-    if (bx == domain)
-    {
-        for (long i = 0, N = ncomp*numpts; i < N; i++)
-        {
-            *data++ = val;
-        }
-    }
-    else
-    {
-        const int* _box_lo = bx.loVect(); 
-        const int* _box_hi = bx.hiVect(); 
-        const int* _th_plo = loVect(); 
-        const int* _th_phi = hiVect(); 
-
-        FORT_FASTSETVAL(&val,
-                        _box_lo,
-                        _box_hi,
-                        data,
-                        ARLIM(_th_plo),
-                        ARLIM(_th_phi),
-                        &ncomp);
-    }
-}
-
-template<>
-BaseFab<Real>&
-BaseFab<Real>::invert (Real       val,
-                       const Box& bx,
-                       int        comp,
-                       int        ncomp)
-{
-    BL_ASSERT(domain.contains(bx));
-    BL_ASSERT(comp >= 0 && comp + ncomp <= nvar);
-
-    const int* _box_lo = bx.loVect();            
-    const int* _box_hi = bx.hiVect();            
-    const int* _datalo = loVect();                           
-    const int* _datahi = hiVect();
-
-    const Real* _data = dataPtr(comp);
-
-    FORT_FASTINVERT(_data,
-                    ARLIM(_datalo),
-                    ARLIM(_datahi),
-                    _box_lo,
-                    _box_hi,
-                    &val,
-                    &ncomp);
-    return *this;
-}
-
-template<>
-Real
-BaseFab<Real>::norm (const Box& bx,
-                     int        p,
-                     int        comp,
-                     int        ncomp) const
-{
-    BL_ASSERT(domain.contains(bx));
-    BL_ASSERT(comp >= 0 && comp + ncomp <= nvar);
-
-    const int* _box_lo = bx.loVect();            
-    const int* _box_hi = bx.hiVect();            
-    const int* _datalo = loVect();                           
-    const int* _datahi = hiVect();
-
-    const Real* _data = dataPtr(comp);
-
-    Real nrm = 0;
-
-    if (p == 0)
-    {
-        FORT_FASTZERONORM(_data,
-                          ARLIM(_datalo),
-                          ARLIM(_datahi),
-                          _box_lo,
-                          _box_hi,
-                          &ncomp,
-                          &nrm);
-    }
-    else if (p == 1)
-    {
-        FORT_FASTONENORM(_data,
-                         ARLIM(_datalo),
-                         ARLIM(_datahi),
-                         _box_lo,
-                         _box_hi,
-                         &ncomp,
-                         &nrm);
-    }
-    else
-    {
-        BoxLib::Error("BaseFab<Real>::norm(): only p == 0 or p == 1 are supported");
-    }
-
-    return nrm;
-}
-
-template<>
-Real
-BaseFab<Real>::sum (const Box& bx,
-                    int        comp,
-                    int        ncomp) const
-{
-    BL_ASSERT(domain.contains(bx));
-    BL_ASSERT(comp >= 0 && comp + ncomp <= nvar);
-
-    const int* _box_lo = bx.loVect();            
-    const int* _box_hi = bx.hiVect();            
-    const int* _datalo = loVect();                           
-    const int* _datahi = hiVect();
-
-    const Real* _data = dataPtr(comp);
-
-    Real sm = 0;
-
-    FORT_FASTSUM(_data,
-                 ARLIM(_datalo),
-                 ARLIM(_datahi),
-                 _box_lo,
-                 _box_hi,
-                 &ncomp,
-                 &sm);
-
-    return sm;
-}
-
-template<>
-BaseFab<Real>&
-BaseFab<Real>::plus (const BaseFab<Real>& src,
-                     const Box&           srcbox,
-                     const Box&           destbox,
-                     int                  srccomp,
-                     int                  destcomp,
-                     int                  numcomp)
-{
-    BL_ASSERT(destbox.ok());
-    BL_ASSERT(src.box().contains(srcbox));
-    BL_ASSERT(box().contains(destbox));
-    BL_ASSERT(destbox.sameSize(srcbox));
-    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
-    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
-
-    const int* destboxlo  = destbox.loVect();
-    const int* destboxhi  = destbox.hiVect();
-    const int* _th_plo    = loVect();
-    const int* _th_phi    = hiVect();
-    const int* _x_lo      = srcbox.loVect();
-    const int* _x_plo     = src.loVect();
-    const int* _x_phi     = src.hiVect();
-    Real*       _th_p     = dataPtr(destcomp);
-    const Real* _x_p      = src.dataPtr(srccomp);
-
-    FORT_FASTPLUS(_th_p,
-                  ARLIM(_th_plo),
-                  ARLIM(_th_phi),
-                  D_DECL(destboxlo[0],destboxlo[1],destboxlo[2]),
-                  D_DECL(destboxhi[0],destboxhi[1],destboxhi[2]),
-                  _x_p,
-                  ARLIM(_x_plo),
-                  ARLIM(_x_phi),
-                  D_DECL(_x_lo[0],_x_lo[1],_x_lo[2]),
-                  &numcomp);
-    return *this;
-}
-
-template<>
-BaseFab<Real>&
-BaseFab<Real>::mult (const BaseFab<Real>& src,
-                     const Box&           srcbox,
-                     const Box&           destbox,
-                     int                  srccomp,
-                     int                  destcomp,
-                     int                  numcomp)
-{
-    BL_ASSERT(destbox.ok());
-    BL_ASSERT(src.box().contains(srcbox));
-    BL_ASSERT(box().contains(destbox));
-    BL_ASSERT(destbox.sameSize(srcbox));
-    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
-    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
-
-    const int* destboxlo  = destbox.loVect();
-    const int* destboxhi  = destbox.hiVect();
-    const int* _th_plo    = loVect();
-    const int* _th_phi    = hiVect();
-    const int* _x_lo      = srcbox.loVect();
-    const int* _x_plo     = src.loVect();
-    const int* _x_phi     = src.hiVect();
-    Real*       _th_p     = dataPtr(destcomp);
-    const Real* _x_p      = src.dataPtr(srccomp);
-
-    FORT_FASTMULT(_th_p,
-                  ARLIM(_th_plo),
-                  ARLIM(_th_phi),
-                  D_DECL(destboxlo[0],destboxlo[1],destboxlo[2]),
-                  D_DECL(destboxhi[0],destboxhi[1],destboxhi[2]),
-                  _x_p,
-                  ARLIM(_x_plo),
-                  ARLIM(_x_phi),
-                  D_DECL(_x_lo[0],_x_lo[1],_x_lo[2]),
-                  &numcomp);
-    return *this;
-}
-
-template <>
-BaseFab<Real>&
-BaseFab<Real>::saxpy (Real a, const BaseFab<Real>& src,
-                      const Box&        srcbox,
-                      const Box&        destbox,
-                      int               srccomp,
-                      int               destcomp,
-                      int               numcomp)
-{
-    const int* destboxlo  = destbox.loVect();
-    const int* destboxhi  = destbox.hiVect();
-    const int* _th_plo    = loVect();
-    const int* _th_phi    = hiVect();
-    const int* _x_lo      = srcbox.loVect();
-    const int* _x_plo     = src.loVect();
-    const int* _x_phi     = src.hiVect();
-    Real*       _th_p     = dataPtr(destcomp);
-    const Real* _x_p      = src.dataPtr(srccomp);
-
-    FORT_FASTSAXPY(_th_p,
-                   ARLIM(_th_plo),
-                   ARLIM(_th_phi),
-                   D_DECL(destboxlo[0],destboxlo[1],destboxlo[2]),
-                   D_DECL(destboxhi[0],destboxhi[1],destboxhi[2]),
-                   &a,
-                   _x_p,
-                   ARLIM(_x_plo),
-                   ARLIM(_x_phi),
-                   D_DECL(_x_lo[0],_x_lo[1],_x_lo[2]),
-                   &numcomp);
-
-    return *this;
-}
-
-template<>
-BaseFab<Real>&
-BaseFab<Real>::minus (const BaseFab<Real>& src,
-                      const Box&           srcbox,
-                      const Box&           destbox,
-                      int                  srccomp,
-                      int                  destcomp,
-                      int                  numcomp)
-{
-    BL_ASSERT(destbox.ok());
-    BL_ASSERT(src.box().contains(srcbox));
-    BL_ASSERT(box().contains(destbox));
-    BL_ASSERT(destbox.sameSize(srcbox));
-    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
-    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
-
-    const int* destboxlo  = destbox.loVect();
-    const int* destboxhi  = destbox.hiVect();
-    const int* _th_plo    = loVect();
-    const int* _th_phi    = hiVect();
-    const int* _x_lo      = srcbox.loVect();
-    const int* _x_plo     = src.loVect();
-    const int* _x_phi     = src.hiVect();
-    Real*       _th_p     = dataPtr(destcomp);
-    const Real* _x_p      = src.dataPtr(srccomp);
-
-    FORT_FASTMINUS(_th_p,
-                   ARLIM(_th_plo),
-                   ARLIM(_th_phi),
-                   D_DECL(destboxlo[0],destboxlo[1],destboxlo[2]),
-                   D_DECL(destboxhi[0],destboxhi[1],destboxhi[2]),
-                   _x_p,
-                   ARLIM(_x_plo),
-                   ARLIM(_x_phi),
-                   D_DECL(_x_lo[0],_x_lo[1],_x_lo[2]),
-                   &numcomp);
-    return *this;
-}
-
-template<>
-BaseFab<Real>&
-BaseFab<Real>::divide (const BaseFab<Real>& src,
-                       const Box&           srcbox,
-                       const Box&           destbox,
-                       int                  srccomp,
-                       int                  destcomp,
-                       int                  numcomp)
-{
-    BL_ASSERT(destbox.ok());
-    BL_ASSERT(src.box().contains(srcbox));
-    BL_ASSERT(box().contains(destbox));
-    BL_ASSERT(destbox.sameSize(srcbox));
-    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
-    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
-
-    const int* destboxlo  = destbox.loVect();
-    const int* destboxhi  = destbox.hiVect();
-    const int* _th_plo    = loVect();
-    const int* _th_phi    = hiVect();
-    const int* _x_lo      = srcbox.loVect();
-    const int* _x_plo     = src.loVect();
-    const int* _x_phi     = src.hiVect();
-    Real*       _th_p     = dataPtr(destcomp);
-    const Real* _x_p      = src.dataPtr(srccomp);
-
-    FORT_FASTDIVIDE(_th_p,
-                    ARLIM(_th_plo),
-                    ARLIM(_th_phi),
-                    D_DECL(destboxlo[0],destboxlo[1],destboxlo[2]),
-                    D_DECL(destboxhi[0],destboxhi[1],destboxhi[2]),
-                    _x_p,
-                    ARLIM(_x_plo),
-                    ARLIM(_x_phi),
-                    D_DECL(_x_lo[0],_x_lo[1],_x_lo[2]),
-                    &numcomp);
-    return *this;
-}
-
-template<>
-BaseFab<Real>&
-BaseFab<Real>::protected_divide (const BaseFab<Real>& src,
-                                 const Box&           srcbox,
-                                 const Box&           destbox,
-                                 int                  srccomp,
-                                 int                  destcomp,
-                                 int                  numcomp)
-{
-    BL_ASSERT(destbox.ok());
-    BL_ASSERT(src.box().contains(srcbox));
-    BL_ASSERT(box().contains(destbox));
-    BL_ASSERT(destbox.sameSize(srcbox));
-    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
-    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
-
-    const int* destboxlo  = destbox.loVect();
-    const int* destboxhi  = destbox.hiVect();
-    const int* _th_plo    = loVect();
-    const int* _th_phi    = hiVect();
-    const int* _x_lo      = srcbox.loVect();
-    const int* _x_plo     = src.loVect();
-    const int* _x_phi     = src.hiVect();
-    Real*       _th_p     = dataPtr(destcomp);
-    const Real* _x_p      = src.dataPtr(srccomp);
-
-    FORT_FASTPROTDIVIDE(_th_p,
-                        ARLIM(_th_plo),
-                        ARLIM(_th_phi),
-                        D_DECL(destboxlo[0],destboxlo[1],destboxlo[2]),
-                        D_DECL(destboxhi[0],destboxhi[1],destboxhi[2]),
-                        _x_p,
-                        ARLIM(_x_plo),
-                        ARLIM(_x_phi),
-                        D_DECL(_x_lo[0],_x_lo[1],_x_lo[2]),
-                        &numcomp);
-    return *this;
-}
-
 #endif
@@ -1,14 +1,11 @@
 
+#include <algorithm>
 #include <iostream>
 
 #include <BLassert.H>
 #include <BoxArray.H>
 #include <ParallelDescriptor.H>
 
-typedef std::map< IntVect,std::vector<int>,IntVect::Compare > BoxHashMapType;
-typedef std::map< IntVect,std::vector<int>,IntVect::Compare >::iterator BoxHashMapIter;
-typedef std::map< IntVect,std::vector<int>,IntVect::Compare >::const_iterator ConstBoxHashMapIter;
-
 void
 BoxArray::decrementCounters () const
 {
@@ -776,31 +773,53 @@ BoxArray::intersections (const Box& bx, bool first_only) const
     return isects;
 }
 
+void
+BoxArray::intersections (const std::vector<Box>&                            bxs,
+                         std::vector< std::vector< std::pair<int,Box> > >& isects) const
+{
+    BL_PROFILE("BoxArray::intersections(batch)");
+
+    const int N = bxs.size();
+
+    isects.resize(N);
+    //
+    // Build the index up front so the threads don't wait on each other.
+    //
+    if (N > 0 && !m_ref->hash_ready)
+        build_hash_bin();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,64)
+#endif
+    for (int i = 0; i < N; i++)
+        intersections(bxs[i],isects[i]);
+}
+
 void
 BoxArray::clear_hash_bin () const
 {
-    if (!m_ref->hash.empty())
+    if (m_ref->hash_ready)
     {
-        m_ref->hash.clear();
+        m_ref->hash_ready = false;
+
+        std::vector<long>().swap(m_ref->hash_bin);
+        std::vector<int>().swap(m_ref->hash_off);
+        std::vector<int>().swap(m_ref->hash_idx);
     }
 }
 
 void
-BoxArray::intersections (const Box&                         bx,
-                         std::vector< std::pair<int,Box> >& isects,
-			 bool first_only) const
+BoxArray::build_hash_bin () const
 {
-    // called too many times  BL_PROFILE("BoxArray::intersections()");
-
-    BoxHashMapType& BoxHashMap = m_ref->hash;
-
 #ifdef _OPENMP
     #pragma omp critical(intersections_lock)
 #endif
+    if (!m_ref->hash_ready)
     {
-        if (BoxHashMap.empty() && size() > 0)
+        const int N = size();
+
+        if (N > 0)
         {
-            BL_ASSERT(bx.sameType(get(0)));
             //
             // Calculate the bounding box & maximum extent of the boxes.
             //
@@ -820,46 +839,120 @@ BoxArray::intersections (const Box&                         bx,
             m_ref->crsn = maxext;
             m_ref->bbox = boundingbox;
 
-            for (int i = 0, N = size(); i < N; i++)
+            std::vector< std::pair<long,int> > keys(N);
+
+            for (int i = 0; i < N; i++)
+                keys[i] = std::pair<long,int>(boundingbox.index(BoxLib::coarsen(get(i).smallEnd(),maxext)), i);
+
+            const long nbins = boundingbox.numPts();
+            //
+            // A dense grid of bins unless it'd be mostly empty.
+            //
+            const bool dense = nbins <= 8*long(N) + 1024;
+
+            m_ref->hash_idx.resize(N);
+            m_ref->hash_bin.clear();
+
+            if (dense)
             {
-                BoxHashMap[BoxLib::coarsen(get(i).smallEnd(),maxext)].push_back(i);
+                //
+                // A counting sort into the bins.
+                //
+                m_ref->hash_off.assign(nbins+1, 0);
+
+                for (int i = 0; i < N; i++)
+                    m_ref->hash_off[keys[i].first+1]++;
+
+                for (long b = 0; b < nbins; b++)
+                    m_ref->hash_off[b+1] += m_ref->hash_off[b];
+
+                std::vector<int> pos(m_ref->hash_off.begin(), m_ref->hash_off.end()-1);
+
+                for (int i = 0; i < N; i++)
+                    m_ref->hash_idx[pos[keys[i].first]++] = i;
+            }
+            else
+            {
+                std::sort(keys.begin(), keys.end());
+
+                m_ref->hash_off.clear();
+
+                for (int i = 0; i < N; i++)
+                {
+                    if (i == 0 || keys[i].first != keys[i-1].first)
+                    {
+                        m_ref->hash_bin.push_back(keys[i].first);
+                        m_ref->hash_off.push_back(i);
+                    }
+
+                    m_ref->hash_idx[i] = keys[i].second;
+                }
+
+                m_ref->hash_off.push_back(N);
             }
         }
+        //
+        // Make sure the index is visible before saying it's ready.
+        //
+#ifdef _OPENMP
+        #pragma omp flush
+#endif
+        m_ref->hash_ready = true;
     }
+}
+
+void
+BoxArray::intersections (const Box&                         bx,
+                         std::vector< std::pair<int,Box> >& isects,
+			 bool first_only) const
+{
+    // called too many times  BL_PROFILE("BoxArray::intersections()");
+
+#ifdef _OPENMP
+    #pragma omp flush
+#endif
+    if (!m_ref->hash_ready)
+        build_hash_bin();
 
     isects.resize(0);
 
-    if (!BoxHashMap.empty())
+    if (size() == 0) return;
+
+    BL_ASSERT(bx.sameType(get(0)));
+
+    const Box&     bb  = m_ref->bbox;
+    Box            cbx = BoxLib::coarsen(bx, m_ref->crsn);
+    const IntVect& sm  = BoxLib::max(cbx.smallEnd()-1, bb.smallEnd());
+    const IntVect& bg  = BoxLib::min(cbx.bigEnd(),     bb.bigEnd());
+
+    cbx = Box(sm,bg,bx.ixType());
+
+    const std::vector<long>& bins = m_ref->hash_bin;
+    const std::vector<int>&  offs = m_ref->hash_off;
+    const std::vector<int>&  idxs = m_ref->hash_idx;
+
+    for (IntVect iv = cbx.smallEnd(), End = cbx.bigEnd(); iv <= End; cbx.next(iv))
     {
-        BL_ASSERT(bx.sameType(get(0)));
+        long b = bb.index(iv);
 
-        Box           cbx = BoxLib::coarsen(bx, m_ref->crsn);
-        const IntVect& sm = BoxLib::max(cbx.smallEnd()-1, m_ref->bbox.smallEnd());
-        const IntVect& bg = BoxLib::min(cbx.bigEnd(),     m_ref->bbox.bigEnd());
+        if (!bins.empty())
+        {
+            std::vector<long>::const_iterator it = std::lower_bound(bins.begin(), bins.end(), b);
 
-        cbx = Box(sm,bg,bx.ixType());
+            if (it == bins.end() || *it != b) continue;
 
-        ConstBoxHashMapIter TheEnd = BoxHashMap.end();
+            b = it - bins.begin();
+        }
 
-        for (IntVect iv = cbx.smallEnd(), End = cbx.bigEnd(); iv <= End; cbx.next(iv))
+        for (int k = offs[b], K = offs[b+1]; k < K; k++)
         {
-            ConstBoxHashMapIter it = BoxHashMap.find(iv);
+            const int  index = idxs[k];
+            const Box& isect = bx & get(index);
 
-            if (it != TheEnd)
+            if (isect.ok())
             {
-                for (std::vector<int>::const_iterator v_it = it->second.begin(), v_end = it->second.end();
-                     v_it != v_end;
-                     ++v_it)
-                {
-                    const int  index = *v_it;
-                    const Box& isect = bx & get(index);
-
-                    if (isect.ok())
-                    {
-                        isects.push_back(std::pair<int,Box>(index,isect));
-			if (first_only) return;
-                    }
-                }
+                isects.push_back(std::pair<int,Box>(index,isect));
+                if (first_only) return;
             }
         }
     }
@@ -874,9 +967,21 @@ BoxArray::removeOverlap ()
 {
     if (!m_ref.unique()) uniqify();
 
-    std::map< IntVect,std::vector<int>,IntVect::Compare >& BoxHashMap = m_ref->hash;
+    const int N = size();
+    //
+    // The pieces we cut a Box into lie inside it, so we find the pieces
+    // that intersect a Box with intersections() on the original Boxes,
+    // which we leave alone until the end, keeping the current pieces of
+    // original Box r in boxes[pieces[r][0]], boxes[pieces[r][1]], ...
+    //
+    std::vector<Box> boxes(m_ref->m_abox.begin(), m_ref->m_abox.end());
+
+    std::vector< std::vector<int> > pieces(N);
 
-    typedef std::map< IntVect,std::vector<int>,IntVect::Compare >::const_iterator ConstBoxHashMapIter;
+    for (int i = 0; i < N; i++)
+        pieces[i].push_back(i);
+
+    build_hash_bin();
 
     BoxList bl;
 
@@ -884,60 +989,59 @@ BoxArray::removeOverlap ()
 
     std::vector< std::pair<int,Box> > isects;
     //
-    // Note that "size()" can increase in this loop!!!
+    // Note that "boxes.size()" can increase in this loop!!!
     //
-    for (int i = 0; i < size(); i++)
+    for (int i = 0; i < boxes.size(); i++)
     {
-        if (m_ref->m_abox[i].ok())
-        {
-            intersections(m_ref->m_abox[i],isects);
+        if (!boxes[i].ok()) continue;
 
-            for (int j = 0, N = isects.size(); j < N; j++)
+        const Box bx = boxes[i];
+
+        intersections(bx, isects);
+
+        for (int j = 0, J = isects.size(); j < J; j++)
+        {
+            std::vector<int>& pcs = pieces[isects[j].first];
+            //
+            // The pieces we add here are disjoint from bx.
+            //
+            for (int k = 0, K = pcs.size(); k < K; k++)
             {
-                if (isects[j].first == i) continue;
+                const int index = pcs[k];
 
-                Box& bx = m_ref->m_abox[isects[j].first];
+                if (index == i) continue;
 
-                bl = BoxLib::boxDiff(bx, isects[j].second);
+                const Box isect = bx & boxes[index];
 
-                bx = EmptyBox;
+                if (!isect.ok()) continue;
+
+                bl = BoxLib::boxDiff(boxes[index], isect);
+
+                boxes[index] = EmptyBox;
 
                 for (BoxList::const_iterator it = bl.begin(), End = bl.end(); it != End; ++it)
                 {
-                    m_ref->m_abox.push_back(*it);
-
-                    BoxHashMap[BoxLib::coarsen(it->smallEnd(),m_ref->crsn)].push_back(size()-1);
+                    pcs.push_back(boxes.size());
+                    boxes.push_back(*it);
                 }
             }
         }
     }
     //
-    // We now have "holes" in our BoxArray. Make us good.
+    // We now have "holes" in our BoxArray. Make us good, gathering the
+    // pieces in the order of the bins of the Boxes they came from.
     //
     bl.clear();
 
-    const Box& bb = m_ref->bbox;
+    const std::vector<int>& idxs = m_ref->hash_idx;
 
-    ConstBoxHashMapIter TheEnd = BoxHashMap.end();
-
-    for (IntVect iv = bb.smallEnd(), End = bb.bigEnd(); iv <= End; bb.next(iv))
+    for (int k = 0, K = idxs.size(); k < K; k++)
     {
-        ConstBoxHashMapIter it = BoxHashMap.find(iv);
+        const std::vector<int>& pcs = pieces[idxs[k]];
 
-        if (it != TheEnd)
-        {
-            for (std::vector<int>::const_iterator v_it = it->second.begin(), v_end = it->second.end();
-                 v_it != v_end;
-                 ++v_it)
-            {
-                const int index = *v_it;
-
-                if (m_ref->m_abox[index].ok())
-                {
-                    bl.push_back(m_ref->m_abox[index]);
-                }
-            }
-        }
+        for (int p = 0, P = pcs.size(); p < P; p++)
+            if (boxes[pcs[p]].ok())
+                bl.push_back(boxes[pcs[p]]);
     }
 
     bl.simplify();
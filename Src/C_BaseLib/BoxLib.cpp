@@ -290,6 +290,10 @@ BoxLib::Initialize (int& argc, char**& argv, bool build_parm_parse, MPI_Comm mpi
         }
     }
 #endif
+    //
+    // Now that ParmParse is up we can pick the FAB arena.
+    //
+    BoxLib::InitializeArena();
 
     std::cout << std::setprecision(10);
 
@@ -2,15 +2,54 @@
 #include <winstd.H>
 #include <utility>
 #include <cstring>
+#include <cstdlib>
 
 #include <CArena.H>
+#include <Utility.H>
+
+namespace
+{
+    //
+    // Rounds sz up to a multiple of Arena::DataAlignment, so that every
+    // block carved out of an aligned hunk is itself aligned.
+    //
+    size_t
+    DataAlign (size_t sz)
+    {
+        const size_t a = Arena::DataAlignment;
+        return (sz + a - 1) / a * a;
+    }
+
+    void*
+    HunkAlloc (size_t sz)
+    {
+#ifdef WIN32
+        return ::operator new(sz);
+#else
+        void* vp = 0;
+        if (posix_memalign(&vp, Arena::DataAlignment, sz) != 0)
+            BoxLib::OutOfMemory();
+        return vp;
+#endif
+    }
+
+    void
+    HunkFree (void* vp)
+    {
+#ifdef WIN32
+        ::operator delete(vp);
+#else
+        std::free(vp);
+#endif
+    }
+}
 
 CArena::CArena (size_t hunk_size)
 {
     //
     // Force alignment of hunksize.
     //
-    m_hunk = Arena::align(hunk_size == 0 ? DefaultHunkSize : hunk_size);
+    m_hunk = DataAlign(hunk_size == 0 ? DefaultHunkSize : hunk_size);
     m_used = 0;
 
     BL_ASSERT(m_hunk >= hunk_size);
@@ -20,13 +59,13 @@ CArena::CArena (size_t hunk_size)
 CArena::~CArena ()
 {
     for (unsigned int i = 0, N = m_alloc.size(); i < N; i++)
-        ::operator delete(m_alloc[i]);
+        HunkFree(m_alloc[i]);
 }
 
 void*
 CArena::alloc (size_t nbytes)
 {
-    nbytes = Arena::align(nbytes == 0 ? 1 : nbytes);
+    nbytes = DataAlign(nbytes == 0 ? 1 : nbytes);
     //
     // Find node in freelist at lowest memory address that'll satisfy request.
     //
@@ -42,7 +81,7 @@ CArena::alloc (size_t nbytes)
     {
         const size_t N = nbytes < m_hunk ? m_hunk : nbytes;
 
-        vp = ::operator new(N);
+        vp = HunkAlloc(N);
 
         m_used += N;
 
@@ -22,6 +22,7 @@
 #include <numeric>
 #include <string>
 #include <cstring>
+#include <cmath>
 using std::string;
 
 namespace
@@ -33,6 +34,7 @@ namespace
     std::multimap<IntVect, int, IntVect::Compare> topIVpNumMM;
                                           // [topological iv position, procNumber]
     std::vector<int> ranksSFC;
+    std::vector<int> nodeOfRank;          // [rank, node]
 }
 
 namespace
@@ -43,6 +45,17 @@ namespace
     bool   verbose;
     int    sfc_threshold;
     double max_efficiency;
+    int    graph_ngrow;
+    double graph_imbalance;
+}
+
+namespace
+{
+    void BoxGraphEdges (const BoxArray&    boxes,
+                        int                ngrow,
+                        std::vector<int>&  src,
+                        std::vector<int>&  dst,
+                        std::vector<long>& cells);
 }
 
 // We default to SFC.
@@ -96,6 +109,9 @@ DistributionMapping::strategy (DistributionMapping::Strategy how)
     case RRSFC:
         m_BuildMap = &DistributionMapping::RRSFCProcessorMap;
         break;
+    case GRAPH:
+        m_BuildMap = &DistributionMapping::GraphProcessorMap;
+        break;
     default:
         BoxLib::Error("Bad DistributionMapping::Strategy");
     }
@@ -135,6 +151,8 @@ DistributionMapping::Initialize ()
     verbose          = false;
     sfc_threshold    = 0;
     max_efficiency   = 0.9;
+    graph_ngrow      = 1;
+    graph_imbalance  = 1.1;
 
     ParmParse pp("DistributionMapping");
 
@@ -142,6 +160,14 @@ DistributionMapping::Initialize ()
     pp.query("verbose",          verbose);
     pp.query("efficiency",       max_efficiency);
     pp.query("sfc_threshold",    sfc_threshold);
+    pp.query("graph_ngrow",      graph_ngrow);
+    pp.query("graph_imbalance",  graph_imbalance);
+
+    if (graph_ngrow < 1)
+        BoxLib::Abort("DistributionMapping.graph_ngrow must be >= 1");
+
+    if (graph_imbalance < 1)
+        BoxLib::Abort("DistributionMapping.graph_imbalance must be >= 1");
 
     std::string theStrategy;
 
@@ -168,6 +194,10 @@ DistributionMapping::Initialize ()
         {
             strategy(RRSFC);
         }
+        else if (theStrategy == "GRAPH")
+        {
+            strategy(GRAPH);
+        }
         else
         {
             std::string msg("Unknown strategy: ");
@@ -186,6 +216,47 @@ DistributionMapping::Initialize ()
       proximityOrder.resize(ParallelDescriptor::NProcs(), 0);
     }
     totalBoxPoints.resize(ParallelDescriptor::NProcs(), 0);
+    //
+    // Which node is each CPU on?  CPUs with the same processor name share one.
+    //
+    {
+        const int NProcs = ParallelDescriptor::NProcs();
+
+        const std::string name = DistributionMapping::GetProcName();
+        //
+        // An FNV-1a hash of the name.
+        //
+        unsigned long hash = 2166136261UL;
+        for (int i = 0, N = name.size(); i < N; ++i)
+            hash = (hash ^ static_cast<unsigned char>(name[i])) * 16777619UL;
+
+        Array<long> hashes(NProcs, 0);
+        hashes[0] = long(hash);
+
+#ifdef BL_USE_MPI
+        long lhash = long(hash);
+        BL_MPI_REQUIRE( MPI_Allgather(&lhash,
+                                      1,
+                                      ParallelDescriptor::Mpi_typemap<long>::type(),
+                                      hashes.dataPtr(),
+                                      1,
+                                      ParallelDescriptor::Mpi_typemap<long>::type(),
+                                      ParallelDescriptor::Communicator()) );
+#endif
+        std::map<long,int> nodes;
+
+        nodeOfRank.resize(NProcs);
+
+        for (int i = 0; i < NProcs; ++i)
+        {
+            std::map<long,int>::const_iterator it = nodes.find(hashes[i]);
+
+            if (it == nodes.end())
+                it = nodes.insert(std::make_pair(hashes[i], int(nodes.size()))).first;
+
+            nodeOfRank[i] = it->second;
+        }
+    }
 
     BoxLib::ExecOnFinalize(DistributionMapping::Finalize);
 
@@ -208,6 +279,7 @@ DistributionMapping::Finalize ()
 // Our cache of processor maps.
 //
 std::map< int,LnClassPtr<DistributionMapping::Ref> > DistributionMapping::m_Cache;
+std::map< int,LnClassPtr<DistributionMapping::Ref> > DistributionMapping::m_CacheSave;
 
 void
 DistributionMapping::Sort (std::vector<LIpair>& vec,
@@ -351,7 +423,8 @@ DistributionMapping::DistributionMapping (const BoxArray& boxes, int nprocs)
 
 DistributionMapping::Ref::Ref (const Ref& rhs)
     :
-    m_pmap(rhs.m_pmap)
+    m_pmap(rhs.m_pmap),
+    m_offnode(rhs.m_offnode)
 {}
 
 DistributionMapping::DistributionMapping (const DistributionMapping& d1,
@@ -407,6 +480,18 @@ if(ParallelDescriptor::IOProcessor()) {
 	    BL_ASSERT(m_BuildMap != 0);
 
             (this->*m_BuildMap)(boxes,nprocs);
+
+#ifdef BL_PROFILING
+            if (m_ref->m_offnode.empty() && nprocs == ParallelDescriptor::NProcs())
+            {
+                std::vector<int>  src, dst;
+                std::vector<long> cells;
+
+                BoxGraphEdges(boxes, graph_ngrow, src, dst, cells);
+
+                SetOffNodeBytes(src, dst, cells);
+            }
+#endif
             //
             // Add the new processor map to the cache.
             //
@@ -479,6 +564,66 @@ DistributionMapping::PutInCache ()
     }
 }
 
+void
+DistributionMapping::StartSubset (MPI_Comm                   comm,
+                                  const DistributionMapping& dm)
+{
+    BL_ASSERT(m_CacheSave.empty());
+
+    m_CacheSave.swap(m_Cache);
+
+    ParallelDescriptor::StartSubCommunicator(comm);
+
+    DistributionMapping d(dm);
+
+    d.PutInCache();
+}
+
+void
+DistributionMapping::EndSubset ()
+{
+    m_Cache.clear();
+
+    m_Cache.swap(m_CacheSave);
+
+    ParallelDescriptor::EndSubCommunicator();
+}
+
+void
+DistributionMapping::defineSubset (const BoxArray& boxes, int nprocs)
+{
+    BL_ASSERT(nprocs > 0);
+
+    const int N = boxes.size();
+
+    if (m_ref->m_pmap.size() != N + 1)
+        m_ref->m_pmap.resize(N + 1);
+
+    std::vector<LIpair> LIpairV;
+
+    LIpairV.reserve(N);
+
+    for (int i = 0; i < N; ++i)
+        LIpairV.push_back(LIpair(boxes[i].numPts(),i));
+
+    Sort(LIpairV, true);
+
+    std::vector<long> load(nprocs,0);
+
+    for (int i = 0; i < N; ++i)
+    {
+        const int cpu = std::min_element(load.begin(),load.end()) - load.begin();
+
+        m_ref->m_pmap[LIpairV[i].second] = cpu;
+
+        load[cpu] += LIpairV[i].first;
+    }
+    //
+    // Set sentinel equal to our processor number.
+    //
+    m_ref->m_pmap[N] = ParallelDescriptor::MyProc();
+}
+
 void
 DistributionMapping::RoundRobinDoIt (int                  nboxes,
                                      int                  nprocs,
@@ -1223,6 +1368,593 @@ DistributionMapping::RRSFCProcessorMap (const BoxArray&          boxes,
     RRSFCDoIt(boxes,nprocs);
 }
 
+namespace
+{
+    //
+    // A graph with weighted vertices and edges in compressed sparse row
+    // form.  The neighbors of vertex i are adjncy[xadj[i]] ... adjncy[xadj[i+1]-1].
+    //
+    struct Graph
+    {
+        int nvtxs () const { return vwgt.size(); }
+
+        std::vector<long>    vwgt;   // Vertex weights.
+        std::vector<IntVect> where;  // Where the vertex is in index space.
+        std::vector<int>     xadj;
+        std::vector<int>     adjncy;
+        std::vector<long>    adjwgt; // Edge weights.
+    };
+    //
+    // Build g from the directed edges src[i] -> dst[i] of weight cells[i],
+    // merging edges between the same pair of vertices.
+    //
+    void
+    BuildGraph (int                      nvtxs,
+                const std::vector<int>&  src,
+                const std::vector<int>&  dst,
+                const std::vector<long>& cells,
+                Graph&                   g)
+    {
+        std::vector< std::vector< std::pair<int,long> > > adj(nvtxs);
+
+        for (int i = 0, N = src.size(); i < N; ++i)
+        {
+            adj[src[i]].push_back(std::make_pair(dst[i],cells[i]));
+            adj[dst[i]].push_back(std::make_pair(src[i],cells[i]));
+        }
+
+        g.xadj.resize(nvtxs+1);
+        g.adjncy.clear();
+        g.adjwgt.clear();
+
+        g.xadj[0] = 0;
+
+        for (int i = 0; i < nvtxs; ++i)
+        {
+            std::vector< std::pair<int,long> >& a = adj[i];
+
+            std::sort(a.begin(), a.end());
+
+            for (int k = 0, N = a.size(); k < N; ++k)
+            {
+                if (k > 0 && a[k].first == a[k-1].first)
+                {
+                    g.adjwgt.back() += a[k].second;
+                }
+                else
+                {
+                    g.adjncy.push_back(a[k].first);
+                    g.adjwgt.push_back(a[k].second);
+                }
+            }
+
+            g.xadj[i+1] = g.adjncy.size();
+
+            std::vector< std::pair<int,long> >().swap(a);
+        }
+    }
+    //
+    // Collapse g into cg by heavy-edge matching.  cmap maps the vertices
+    // of g into those of cg.  No coarse vertex gets heavier than maxvwgt.
+    //
+    void
+    Coarsen (const Graph&      g,
+             long              maxvwgt,
+             Graph&            cg,
+             std::vector<int>& cmap)
+    {
+        const int N = g.nvtxs();
+        //
+        // Visit the light vertices first.  This must be the same on all CPUs.
+        //
+        std::vector< std::pair<long,int> > order(N);
+
+        for (int i = 0; i < N; ++i)
+            order[i] = std::make_pair(g.vwgt[i],i);
+
+        std::sort(order.begin(), order.end());
+
+        std::vector<int> match(N,-1);
+
+        for (int k = 0; k < N; ++k)
+        {
+            const int v = order[k].second;
+
+            if (match[v] >= 0) continue;
+
+            int  u    = v;
+            long maxw = -1;
+
+            for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+            {
+                const int nbr = g.adjncy[j];
+
+                if (match[nbr] < 0                         &&
+                    g.adjwgt[j] > maxw                     &&
+                    g.vwgt[v] + g.vwgt[nbr] <= maxvwgt)
+                {
+                    u    = nbr;
+                    maxw = g.adjwgt[j];
+                }
+            }
+
+            match[v] = u;
+            match[u] = v;
+        }
+
+        cmap.resize(N);
+
+        int ncvtxs = 0;
+
+        for (int v = 0; v < N; ++v)
+        {
+            if (match[v] >= v)
+            {
+                cmap[v] = ncvtxs;
+
+                if (match[v] != v)
+                    cmap[match[v]] = ncvtxs;
+
+                ++ncvtxs;
+            }
+        }
+
+        cg.vwgt.assign(ncvtxs,0);
+        cg.where.resize(ncvtxs);
+        cg.xadj.resize(ncvtxs+1);
+        cg.adjncy.clear();
+        cg.adjwgt.clear();
+
+        cg.xadj[0] = 0;
+
+        std::vector<int> htable(ncvtxs,-1);
+
+        for (int v = 0; v < N; ++v)
+        {
+            if (match[v] < v) continue;
+
+            const int cv = cmap[v];
+            const int u  = match[v];
+
+            cg.vwgt[cv]  = g.vwgt[v] + (u != v ? g.vwgt[u] : 0);
+            cg.where[cv] = (u != v && g.vwgt[u] > g.vwgt[v]) ? g.where[u] : g.where[v];
+
+            const int start = cg.adjncy.size();
+
+            for (int m = 0; m < 2; ++m)
+            {
+                const int w = (m == 0) ? v : u;
+
+                if (m == 1 && u == v) break;
+
+                for (int j = g.xadj[w]; j < g.xadj[w+1]; ++j)
+                {
+                    const int cnbr = cmap[g.adjncy[j]];
+
+                    if (cnbr == cv) continue;
+
+                    if (htable[cnbr] < 0)
+                    {
+                        htable[cnbr] = cg.adjncy.size();
+                        cg.adjncy.push_back(cnbr);
+                        cg.adjwgt.push_back(g.adjwgt[j]);
+                    }
+                    else
+                    {
+                        cg.adjwgt[htable[cnbr]] += g.adjwgt[j];
+                    }
+                }
+            }
+
+            for (int j = start, M = cg.adjncy.size(); j < M; ++j)
+                htable[cg.adjncy[j]] = -1;
+
+            cg.xadj[cv+1] = cg.adjncy.size();
+        }
+    }
+    //
+    // Improve the partition by greedily moving vertices on the partition
+    // boundaries to the neighboring part that most reduces the edge cut,
+    // while keeping parts no heavier than maxpwgt.  Parts that are too
+    // heavy shed vertices even if that increases the edge cut.
+    //
+    void
+    Refine (const Graph&      g,
+            int               nparts,
+            long              maxpwgt,
+            std::vector<int>& part)
+    {
+        const int N = g.nvtxs();
+
+        std::vector<long> pwgt(nparts,0);
+
+        for (int v = 0; v < N; ++v)
+            pwgt[part[v]] += g.vwgt[v];
+
+        std::vector<long> conn(nparts,0);
+        std::vector<int>  touched;
+
+        const int MaxPasses = 8;
+
+        for (int pass = 0; pass < MaxPasses; ++pass)
+        {
+            int nmoves = 0;
+
+            for (int v = 0; v < N; ++v)
+            {
+                const int  from = part[v];
+                const long vw   = g.vwgt[v];
+
+                if (pwgt[from] == vw) continue;  // Don't empty a part.
+
+                touched.clear();
+
+                for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+                {
+                    const int p = part[g.adjncy[j]];
+
+                    if (conn[p] == 0) touched.push_back(p);
+
+                    conn[p] += g.adjwgt[j];
+                }
+
+                const bool overweight = pwgt[from] > maxpwgt;
+
+                int  to       = -1;
+                long bestgain = 0;
+
+                for (int k = 0, M = touched.size(); k < M; ++k)
+                {
+                    const int p = touched[k];
+
+                    if (p == from || pwgt[p] + vw > maxpwgt) continue;
+
+                    const long gain = conn[p] - conn[from];
+
+                    if (to < 0 && overweight)
+                    {
+                        to = p; bestgain = gain;
+                    }
+                    else if (gain > bestgain ||
+                             (gain == bestgain && (to >= 0 ? pwgt[p] < pwgt[to] : pwgt[from] - pwgt[p] > vw)))
+                    {
+                        to = p; bestgain = gain;
+                    }
+                }
+
+                if (to < 0 && overweight)
+                {
+                    //
+                    // Nowhere nearby to go; try the lightest part.
+                    //
+                    int lightest = 0;
+                    for (int p = 1; p < nparts; ++p)
+                        if (pwgt[p] < pwgt[lightest]) lightest = p;
+
+                    if (lightest != from && pwgt[lightest] + vw <= maxpwgt)
+                        to = lightest;
+                }
+
+                for (int k = 0, M = touched.size(); k < M; ++k)
+                    conn[touched[k]] = 0;
+                conn[from] = 0;
+
+                if (to >= 0)
+                {
+                    part[v]     = to;
+                    pwgt[from] -= vw;
+                    pwgt[to]   += vw;
+                    ++nmoves;
+                }
+            }
+
+            if (nmoves == 0) break;
+        }
+    }
+    //
+    // Partition g into contiguous pieces of a Morton space filling curve
+    // through the vertices.
+    //
+    void
+    SFCPartition (const Graph&      g,
+                  int               nparts,
+                  long              totw,
+                  std::vector<int>& part)
+    {
+        std::vector<SFCToken> tokens;
+
+        tokens.reserve(g.nvtxs());
+
+        int maxijk = 0;
+
+        for (int v = 0; v < g.nvtxs(); ++v)
+        {
+            tokens.push_back(SFCToken(v,g.where[v],g.vwgt[v]));
+
+            D_TERM(maxijk = std::max(maxijk, g.where[v][0]);,
+                   maxijk = std::max(maxijk, g.where[v][1]);,
+                   maxijk = std::max(maxijk, g.where[v][2]););
+        }
+
+        int m = 0;
+        for ( ; (1 << m) <= maxijk; ++m) {
+            ;  // do nothing
+        }
+        SFCToken::MaxPower = m;
+
+        std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
+
+        std::vector< std::vector<int> > vec(nparts);
+
+        Distribute(tokens, nparts, Real(totw)/nparts, vec);
+
+        part.resize(g.nvtxs());
+
+        for (int p = 0; p < nparts; ++p)
+            for (int k = 0, M = vec[p].size(); k < M; ++k)
+                part[vec[p][k]] = p;
+    }
+
+    long
+    EdgeCut (const Graph&            g,
+             const std::vector<int>& part)
+    {
+        long cut = 0;
+
+        for (int v = 0; v < g.nvtxs(); ++v)
+            for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+                if (part[v] != part[g.adjncy[j]])
+                    cut += g.adjwgt[j];
+
+        return cut/2;
+    }
+
+    //
+    // Multilevel k-way partitioning of g.  The graph is coarsened by
+    // heavy-edge matching, the coarsest graph is cut into contiguous
+    // pieces of a Morton space filling curve, and the partition is then
+    // refined as it's projected back to the finer graphs.  Part numbers
+    // follow the space filling curve, so parts with nearby numbers tend
+    // to be near each other.
+    //
+    void
+    PartitionGraph (const Graph&      g,
+                    int               nparts,
+                    double            imbalance,
+                    std::vector<int>& part)
+    {
+        const int N = g.nvtxs();
+
+        long totw = 0, maxvw = 0;
+
+        for (int v = 0; v < N; ++v)
+        {
+            totw += g.vwgt[v];
+            maxvw = std::max(maxvw, g.vwgt[v]);
+        }
+
+        const long maxpwgt = std::max(maxvw, long(std::ceil(imbalance*totw/nparts)));
+        //
+        // Stop coarsening with a handful of vertices per part.
+        //
+        const int CoarsenTo = 8*nparts;
+
+        std::list<Graph>              graphs;
+        std::list< std::vector<int> > cmaps;
+
+        const Graph* cur = &g;
+
+        while (cur->nvtxs() > CoarsenTo)
+        {
+            graphs.push_back(Graph());
+            cmaps.push_back(std::vector<int>());
+
+            Coarsen(*cur, std::max(maxvw, 2*totw/CoarsenTo), graphs.back(), cmaps.back());
+
+            if (graphs.back().nvtxs() > 0.95*cur->nvtxs())
+            {
+                //
+                // Not worth it.
+                //
+                graphs.pop_back();
+                cmaps.pop_back();
+                break;
+            }
+
+            cur = &graphs.back();
+        }
+        //
+        // The initial partition of the coarsest graph.
+        //
+        std::vector<int> cpart;
+
+        SFCPartition(*cur, nparts, totw, cpart);
+
+        Refine(*cur, nparts, maxpwgt, cpart);
+        //
+        // Project back to the finest graph refining as we go.
+        //
+        while (!cmaps.empty())
+        {
+            const std::vector<int>& cmap = cmaps.back();
+
+            graphs.pop_back();
+
+            const Graph& fine = graphs.empty() ? g : graphs.back();
+
+            std::vector<int> fpart(fine.nvtxs());
+
+            for (int v = 0, M = fine.nvtxs(); v < M; ++v)
+                fpart[v] = cpart[cmap[v]];
+
+            Refine(fine, nparts, maxpwgt, fpart);
+
+            cpart.swap(fpart);
+
+            cmaps.pop_back();
+        }
+        //
+        // The space filling curve through the finest graph sometimes does
+        // better, so refine that too and take the better of the two.
+        //
+        std::vector<int> spart;
+
+        SFCPartition(g, nparts, totw, spart);
+
+        Refine(g, nparts, maxpwgt, spart);
+
+        if (EdgeCut(g,spart) < EdgeCut(g,cpart))
+            cpart.swap(spart);
+
+        part.swap(cpart);
+    }
+    //
+    // The directed edges of the ghost cell exchange between boxes in
+    // a FillBoundary() with ngrow ghost cells: box src[i] sends cells[i]
+    // cells to box dst[i].  Periodic images aren't included.
+    //
+    void
+    BoxGraphEdges (const BoxArray&    boxes,
+                   int                ngrow,
+                   std::vector<int>&  src,
+                   std::vector<int>&  dst,
+                   std::vector<long>& cells)
+    {
+        src.clear(); dst.clear(); cells.clear();
+
+        for (int j = 0, N = boxes.size(); j < N; ++j)
+        {
+            std::vector< std::pair<int,Box> > isects = boxes.intersections(BoxLib::grow(boxes[j],ngrow));
+
+            for (int k = 0, M = isects.size(); k < M; ++k)
+            {
+                const int i = isects[k].first;
+
+                if (i == j) continue;
+
+                src.push_back(i);
+                dst.push_back(j);
+                cells.push_back(isects[k].second.numPts());
+            }
+        }
+    }
+}
+
+void
+DistributionMapping::SetOffNodeBytes (const std::vector<int>&  src,
+                                      const std::vector<int>&  dst,
+                                      const std::vector<long>& cells)
+{
+    const int NProcs = ParallelDescriptor::NProcs();
+
+    m_ref->m_offnode.resize(NProcs,0);
+
+    if (nodeOfRank.size() != NProcs) return;
+
+    const Array<int>& pmap = m_ref->m_pmap;
+
+    for (int i = 0, N = src.size(); i < N; ++i)
+    {
+        const int from = pmap[src[i]];
+
+        if (nodeOfRank[from] != nodeOfRank[pmap[dst[i]]])
+            m_ref->m_offnode[from] += cells[i]*sizeof(Real);
+    }
+}
+
+void
+DistributionMapping::GraphProcessorMap (const BoxArray& boxes,
+                                        int             nprocs)
+{
+    BL_PROFILE("DistributionMapping::GraphProcessorMap()");
+
+    BL_ASSERT(boxes.size() > 0);
+
+    if (m_ref->m_pmap.size() != boxes.size() + 1)
+    {
+        m_ref->m_pmap.resize(boxes.size() + 1);
+    }
+
+    const int N = boxes.size();
+
+    if (N <= nprocs)
+    {
+        //
+        // Nothing to partition.
+        //
+        KnapSackProcessorMap(boxes,nprocs);
+        return;
+    }
+
+    std::vector<int>  src, dst;
+    std::vector<long> cells;
+
+    BoxGraphEdges(boxes, graph_ngrow, src, dst, cells);
+
+    Graph g;
+
+    g.vwgt.resize(N);
+    g.where.resize(N);
+
+    for (int i = 0; i < N; ++i)
+    {
+        g.vwgt[i]  = boxes[i].numPts();
+        g.where[i] = boxes[i].smallEnd();
+    }
+
+    BuildGraph(N, src, dst, cells, g);
+
+    std::vector<int> part;
+
+    PartitionGraph(g, nprocs, graph_imbalance, part);
+    //
+    // Parts with nearby numbers tend to be near each other, so give
+    // consecutive parts to the CPUs on a node.
+    //
+    std::vector< std::pair<int,int> > cpus(nprocs);
+
+    for (int i = 0; i < nprocs; ++i)
+        cpus[i] = std::make_pair(nprocs == nodeOfRank.size() ? nodeOfRank[i] : 0, i);
+
+    std::sort(cpus.begin(), cpus.end());
+
+    for (int i = 0; i < N; ++i)
+        m_ref->m_pmap[i] = cpus[part[i]].second;
+    //
+    // Set sentinel equal to our processor number.
+    //
+    m_ref->m_pmap[N] = ParallelDescriptor::MyProc();
+
+    if (nprocs == ParallelDescriptor::NProcs())
+        SetOffNodeBytes(src, dst, cells);
+
+    if (verbose && ParallelDescriptor::IOProcessor())
+    {
+        std::vector<long> wgts_per_cpu(nprocs,0);
+
+        for (int i = 0; i < N; ++i)
+            wgts_per_cpu[m_ref->m_pmap[i]] += g.vwgt[i];
+
+        Real sum_wgt = 0, max_wgt = 0;
+        for (int i = 0; i < nprocs; ++i)
+        {
+            sum_wgt += wgts_per_cpu[i];
+            max_wgt  = std::max(max_wgt, Real(wgts_per_cpu[i]));
+        }
+
+        long cut = 0, offnode = 0;
+        for (int i = 0, M = src.size(); i < M; ++i)
+            if (part[src[i]] != part[dst[i]])
+                cut += cells[i];
+        for (int i = 0, M = m_ref->m_offnode.size(); i < M; ++i)
+            offnode += m_ref->m_offnode[i];
+
+        std::cout << "GRAPH efficiency: " << (sum_wgt/(nprocs*max_wgt))
+                  << ", off-CPU ghost cells: " << cut
+                  << ", off-node bytes: " << offnode << '\n';
+    }
+}
+
 namespace
 {
     struct PFCToken
@@ -2265,6 +2997,25 @@ DistributionMapping::PrintDiagnostics(const std::string &filename)
         bos << i << ' ' << bytes[i] << '\n';
       }
       bos.close();
+      //
+      // Off-node bytes per FillBoundary() summed over the maps for which we know it.
+      //
+      Array<long> offnode(nprocs, 0);
+      for (std::map< int,LnClassPtr<Ref> >::const_iterator it = m_Cache.begin();
+           it != m_Cache.end();
+           ++it)
+      {
+          const Array<long>& on = it->second->m_offnode;
+          for (int i(0); i < on.size() && i < nprocs; ++i) {
+            offnode[i] += on[i];
+          }
+      }
+      std::string ONB("OffNode_" + filename);
+      std::ofstream oos(ONB.c_str());
+      for(int i(0); i < nprocs; ++i) {
+        oos << i << ' ' << offnode[i] << '\n';
+      }
+      oos.close();
       //std::string TBP("TBP_" + filename);
       //std::ofstream tos(TBP.c_str());
       //for(int i(0); i < totalBoxPoints.size(); ++i) {
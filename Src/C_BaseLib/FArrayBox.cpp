@@ -12,6 +12,7 @@
 #include <FabConv.H>
 #include <ParmParse.H>
 #include <FabConv.H>
+#include <FabCompress.H>
 #include <FPC.H>
 
 #include <BLassert.H>
@@ -119,6 +120,43 @@ private:
     CpClassPtr<RealDescriptor> rd;
 };
 
+//
+// Our compressed FABio type.
+//
+class FABio_compressed
+    :
+    public FABio
+{
+public:
+    //
+    // tol is the error bound for writing.  nb is the number of bytes
+    // in the Reals we're reading, which needn't be sizeof(Real).
+    //
+    FABio_compressed (Real tol, int nb = sizeof(Real));
+
+    virtual void read (std::istream& is,
+                       FArrayBox&    fb) const;
+
+    virtual void write (std::ostream&    os,
+                        const FArrayBox& fb,
+                        int              comp,
+                        int              num_comp) const;
+
+    virtual void skip (std::istream& is,
+                       FArrayBox&    f) const;
+
+    virtual void skip (std::istream& is,
+                       FArrayBox&    f,
+		       int           nCompToSkip) const;
+private:
+    virtual void write_header (std::ostream&    os,
+                               const FArrayBox& f,
+                               int              nvar) const;
+
+    Real tol;
+    int  nb;
+};
+
 //
 // This isn't inlined as it's virtual.
 //
@@ -139,6 +177,8 @@ FABio::write_header (std::ostream&    os,
 
 FABio::Format FArrayBox::format;
 
+Real FArrayBox::compression_tol = 0;
+
 FABio* FArrayBox::fabio = 0;
 
 FArrayBox::FArrayBox ()
@@ -160,6 +200,15 @@ FArrayBox::FArrayBox (const Box& b,
 	setVal(initval);
 }
 
+FArrayBox::FArrayBox (const Box& b,
+                      int        n,
+                      Real*      p)
+    :
+    BaseFab<Real>(b,n,p)
+{
+    if (fabio == 0) FArrayBox::Initialize();
+}
+
 FArrayBox&
 FArrayBox::operator= (const Real& v)
 {
@@ -311,6 +360,29 @@ FArrayBox::getFormat ()
     return format;
 }
 
+void
+FArrayBox::setCompressionTolerance (Real tol)
+{
+    BL_ASSERT(tol >= 0);
+
+    if (fabio == 0) FArrayBox::Initialize();
+
+    compression_tol = tol;
+    //
+    // Pick up the new tolerance.
+    //
+    if (format == FABio::FAB_COMPRESSED)
+        setFormat(format);
+}
+
+Real
+FArrayBox::getCompressionTolerance ()
+{
+    if (fabio == 0) FArrayBox::Initialize();
+
+    return compression_tol;
+}
+
 const FABio&
 FArrayBox::getFABio ()
 {
@@ -375,6 +447,9 @@ FArrayBox::setFormat (FABio::Format fmt)
     case FABio::FAB_NATIVE_32:
         fio = new FABio_binary(FPC::Native32RealDescriptor().clone());
         break;
+    case FABio::FAB_COMPRESSED:
+        fio = new FABio_compressed(compression_tol);
+        break;
     default:
         std::cerr << "FArrayBox::setFormat(): Bad FABio::Format = " << fmt;
         BoxLib::Abort();
@@ -425,6 +500,11 @@ Real FArrayBox::initval =
 bool
 FArrayBox::set_do_initval (bool tf)
 {
+    //
+    // Otherwise Initialize() would overwrite it later from ParmParse.
+    //
+    if (fabio == 0) FArrayBox::Initialize();
+
     bool o_tf = do_initval;
     do_initval = tf;
     return o_tf;
@@ -433,12 +513,16 @@ FArrayBox::set_do_initval (bool tf)
 bool
 FArrayBox::get_do_initval ()
 {
+    if (fabio == 0) FArrayBox::Initialize();
+
     return do_initval;
 }
 
 Real
 FArrayBox::set_initval (Real iv)
 {
+    if (fabio == 0) FArrayBox::Initialize();
+
     Real o_iv = initval;
     initval = iv;
     return o_iv;
@@ -447,6 +531,8 @@ FArrayBox::set_initval (Real iv)
 Real
 FArrayBox::get_initval ()
 {
+    if (fabio == 0) FArrayBox::Initialize();
+
     return initval;
 }
 
@@ -458,6 +544,8 @@ FArrayBox::Initialize ()
     ParmParse pp("fab");
 
     std::string fmt;
+
+    pp.query("compression_tolerance", compression_tol);
     //
     // This block can legitimately set FAB output format.
     //
@@ -498,6 +586,11 @@ FArrayBox::Initialize ()
             }
             fio = new FABio_binary(FPC::Ieee32NormalRealDescriptor().clone());
         }
+        else if (fmt == "COMPRESSED")
+        {
+            FArrayBox::format = FABio::FAB_COMPRESSED;
+            fio = new FABio_compressed(compression_tol);
+        }
         else
         {
             std::cerr << "FArrayBox::init(): Bad FABio::Format = " << fmt;
@@ -678,6 +771,9 @@ FABio::read_header (std::istream& is,
                                                    FArrayBox::ordering);
             fio = new FABio_binary(rd);
             break;
+        case FABio::FAB_COMPRESSED:
+            fio = new FABio_compressed(0, wrd_in);
+            break;
         default:
             BoxLib::Error("FABio::read_header(): Unrecognized FABio header");
         }
@@ -760,6 +856,9 @@ FABio::read_header (std::istream& is,
                                                    FArrayBox::ordering);
             fio = new FABio_binary(rd);
             break;
+        case FABio::FAB_COMPRESSED:
+            fio = new FABio_compressed(0, wrd_in);
+            break;
         default:
             BoxLib::Error("FABio::read_header(): Unrecognized FABio header");
         }
@@ -1107,6 +1206,127 @@ FABio_binary::skip (std::istream& is,
         BoxLib::Error("FABio_binary::skip(..., int nCompToSkip) failed");
 }
 
+FABio_compressed::FABio_compressed (Real tol_,
+                                    int  nb_)
+    :
+    tol(tol_),
+    nb(nb_)
+{}
+
+void
+FABio_compressed::write_header (std::ostream&    os,
+                                const FArrayBox& f,
+                                int              nvar) const
+{
+    //
+    // The "old" style header with the size of our Reals as the word size.
+    //
+    os << "FAB: " << FABio::FAB_COMPRESSED << ' ' << sizeof(Real) << ' ' << sys_name << '\n';
+    FABio::write_header(os, f, nvar);
+}
+
+void
+FABio_compressed::write (std::ostream&    os,
+                         const FArrayBox& f,
+                         int              comp,
+                         int              num_comp) const
+{
+    BL_ASSERT(comp >= 0 && num_comp >= 1 && (comp+num_comp) <= f.nComp());
+
+    const long siz = f.box().numPts();
+
+    std::vector<char> buf;
+
+    const int old_prec = os.precision(17);
+
+    for (int k = 0; k < num_comp; k++)
+    {
+        double param;
+
+        const int codec = FabCompress::compress(f.dataPtr(k+comp), siz, tol, buf, param);
+        //
+        // Each component gets a line with its codec and compressed size
+        // so that we can skip over it without decompressing.
+        //
+        os << codec << ' ' << buf.size() << ' ' << param << '\n';
+
+        if (!buf.empty())
+            os.write(&buf[0], buf.size());
+    }
+
+    os.precision(old_prec);
+
+    if (os.fail())
+        BoxLib::Error("FABio_compressed::write() failed");
+}
+
+void
+FABio_compressed::read (std::istream& is,
+                        FArrayBox&    f) const
+{
+    const long siz = f.box().numPts();
+
+    std::vector<char> buf;
+
+    for (int k = 0; k < f.nComp(); k++)
+    {
+        int    codec;
+        long   nbytes;
+        double param;
+
+        is >> codec >> nbytes >> param;
+        //
+        // Don't spin at the end of a file that's been cut short.
+        //
+        while (is.good() && is.get() != '\n')
+            ;
+        if (is.fail() || nbytes < 0)
+        {
+            is.setstate(std::ios::failbit);
+            break;
+        }
+        buf.resize(nbytes);
+        if (nbytes > 0)
+            is.read(&buf[0], nbytes);
+        if (is.fail())
+            break;
+        FabCompress::decompress(codec, param, nbytes > 0 ? &buf[0] : 0, nbytes, f.dataPtr(k), siz, nb);
+    }
+
+    if (is.fail())
+        BoxLib::Error("FABio_compressed::read() failed");
+}
+
+void
+FABio_compressed::skip (std::istream& is,
+                        FArrayBox&    f) const
+{
+    FABio_compressed::skip(is, f, f.nComp());
+}
+
+void
+FABio_compressed::skip (std::istream& is,
+                        FArrayBox&    f,
+                        int           nCompToSkip) const
+{
+    for (int k = 0; k < nCompToSkip; k++)
+    {
+        int    codec;
+        long   nbytes;
+        double param;
+
+        is >> codec >> nbytes >> param;
+        while (is.good() && is.get() != '\n')
+            ;
+        if (is.fail())
+            break;
+        is.seekg(nbytes, std::ios::cur);
+    }
+
+    if (is.fail())
+        BoxLib::Error("FABio_compressed::skip() failed");
+}
+
 std::ostream&
 operator<< (std::ostream&    os,
             const FArrayBox& f)
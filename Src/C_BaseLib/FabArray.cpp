@@ -1,12 +1,23 @@
 #include <winstd.H>
 
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
 #include <FabArray.H>
 #include <ParmParse.H>
+#include <Utility.H>
+#include <MemProfiler.H>
 //
 // Set default values in Initialize()!!!
 //
 bool    FabArrayBase::Verbose;
 bool    FabArrayBase::do_async_sends;
+bool    FabArrayBase::numa_first_touch;
 int     FabArrayBase::MaxComp;
 #if BL_SPACEDIM == 1
 IntVect FabArrayBase::mfiter_tile_size(1024000);
@@ -24,6 +35,10 @@ namespace
     //
     int fb_cache_max_size;
     int copy_cache_max_size;
+    //
+    // Alignment of the cached communication buffers.
+    //
+    const std::size_t CommBufferAlignment = 4096;
 }
 
 void
@@ -35,6 +50,7 @@ FabArrayBase::Initialize ()
     //
     FabArrayBase::Verbose           = true;
     FabArrayBase::do_async_sends    = true;
+    FabArrayBase::numa_first_touch  = false;
     FabArrayBase::MaxComp           = 25;
 
     copy_cache_max_size = 25;
@@ -50,6 +66,7 @@ FabArrayBase::Initialize ()
     pp.query("verbose",             FabArrayBase::Verbose);
     pp.query("maxcomp",             FabArrayBase::MaxComp);
     pp.query("do_async_sends",      FabArrayBase::do_async_sends);
+    pp.query("numa_first_touch",    FabArrayBase::numa_first_touch);
     pp.query("fb_cache_max_size",   fb_cache_max_size);
     pp.query("copy_cache_max_size", copy_cache_max_size);
     //
@@ -67,6 +84,167 @@ FabArrayBase::Initialize ()
     initialized = true;
 }
 
+int
+FabArrayBase::NumaDomain (const void* p, std::size_t nbytes)
+{
+    int domain = -1;
+
+#if defined(__linux__) && defined(SYS_move_pages)
+    if (p == 0 || nbytes == 0) return domain;
+    //
+    // With a null node list move_pages() just reports where each page lives.
+    //
+    const std::size_t pagesize = sysconf(_SC_PAGESIZE);
+    const std::size_t beg      = reinterpret_cast<std::size_t>(p) / pagesize;
+    const std::size_t end      = (reinterpret_cast<std::size_t>(p) + nbytes - 1) / pagesize;
+    const std::size_t npages   = end - beg + 1;
+    const std::size_t Chunk    = 1024;
+
+    std::vector<void*> pages(Chunk);
+    std::vector<int>   status(Chunk);
+    std::map<int,long> count;
+
+    for (std::size_t i = 0; i < npages; i += Chunk)
+    {
+        const std::size_t N = std::min(Chunk, npages - i);
+
+        for (std::size_t j = 0; j < N; j++)
+            pages[j] = reinterpret_cast<void*>((beg + i + j) * pagesize);
+
+        if (syscall(SYS_move_pages, 0, N, &pages[0], 0, &status[0], 0) != 0)
+            return -1;
+
+        for (std::size_t j = 0; j < N; j++)
+            if (status[j] >= 0)
+                count[status[j]]++;
+    }
+
+    long most = 0;
+
+    for (std::map<int,long>::const_iterator it = count.begin(); it != count.end(); ++it)
+    {
+        if (it->second > most)
+        {
+            most   = it->second;
+            domain = it->first;
+        }
+    }
+#endif
+
+    return domain;
+}
+
+void
+FabArrayBase::WaitAsyncSends (int                 N_snds,
+                              Array<MPI_Request>& send_reqs,
+                              Array<MPI_Status>&  stats)
+{
+#ifdef BL_USE_MPI
+    BL_ASSERT(FabArrayBase::do_async_sends && N_snds > 0);
+
+    stats.resize(N_snds);
+
+    BL_ASSERT(send_reqs.size() == N_snds);
+
+    Array<int> indx;
+    BL_COMM_PROFILE_WAITSOME(BLProfiler::Waitall, send_reqs, N_snds, indx, stats, false);
+
+    BL_MPI_REQUIRE( MPI_Waitall(N_snds, send_reqs.dataPtr(), stats.dataPtr()) );
+
+    BL_COMM_PROFILE_WAITSOME(BLProfiler::Waitall, send_reqs, N_snds, indx, stats, false);
+#endif /*BL_USE_MPI*/
+}
+
+int
+FabArrayBase::TotalVolume (const std::map<int,int>& vols)
+{
+    int TotalVolume = 0;
+
+    for (std::map<int,int>::const_iterator it = vols.begin(), End = vols.end();
+         it != End;
+         ++it)
+    {
+        TotalVolume += it->second;
+    }
+
+    return TotalVolume;
+}
+
+void*
+FabArrayBase::AllocCommBuffer (std::size_t nbytes)
+{
+    void* p = 0;
+    //
+    // Page-aligned so the MPI library can use (or pin) the pages as is.
+    //
+    if (posix_memalign(&p, CommBufferAlignment, nbytes) != 0)
+        BoxLib::OutOfMemory();
+
+    MemProfiler::Add(MemProfiler::CommBuffer, nbytes);
+
+    return p;
+}
+
+void
+FabArrayBase::FreeCommBuffer (CommBuffer& buf)
+{
+    if (buf.m_ptr != 0)
+        MemProfiler::Remove(MemProfiler::CommBuffer, buf.m_size);
+
+    ::free(buf.m_ptr);
+
+    buf = CommBuffer();
+}
+
+FabArrayBase::CommBuffer
+FabArrayBase::CheckOutCommBuffer (CommBuffer& cache_buf,
+                                  std::size_t nbytes)
+{
+    CommBuffer buf = cache_buf;
+
+    cache_buf = CommBuffer();
+
+    if (nbytes == 0)
+    {
+        //
+        // Don't throw away a perfectly good buffer we'll likely want again.
+        //
+        cache_buf = buf;
+
+        return CommBuffer();
+    }
+
+    if (buf.m_size < nbytes)
+    {
+        FabArrayBase::FreeCommBuffer(buf);
+        //
+        // Round up to a whole number of pages.
+        //
+        buf.m_size = (nbytes + CommBufferAlignment - 1) / CommBufferAlignment * CommBufferAlignment;
+        buf.m_ptr  = FabArrayBase::AllocCommBuffer(buf.m_size);
+    }
+
+    return buf;
+}
+
+void
+FabArrayBase::ReturnCommBuffer (CommBuffer& cache_buf,
+                                CommBuffer& buf)
+{
+    if (buf.m_ptr == 0) return;
+
+    if (cache_buf.m_ptr == 0)
+    {
+        cache_buf = buf;
+
+        buf = CommBuffer();
+    }
+    else
+    {
+        FabArrayBase::FreeCommBuffer(buf);
+    }
+}
+
 FabArrayBase::FabArrayBase ()
 {
     Initialize();
@@ -86,6 +264,7 @@ FabArrayBase::fabbox (int K) const
 
 FabArrayBase::CPC::CPC ()
     :
+    m_srcng(0),
     m_reused(false),
     m_threadsafe_loc(false),
     m_threadsafe_rcv(false),
@@ -98,12 +277,14 @@ FabArrayBase::CPC::CPC ()
 FabArrayBase::CPC::CPC (const BoxArray&            dstba,
                         const BoxArray&            srcba,
                         const DistributionMapping& dstdm,
-                        const DistributionMapping& srcdm)
+                        const DistributionMapping& srcdm,
+                        int                        srcng)
     :
     m_dstba(dstba),
     m_srcba(srcba),
     m_dstdm(dstdm),
     m_srcdm(srcdm),
+    m_srcng(srcng),
     m_reused(false),
     m_threadsafe_loc(false),
     m_threadsafe_rcv(false),
@@ -120,13 +301,17 @@ FabArrayBase::CPC::~CPC ()
     delete m_RcvTags;
     delete m_SndVols;
     delete m_RcvVols;
+
+    FabArrayBase::FreeCommBuffer(m_RcvBuf);
+    FabArrayBase::FreeCommBuffer(m_SndBuf);
 }
 
 bool
 FabArrayBase::CPC::operator== (const CPC& rhs) const
 {
     return
-        m_dstba == rhs.m_dstba && m_srcba == rhs.m_srcba && m_dstdm == rhs.m_dstdm && m_srcdm == rhs.m_srcdm;
+        m_dstba == rhs.m_dstba && m_srcba == rhs.m_srcba && m_dstdm == rhs.m_dstdm && m_srcdm == rhs.m_srcdm &&
+        m_srcng == rhs.m_srcng;
 }
 
 int
@@ -179,6 +364,8 @@ FabArrayBase::CPC::bytes () const
         cnt += sizeof(std::map<int,int>) + m_RcvVols->size()*sizeof(std::map<int,int>::value_type);
     }
 
+    cnt += m_RcvBuf.m_size + m_SndBuf.m_size;
+
     return cnt;
 }
 
@@ -207,7 +394,7 @@ FabArrayBase::TheCPC (const CPC&          cpc,
 
     int Key = cpc.m_dstba.size() + cpc.m_srcba.size() + Scale;
     Key    += cpc.m_dstba[0].numPts() + cpc.m_dstba[cpc.m_dstba.size()-1].numPts();
-    Key    += cpc.m_dstdm[0] + cpc.m_dstdm[cpc.m_dstdm.size()-1];
+    Key    += cpc.m_dstdm[0] + cpc.m_dstdm[cpc.m_dstdm.size()-1] + cpc.m_srcng;
 
     std::pair<CPCCacheIter,CPCCacheIter> er_it = TheCopyCache.equal_range(Key);
 
@@ -274,10 +461,17 @@ FabArrayBase::TheCPC (const CPC&          cpc,
         return cache_it;
 
     std::vector< std::pair<int,Box> > isects;
+    //
+    // The source boxes grown by the number of source ghost cells we copy from.
+    //
+    BoxArray srcba = TheCPC.m_srcba;
+
+    if (TheCPC.m_srcng > 0)
+        srcba.grow(TheCPC.m_srcng);
 
     for (int i = 0, N = TheCPC.m_dstba.size(); i < N; i++)
     {
-        TheCPC.m_srcba.intersections(TheCPC.m_dstba[i],isects);
+        srcba.intersections(TheCPC.m_dstba[i],isects);
 
         const int dst_owner = TheCPC.m_dstdm[i];
 
@@ -333,7 +527,7 @@ FabArrayBase::TheCPC (const CPC&          cpc,
         it->second.swap(tmp);
     }
 
-    TheCPC.m_srcba.clear_hash_bin();
+    srcba.clear_hash_bin();
 
     //
     // set thread safety
@@ -428,6 +622,9 @@ FabArrayBase::SI::~SI ()
     delete m_RcvTags;
     delete m_SndVols;
     delete m_RcvVols;
+
+    FabArrayBase::FreeCommBuffer(m_RcvBuf);
+    FabArrayBase::FreeCommBuffer(m_SndBuf);
 }
 
 bool
@@ -487,9 +684,38 @@ FabArrayBase::SI::bytes () const
         cnt += sizeof(std::map<int,int>) + m_RcvVols->size()*sizeof(std::map<int,int>::value_type);
     }
 
+    cnt += m_RcvBuf.m_size + m_SndBuf.m_size;
+
     return cnt;
 }
 
+bool
+FabArrayBase::SameComTags (const std::vector<FabComTag>& lhs,
+                           const std::vector<FabComTag>& rhs)
+{
+    if (lhs.size() != rhs.size()) return false;
+
+    for (int i = 0, N = lhs.size(); i < N; i++)
+    {
+        const FabComTag& l = lhs[i];
+        const FabComTag& r = rhs[i];
+
+        if (l.fabArrayId      != r.fabArrayId      ||
+            l.fillBoxId       != r.fillBoxId       ||
+            l.fabIndex        != r.fabIndex        ||
+            l.procThatHasData != r.procThatHasData ||
+            l.srcComp         != r.srcComp         ||
+            l.destComp        != r.destComp        ||
+            l.nComp           != r.nComp           ||
+            l.box             != r.box)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 FabArrayBase::FBCache FabArrayBase::m_TheFBCache;
 
 FabArrayBase::FBCacheIter
@@ -572,73 +798,89 @@ FabArrayBase::TheFB (bool                cross,
         //
         return cache_it;
 
-    std::vector<Box>                  boxes;
-    std::vector< std::pair<int,Box> > isects;
+    //
+    // The intersections are found a chunk of grids at a time with the
+    // batched BoxArray::intersections(), which spreads them over the
+    // threads.  The tags are then built in the same order as before.
+    //
+    const int NChunk = 1024;
+    const int NBoxes = si.m_cross ? 2*BL_SPACEDIM : 1;
 
-    boxes.resize(si.m_cross ? 2*BL_SPACEDIM : 1);
+    std::vector<Box>                                  boxes;
+    std::vector< std::vector< std::pair<int,Box> > > isects;
 
-    for (int i = 0, N = ba.size(); i < N; i++)
+    for (int ibeg = 0, N = ba.size(); ibeg < N; ibeg += NChunk)
     {
-        const Box& vbx = ba[i];
+        const int iend = std::min(ibeg+NChunk,N);
+
+        boxes.resize((iend-ibeg)*NBoxes);
 
-        if (si.m_cross)
+        for (int i = ibeg; i < iend; i++)
         {
-            for (int dir = 0; dir < BL_SPACEDIM; dir++)
+            const Box& vbx = ba[i];
+            Box*       bxs = &boxes[(i-ibeg)*NBoxes];
+
+            if (si.m_cross)
             {
-                Box lo = vbx;
-                lo.setSmall(dir, vbx.smallEnd(dir) - si.m_ngrow);
-                lo.setBig  (dir, vbx.smallEnd(dir) - 1);
-                boxes[2*dir+0] = lo;
-
-                Box hi = vbx;
-                hi.setSmall(dir, vbx.bigEnd(dir) + 1);
-                hi.setBig  (dir, vbx.bigEnd(dir) + si.m_ngrow);
-                boxes[2*dir+1] = hi;
+                for (int dir = 0; dir < BL_SPACEDIM; dir++)
+                {
+                    Box lo = vbx;
+                    lo.setSmall(dir, vbx.smallEnd(dir) - si.m_ngrow);
+                    lo.setBig  (dir, vbx.smallEnd(dir) - 1);
+                    bxs[2*dir+0] = lo;
+
+                    Box hi = vbx;
+                    hi.setSmall(dir, vbx.bigEnd(dir) + 1);
+                    hi.setBig  (dir, vbx.bigEnd(dir) + si.m_ngrow);
+                    bxs[2*dir+1] = hi;
+                }
+            }
+            else
+            {
+                bxs[0] = BoxLib::grow(vbx,si.m_ngrow);
             }
-        }
-        else
-        {
-            boxes[0] = BoxLib::grow(vbx,si.m_ngrow);
         }
 
-        const int dst_owner = dm[i];
+        ba.intersections(boxes,isects);
 
-        for (std::vector<Box>::const_iterator it = boxes.begin(),
-                 End = boxes.end();
-             it != End;
-             ++it)
+        for (int i = ibeg; i < iend; i++)
         {
-            ba.intersections(*it,isects);
+            const int dst_owner = dm[i];
 
-            for (int j = 0, M = isects.size(); j < M; j++)
+            for (int n = (i-ibeg)*NBoxes, NN = n+NBoxes; n < NN; n++)
             {
-                const int  k         = isects[j].first;
-                const Box& bx        = isects[j].second;
-                const int  src_owner = dm[k];
+                const std::vector< std::pair<int,Box> >& isect = isects[n];
 
-                if ( (k == i) || (dst_owner != MyProc && src_owner != MyProc) ) continue;
+                for (int j = 0, M = isect.size(); j < M; j++)
+                {
+                    const int  k         = isect[j].first;
+                    const Box& bx        = isect[j].second;
+                    const int  src_owner = dm[k];
 
-                CopyComTag tag;
+                    if ( (k == i) || (dst_owner != MyProc && src_owner != MyProc) ) continue;
 
-                tag.box      = bx;
-                tag.fabIndex = i;
-                tag.srcIndex = k;
+                    CopyComTag tag;
 
-                if (dst_owner == MyProc)
-                {
-                    if (src_owner == MyProc)
+                    tag.box      = bx;
+                    tag.fabIndex = i;
+                    tag.srcIndex = k;
+
+                    if (dst_owner == MyProc)
                     {
-                        TheFB.m_LocTags->push_back(tag);
+                        if (src_owner == MyProc)
+                        {
+                            TheFB.m_LocTags->push_back(tag);
+                        }
+                        else
+                        {
+                            FabArrayBase::SetRecvTag(*TheFB.m_RcvTags,src_owner,tag,*TheFB.m_RcvVols,bx);
+                        }
                     }
-                    else
+                    else if (src_owner == MyProc)
                     {
-                        FabArrayBase::SetRecvTag(*TheFB.m_RcvTags,src_owner,tag,*TheFB.m_RcvVols,bx);
+                        FabArrayBase::SetSendTag(*TheFB.m_SndTags,dst_owner,tag,*TheFB.m_SndVols,bx);
                     }
                 }
-                else if (src_owner == MyProc)
-                {
-                    FabArrayBase::SetSendTag(*TheFB.m_SndTags,dst_owner,tag,*TheFB.m_SndVols,bx);
-                }
             }
         }
     }
@@ -0,0 +1,439 @@
+
+#include <winstd.H>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <FabCompress.H>
+#include <BLassert.H>
+#include <BoxLib.H>
+
+namespace
+{
+    //
+    // Matches are at least this long.
+    //
+    const int MinMatch = 4;
+    //
+    // The last few bytes are always coded as literals so the match
+    // finder never has to worry about reading past the end.
+    //
+    const int LastLiterals = 8;
+
+    const int HashLog = 14;
+
+    const long MaxOffset = 65535;
+
+    inline unsigned int
+    read32 (const unsigned char* p)
+    {
+        unsigned int v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline unsigned int
+    hash32 (unsigned int v)
+    {
+        return (v * 2654435761U) >> (32 - HashLog);
+    }
+
+    void
+    put_length (std::vector<char>& dst,
+                long               len)
+    {
+        for ( ; len >= 255; len -= 255)
+            dst.push_back(char(255));
+        dst.push_back(char(len));
+    }
+
+    long
+    get_length (const unsigned char*& ip,
+                const unsigned char*  iend)
+    {
+        long len = 0;
+
+        for (;;)
+        {
+            if (ip >= iend)
+                BoxLib::Error("FabCompress: corrupt LZ stream");
+
+            const unsigned char c = *ip++;
+
+            len += c;
+
+            if (c != 255) break;
+        }
+
+        return len;
+    }
+
+    void
+    put_sequence (std::vector<char>&   dst,
+                  const unsigned char* lit,
+                  long                 nlit,
+                  long                 offset,
+                  long                 mlen)
+    {
+        const long m = mlen - MinMatch;
+
+        dst.push_back(char(((nlit < 15 ? nlit : 15) << 4) | (offset == 0 ? 0 : (m < 15 ? m : 15))));
+
+        if (nlit >= 15)
+            put_length(dst, nlit-15);
+
+        dst.insert(dst.end(), reinterpret_cast<const char*>(lit), reinterpret_cast<const char*>(lit)+nlit);
+
+        if (offset == 0)
+            //
+            // The last sequence has no match.
+            //
+            return;
+
+        dst.push_back(char(offset & 0xff));
+        dst.push_back(char(offset >> 8));
+
+        if (m >= 15)
+            put_length(dst, m-15);
+    }
+    //
+    // Regroup the bytes of n values of nb bytes each by byte position and back.
+    //
+    void
+    shuffle (const unsigned char* src,
+             long                 n,
+             int                  nb,
+             unsigned char*       dst)
+    {
+        for (int b = 0; b < nb; b++)
+            for (long i = 0; i < n; i++)
+                dst[b*n+i] = src[i*nb+b];
+    }
+
+    void
+    unshuffle (const unsigned char* src,
+               long                 n,
+               int                  nb,
+               unsigned char*       dst)
+    {
+        for (int b = 0; b < nb; b++)
+            for (long i = 0; i < n; i++)
+                dst[i*nb+b] = src[b*n+i];
+    }
+    //
+    // Convert n values of nb bytes each into Reals.
+    //
+    void
+    to_reals (const unsigned char* src,
+              long                 n,
+              int                  nb,
+              Real*                dst)
+    {
+        if (nb == sizeof(Real))
+        {
+            std::memcpy(dst, src, n*sizeof(Real));
+        }
+        else if (nb == sizeof(float))
+        {
+            for (long i = 0; i < n; i++)
+            {
+                float v;
+                std::memcpy(&v, src+i*nb, nb);
+                dst[i] = v;
+            }
+        }
+        else if (nb == sizeof(double))
+        {
+            for (long i = 0; i < n; i++)
+            {
+                double v;
+                std::memcpy(&v, src+i*nb, nb);
+                dst[i] = v;
+            }
+        }
+        else
+        {
+            BoxLib::Error("FabCompress: unsupported size of Real on disk");
+        }
+    }
+    //
+    // The largest quantized value we'll try to handle.
+    //
+    double
+    max_quantum ()
+    {
+        return std::min(4.5e15, double(std::numeric_limits<long>::max()/4));
+    }
+
+    bool
+    quantize (const Real*        src,
+              long               n,
+              Real               tol,
+              std::vector<char>& dst,
+              double&            step)
+    {
+        step = 2*double(tol);
+
+        const double qmax = max_quantum();
+
+        std::vector<unsigned char> bytes;
+
+        bytes.reserve(n);
+
+        long prev = 0;
+
+        for (long i = 0; i < n; i++)
+        {
+            const double v = src[i];
+            const double r = v / step;
+            //
+            // This is false for NaNs too.
+            //
+            if (!(std::fabs(r) < qmax)) return false;
+
+            const long q = long(std::floor(r + 0.5));
+
+            if (std::fabs(v - double(Real(q*step))) > tol) return false;
+
+            const long    d = q - prev;
+            unsigned long z = (d >= 0) ? (unsigned long)(d) << 1 : ((unsigned long)(-(d+1)) << 1) | 1;
+
+            for ( ; z >= 0x80; z >>= 7)
+                bytes.push_back((unsigned char)(z | 0x80));
+            bytes.push_back((unsigned char)(z));
+
+            prev = q;
+        }
+
+        const long nbytes = bytes.size();
+
+        dst.resize(sizeof(long));
+
+        std::memcpy(&dst[0], &nbytes, sizeof(long));
+
+        FabCompress::lz_compress(nbytes == 0 ? 0 : &bytes[0], nbytes, dst);
+
+        return true;
+    }
+}
+
+void
+FabCompress::lz_compress (const unsigned char* src,
+                          long                 n,
+                          std::vector<char>&   dst)
+{
+    std::vector<long> table(1 << HashLog, -1);
+
+    long anchor = 0, i = 0;
+
+    const long limit = n - LastLiterals - MinMatch;
+
+    while (i <= limit)
+    {
+        const unsigned int seq  = read32(src+i);
+        const unsigned int h    = hash32(seq);
+        const long         cand = table[h];
+
+        table[h] = i;
+
+        if (cand >= 0 && i - cand <= MaxOffset && read32(src+cand) == seq)
+        {
+            long len = MinMatch;
+
+            while (i + len < n - LastLiterals && src[cand+len] == src[i+len])
+                len++;
+
+            put_sequence(dst, src+anchor, i-anchor, i-cand, len);
+
+            i += len;
+
+            anchor = i;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    put_sequence(dst, src+anchor, n-anchor, 0, 0);
+}
+
+long
+FabCompress::lz_decompress (const unsigned char* src,
+                            long                 n,
+                            unsigned char*       dst,
+                            long                 ndst)
+{
+    const unsigned char*       ip   = src;
+    const unsigned char* const iend = src + n;
+    unsigned char*             op   = dst;
+    unsigned char* const       oend = dst + ndst;
+
+    while (ip < iend)
+    {
+        const unsigned char token = *ip++;
+
+        long nlit = token >> 4;
+
+        if (nlit == 15)
+            nlit += get_length(ip, iend);
+
+        if (nlit > iend - ip || nlit > oend - op)
+            BoxLib::Error("FabCompress: corrupt LZ stream");
+
+        std::memcpy(op, ip, nlit);
+
+        ip += nlit; op += nlit;
+
+        if (ip == iend) break;
+
+        if (iend - ip < 2)
+            BoxLib::Error("FabCompress: corrupt LZ stream");
+
+        const long offset = long(ip[0]) | (long(ip[1]) << 8);
+
+        ip += 2;
+
+        long mlen = token & 0xf;
+
+        if (mlen == 15)
+            mlen += get_length(ip, iend);
+
+        mlen += MinMatch;
+
+        if (offset == 0 || offset > op - dst || mlen > oend - op)
+            BoxLib::Error("FabCompress: corrupt LZ stream");
+        //
+        // The match may overlap what we're writing so copy a byte at a time.
+        //
+        const unsigned char* mp = op - offset;
+
+        for (long k = 0; k < mlen; k++)
+            *op++ = *mp++;
+    }
+
+    return op - dst;
+}
+
+int
+FabCompress::compress (const Real*        src,
+                       long               n,
+                       Real               tol,
+                       std::vector<char>& dst,
+                       double&            param)
+{
+    BL_ASSERT(n >= 0);
+
+    const long raw = n*sizeof(Real);
+
+    param = 0;
+
+    dst.clear();
+
+    if (n > 0 && tol > 0)
+    {
+        if (quantize(src, n, tol, dst, param) && long(dst.size()) < raw)
+            return Quantize_LZ;
+
+        dst.clear();
+
+        param = 0;
+    }
+
+    if (n > 0)
+    {
+        std::vector<unsigned char> tmp(raw);
+
+        shuffle(reinterpret_cast<const unsigned char*>(src), n, sizeof(Real), &tmp[0]);
+
+        lz_compress(&tmp[0], raw, dst);
+
+        if (long(dst.size()) < raw)
+            return Shuffle_LZ;
+    }
+
+    dst.assign(reinterpret_cast<const char*>(src), reinterpret_cast<const char*>(src)+raw);
+
+    return Stored;
+}
+
+void
+FabCompress::decompress (int         codec,
+                         double      param,
+                         const char* src,
+                         long        nbytes,
+                         Real*       dst,
+                         long        n,
+                         int         nb)
+{
+    const unsigned char* usrc = reinterpret_cast<const unsigned char*>(src);
+
+    switch (codec)
+    {
+    case Stored:
+    {
+        if (nbytes != n*nb)
+            BoxLib::Error("FabCompress::decompress(): wrong number of bytes");
+
+        to_reals(usrc, n, nb, dst);
+
+        break;
+    }
+    case Shuffle_LZ:
+    {
+        if (n == 0) break;
+
+        std::vector<unsigned char> tmp(n*nb), bytes(n*nb);
+
+        if (lz_decompress(usrc, nbytes, &tmp[0], n*nb) != n*nb)
+            BoxLib::Error("FabCompress::decompress(): wrong number of bytes");
+
+        unshuffle(&tmp[0], n, nb, &bytes[0]);
+
+        to_reals(&bytes[0], n, nb, dst);
+
+        break;
+    }
+    case Quantize_LZ:
+    {
+        long len;
+
+        if (nbytes < long(sizeof(long)))
+            BoxLib::Error("FabCompress::decompress(): corrupt quantized data");
+
+        std::memcpy(&len, src, sizeof(long));
+
+        std::vector<unsigned char> bytes(len);
+
+        if (len > 0 && lz_decompress(usrc+sizeof(long), nbytes-sizeof(long), &bytes[0], len) != len)
+            BoxLib::Error("FabCompress::decompress(): wrong number of bytes");
+
+        long q = 0, j = 0;
+
+        for (long i = 0; i < n; i++)
+        {
+            unsigned long z = 0;
+
+            for (int shift = 0; ; shift += 7)
+            {
+                if (j >= len)
+                    BoxLib::Error("FabCompress::decompress(): corrupt quantized data");
+
+                const unsigned char c = bytes[j++];
+
+                z |= (unsigned long)(c & 0x7f) << shift;
+
+                if (!(c & 0x80)) break;
+            }
+
+            q += (z & 1) ? -long(z >> 1) - 1 : long(z >> 1);
+
+            dst[i] = Real(q*param);
+        }
+
+        break;
+    }
+    default:
+        BoxLib::Error("FabCompress::decompress(): unknown codec");
+    }
+}
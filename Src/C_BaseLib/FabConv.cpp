@@ -108,6 +108,12 @@ RealDescriptor::SetFixDenormals()
     bAlwaysFixDenormals = true;
 }
 
+bool
+RealDescriptor::GetFixDenormals ()
+{
+    return bAlwaysFixDenormals;
+}
+
 RealDescriptor*
 RealDescriptor::clone () const
 {
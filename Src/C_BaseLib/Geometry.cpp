@@ -92,6 +92,9 @@ Geometry::FPB::~FPB ()
     delete m_RcvTags;
     delete m_SndVols;
     delete m_RcvVols;
+
+    FabArrayBase::FreeCommBuffer(m_RcvBuf);
+    FabArrayBase::FreeCommBuffer(m_SndBuf);
 }
 
 bool
@@ -151,6 +154,8 @@ Geometry::FPB::bytes () const
         cnt += sizeof(std::map<int,int>) + m_RcvVols->size()*sizeof(std::map<int,int>::value_type);
     }
 
+    cnt += m_RcvBuf.m_size + m_SndBuf.m_size;
+
     return cnt;
 }
 
@@ -258,6 +263,34 @@ Geometry::FillPeriodicBoundary (MultiFab& mf,
     }
 }
 
+void
+Geometry::FillPeriodicBoundary_nowait (MultiFab& mf,
+                                       bool      do_corners) const
+{
+    FillPeriodicBoundary_nowait(mf,0,mf.nComp(),do_corners);
+}
+
+void
+Geometry::FillPeriodicBoundary_nowait (MultiFab& mf,
+                                       int       scomp,
+                                       int       ncomp,
+                                       bool      corners) const
+{
+    if (!isAnyPeriodic() || mf.nGrow() == 0 || mf.size() == 0) return;
+
+    BL_PROFILE("Geometry::FillPeriodicBoundary_nowait()");
+
+    BoxLib::FillPeriodicBoundary_nowait(*this, mf, scomp, ncomp, corners);
+}
+
+void
+Geometry::FillPeriodicBoundary_finish (MultiFab& mf) const
+{
+    BL_PROFILE("Geometry::FillPeriodicBoundary_finish()");
+
+    BoxLib::FillPeriodicBoundary_finish(*this, mf);
+}
+
 //
 // Some useful typedefs.
 //
@@ -0,0 +1,368 @@
+
+#include <winstd.H>
+#include <iostream>
+#include <iomanip>
+#include <deque>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <MemProfiler.H>
+#include <ParallelDescriptor.H>
+#include <ParmParse.H>
+
+namespace
+{
+    //
+    // Counter slots: one per tag, then all FAB bytes and all FAB cells.
+    //
+    const int FabBytesSlot = MemProfiler::NumTags;
+    const int FabCellsSlot = MemProfiler::NumTags + 1;
+    const int NumSlots     = MemProfiler::NumTags + 2;
+    //
+    // Each thread's counters, on cache lines of their own so that threads
+    // never write to the same line: what it has added less what it has
+    // removed, the high-water mark of that, and its allocation counts.
+    // A thread's current value goes negative when it frees what another
+    // thread allocated.  Threads beyond the first MaxThreads share the
+    // last entry under a lock.
+    //
+    const int MaxThreads = 256;
+
+    struct ThreadCounts
+    {
+        long cur[NumSlots];
+        long hwm[NumSlots];
+        long nalloc[MemProfiler::NumTags];
+        char pad[64 - ((2*NumSlots + MemProfiler::NumTags)*sizeof(long))%64];
+    };
+
+    ThreadCounts g_thread[MaxThreads+1];
+
+    int g_nthreads = 0;
+
+    int thread_slot = -1;
+    int current_tag = MemProfiler::Scratch;
+#ifdef _OPENMP
+#pragma omp threadprivate(thread_slot,current_tag)
+#endif
+
+    int verbose   = -1;
+    int max_steps = 10000;
+
+    struct StepStats
+    {
+        int  step;
+        long cur_max[NumSlots];
+        long hwm_min[NumSlots];
+        long hwm_max[NumSlots];
+        long nalloc[MemProfiler::NumTags];
+    };
+    //
+    // The last max_steps steps.
+    //
+    std::deque<StepStats> the_steps;
+    //
+    // This thread's entry in g_thread, handed out on first use.
+    //
+    inline
+    int
+    ThreadSlot ()
+    {
+        if (thread_slot < 0)
+        {
+#ifdef _OPENMP
+#pragma omp critical(memprofiler_slot)
+#endif
+            thread_slot = std::min(g_nthreads++, MaxThreads);
+        }
+
+        return thread_slot;
+    }
+
+    inline
+    void
+    Bump (ThreadCounts& tc,
+          int           slot,
+          long          delta)
+    {
+        const long c = (tc.cur[slot] += delta);
+
+        if (c > tc.hwm[slot])
+            tc.hwm[slot] = c;
+    }
+
+    void
+    Charge (int  tag,
+            long nbytes,
+            long ncells,
+            int  nalloc)
+    {
+        ThreadCounts& tc = g_thread[ThreadSlot()];
+
+        Bump(tc, tag, nbytes);
+
+        if (tag != MemProfiler::CommBuffer)
+        {
+            Bump(tc, FabBytesSlot, nbytes);
+
+            if (ncells != 0)
+                Bump(tc, FabCellsSlot, ncells);
+        }
+
+        tc.nalloc[tag] += nalloc;
+    }
+
+    inline
+    void
+    Update (int  tag,
+            long nbytes,
+            long ncells,
+            int  nalloc)
+    {
+        if (ThreadSlot() < MaxThreads)
+        {
+            Charge(tag, nbytes, ncells, nalloc);
+        }
+        else
+        {
+#ifdef _OPENMP
+#pragma omp critical(memprofiler_shared)
+#endif
+            Charge(tag, nbytes, ncells, nalloc);
+        }
+    }
+
+    long
+    SumCur (int slot)
+    {
+        long r = 0;
+
+        for (int i = 0; i <= MaxThreads; i++)
+            r += g_thread[i].cur[slot];
+
+        return r;
+    }
+
+    long
+    SumHWM (int slot)
+    {
+        long r = 0;
+
+        for (int i = 0; i <= MaxThreads; i++)
+            r += g_thread[i].hwm[slot];
+
+        return r;
+    }
+}
+
+const char*
+MemProfiler::TagName (int tag)
+{
+    switch (tag)
+    {
+    case Scratch:    return "Scratch";
+    case State:      return "State";
+    case CommBuffer: return "CommBuffer";
+    }
+    return "Unknown";
+}
+
+void
+MemProfiler::Add (int  tag,
+                  long nbytes,
+                  long ncells)
+{
+    BL_ASSERT(tag >= 0 && tag < NumTags);
+
+    Update(tag, nbytes, ncells, 1);
+}
+
+void
+MemProfiler::Remove (int  tag,
+                     long nbytes,
+                     long ncells)
+{
+    BL_ASSERT(tag >= 0 && tag < NumTags);
+
+    Update(tag, -nbytes, -ncells, 0);
+}
+
+long MemProfiler::Bytes (int tag)    { return SumCur(tag); }
+long MemProfiler::BytesHWM (int tag) { return SumHWM(tag); }
+long MemProfiler::FabBytes ()        { return SumCur(FabBytesSlot); }
+long MemProfiler::FabBytesHWM ()     { return SumHWM(FabBytesSlot); }
+long MemProfiler::FabCells ()        { return SumCur(FabCellsSlot); }
+long MemProfiler::FabCellsHWM ()     { return SumHWM(FabCellsSlot); }
+
+long
+MemProfiler::NumAllocs (int tag)
+{
+    long n = 0;
+
+    for (int i = 0; i <= MaxThreads; i++)
+        n += g_thread[i].nalloc[tag];
+
+    return n;
+}
+
+void
+MemProfiler::ResetHWM ()
+{
+    //
+    // Gather each total into the first entry.  That keeps the totals but
+    // forgets which threads allocated and which freed, so that frees by
+    // other threads than allocated don't go on inflating the marks.
+    //
+    for (int s = 0; s < NumSlots; s++)
+    {
+        const long c = SumCur(s);
+
+        for (int i = 0; i <= MaxThreads; i++)
+            g_thread[i].cur[s] = g_thread[i].hwm[s] = 0;
+
+        g_thread[0].cur[s] = g_thread[0].hwm[s] = c;
+    }
+}
+
+int
+MemProfiler::CurrentTag ()
+{
+    return current_tag;
+}
+
+MemProfiler::TagScope::TagScope (int tag)
+    :
+    m_prev(current_tag)
+{
+    BL_ASSERT(tag >= 0 && tag < NumTags);
+
+    current_tag = tag;
+}
+
+MemProfiler::TagScope::~TagScope ()
+{
+    current_tag = m_prev;
+}
+
+namespace
+{
+    //
+    // Reduces this step's counters over the CPUs, and on the IOProcessor
+    // records them if record and prints them if verbose.
+    //
+    void
+    ReduceAndReport (int  step,
+                     bool record)
+    {
+        const int IOProc = ParallelDescriptor::IOProcessorNumber();
+
+        StepStats s;
+
+        s.step = step;
+
+        for (int i = 0; i < NumSlots; i++)
+        {
+            s.cur_max[i] = SumCur(i);
+            s.hwm_min[i] = s.hwm_max[i] = SumHWM(i);
+        }
+        for (int t = 0; t < MemProfiler::NumTags; t++)
+            s.nalloc[t] = MemProfiler::NumAllocs(t);
+
+        ParallelDescriptor::ReduceLongMax(s.cur_max, NumSlots, IOProc);
+        ParallelDescriptor::ReduceLongMin(s.hwm_min, NumSlots, IOProc);
+        ParallelDescriptor::ReduceLongMax(s.hwm_max, NumSlots, IOProc);
+        ParallelDescriptor::ReduceLongSum(s.nalloc,  MemProfiler::NumTags,  IOProc);
+
+        if (ParallelDescriptor::IOProcessor())
+        {
+            if (record)
+            {
+                the_steps.push_back(s);
+
+                if (int(the_steps.size()) > max_steps)
+                    the_steps.pop_front();
+            }
+
+            if (verbose > 0)
+            {
+                std::cout << "\nMemProfiler: step " << step
+                          << ", high-water-mark kilobytes per CPU [min ... max], allocations:\n";
+
+                for (int t = 0; t < MemProfiler::NumTags; t++)
+                {
+                    std::cout << "    " << std::setw(10) << std::left << MemProfiler::TagName(t) << std::right
+                              << " [" << s.hwm_min[t]/1024 << " ... " << s.hwm_max[t]/1024 << "], "
+                              << s.nalloc[t] << '\n';
+                }
+                std::cout << "    " << std::setw(10) << std::left << "AllFabs" << std::right
+                          << " [" << s.hwm_min[FabBytesSlot]/1024 << " ... "
+                          << s.hwm_max[FabBytesSlot]/1024 << "]\n";
+            }
+        }
+    }
+}
+
+void
+MemProfiler::ReportStep (int step)
+{
+    if (verbose < 0)
+    {
+        ParmParse pp("memprof");
+
+        verbose = 0;
+
+        pp.query("verbose", verbose);
+        pp.query("max_steps", max_steps);
+    }
+    //
+    // Only BL_PROFILING builds keep the steps, so otherwise there's nothing
+    // to reduce unless we're printing.
+    //
+#ifdef BL_PROFILING
+    const bool record = (max_steps > 0);
+#else
+    const bool record = false;
+#endif
+
+    if (record || verbose > 0)
+        ReduceAndReport(step, record);
+
+    for (int i = 0; i <= MaxThreads; i++)
+        for (int t = 0; t < NumTags; t++)
+            g_thread[i].nalloc[t] = 0;
+
+    ResetHWM();
+}
+
+void
+MemProfiler::WriteStats (std::ostream& os)
+{
+    os << "# Per-CPU bytes reduced over CPUs for each step.\n"
+       << "# step";
+    for (int t = 0; t < NumTags; t++)
+    {
+        const char* name = TagName(t);
+        os << ' ' << name << "_cur_max "
+           << name << "_hwm_min " << name << "_hwm_max " << name << "_nallocs";
+    }
+    os << " AllFabs_cur_max AllFabs_hwm_min AllFabs_hwm_max AllFabs_cells_hwm_max\n";
+
+    for (int i = 0, N = the_steps.size(); i < N; i++)
+    {
+        const StepStats& s = the_steps[i];
+
+        os << s.step;
+        for (int t = 0; t < NumTags; t++)
+        {
+            os << ' ' << s.cur_max[t] << ' ' << s.hwm_min[t]
+               << ' ' << s.hwm_max[t] << ' ' << s.nalloc[t];
+        }
+        os << ' ' << s.cur_max[FabBytesSlot]
+           << ' ' << s.hwm_min[FabBytesSlot]
+           << ' ' << s.hwm_max[FabBytesSlot]
+           << ' ' << s.hwm_max[FabCellsSlot] << '\n';
+    }
+}
@@ -151,6 +151,86 @@ MultiFab::Divide (MultiFab&       dst,
     }
 }
 
+void
+MultiFab::Saxpy (MultiFab&       dst,
+                 Real            a,
+                 const MultiFab& src,
+                 int             srccomp,
+                 int             dstcomp,
+                 int             numcomp,
+                 int             nghost)
+{
+    BL_ASSERT(dst.boxArray() == src.boxArray());
+    BL_ASSERT(dst.distributionMap == src.distributionMap);
+    BL_ASSERT(dst.nGrow() >= nghost && src.nGrow() >= nghost);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(dst,true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.growntilebox(nghost);
+
+        if (bx.ok())
+            dst[mfi].saxpy(a, src[mfi], bx, bx, srccomp, dstcomp, numcomp);
+    }
+}
+
+void
+MultiFab::Xpay (MultiFab&       dst,
+                Real            a,
+                const MultiFab& src,
+                int             srccomp,
+                int             dstcomp,
+                int             numcomp,
+                int             nghost)
+{
+    BL_ASSERT(dst.boxArray() == src.boxArray());
+    BL_ASSERT(dst.distributionMap == src.distributionMap);
+    BL_ASSERT(dst.nGrow() >= nghost && src.nGrow() >= nghost);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(dst,true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.growntilebox(nghost);
+
+        if (bx.ok())
+            dst[mfi].xpay(a, src[mfi], bx, bx, srccomp, dstcomp, numcomp);
+    }
+}
+
+void
+MultiFab::LinComb (MultiFab&       dst,
+                   Real            a,
+                   const MultiFab& x,
+                   int             xcomp,
+                   Real            b,
+                   const MultiFab& y,
+                   int             ycomp,
+                   int             dstcomp,
+                   int             numcomp,
+                   int             nghost)
+{
+    BL_ASSERT(dst.boxArray() == x.boxArray());
+    BL_ASSERT(dst.boxArray() == y.boxArray());
+    BL_ASSERT(dst.distributionMap == x.distributionMap);
+    BL_ASSERT(dst.distributionMap == y.distributionMap);
+    BL_ASSERT(dst.nGrow() >= nghost && x.nGrow() >= nghost && y.nGrow() >= nghost);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(dst,true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.growntilebox(nghost);
+
+        if (bx.ok())
+            dst[mfi].linComb(x[mfi], bx, xcomp, y[mfi], bx, ycomp, a, b, bx, dstcomp, numcomp);
+    }
+}
+
 void
 MultiFab::plus (Real val,
                 int  nghost)
@@ -751,7 +831,7 @@ MultiFab::norm0 (int comp, const BoxArray& ba) const
 }
 
 Real
-MultiFab::norm0 (int comp) const
+MultiFab::norm0 (int comp, bool local) const
 {
     Real nm0 = -std::numeric_limits<Real>::max();
 
@@ -772,7 +852,8 @@ MultiFab::norm0 (int comp) const
 	}
     }
 
-    ParallelDescriptor::ReduceRealMax(nm0);
+    if (!local)
+        ParallelDescriptor::ReduceRealMax(nm0);
 
     return nm0;
 }
@@ -869,7 +950,7 @@ MultiFab::norm2 (const Array<int>& comps) const
 }
  
 Real
-MultiFab::norm1 (int comp, int ngrow) const
+MultiFab::norm1 (int comp, int ngrow, bool local) const
 {
     Real nm1 = 0.e0;
 
@@ -881,7 +962,8 @@ MultiFab::norm1 (int comp, int ngrow) const
         nm1 += get(mfi).norm(mfi.growntilebox(ngrow), 1, comp, 1);
     }
 
-    ParallelDescriptor::ReduceRealSum(nm1);
+    if (!local)
+        ParallelDescriptor::ReduceRealSum(nm1);
 
     return nm1;
 }
@@ -1344,7 +1426,7 @@ MultiFab::SumBoundary (int scomp,
 
     BL_ASSERT(cache_it != FabArrayBase::m_TheFBCache.end());
 
-    const FabArrayBase::SI& TheSI = cache_it->second;
+    FabArrayBase::SI& TheSI = cache_it->second;
 
     if (ParallelDescriptor::NProcs() == 1)
     {
@@ -1380,16 +1462,17 @@ MultiFab::SumBoundary (int scomp,
     Array<Real*>       recv_data;
     Array<MPI_Request> recv_reqs;
     //
-    // Post rcvs. Allocate one chunk of space to hold'm all.
+    // Post rcvs into one chunk of space.  We borrow the FillBoundary()
+    // buffers of the SI; they don't care which way the data goes.
     //
-    Real* the_recv_data = 0;
+    FabArrayBase::CommBuffer recv_buf, send_buf;
 
-    FabArrayBase::PostRcvs(*TheSI.m_SndTags,*TheSI.m_SndVols,the_recv_data,recv_data,recv_from,recv_reqs,ncomp,SeqNum);
+    FabArrayBase::PostRcvs(*TheSI.m_SndTags,*TheSI.m_SndVols,TheSI.m_RcvBuf,recv_buf,recv_data,recv_from,recv_reqs,ncomp,SeqNum);
 
     //
     // Post send's
     //
-    const int N_snds = TheSI.m_SndTags->size();
+    const int N_snds = TheSI.m_RcvTags->size();
 
     Array<Real*>                       send_data;
     Array<int>                         send_N;
@@ -1401,6 +1484,11 @@ MultiFab::SumBoundary (int scomp,
     send_rank.reserve(N_snds);
     send_cctc.reserve(N_snds);
 
+    send_buf = FabArrayBase::CheckOutCommBuffer(TheSI.m_SndBuf,
+                                                FabArrayBase::TotalVolume(*TheSI.m_RcvVols)*ncomp*sizeof(Real));
+
+    Real* the_send_data = static_cast<Real*>(send_buf.m_ptr);
+
     for (MapOfCopyComTagContainers::const_iterator m_it = TheSI.m_RcvTags->begin(),
              m_End = TheSI.m_RcvTags->end();
          m_it != m_End;
@@ -1414,12 +1502,12 @@ MultiFab::SumBoundary (int scomp,
 
         BL_ASSERT(N < std::numeric_limits<int>::max());
 
-        Real* data = static_cast<Real*>(BoxLib::The_Arena()->alloc(N*sizeof(Real)));
-
-	send_data.push_back(data);
+	send_data.push_back(the_send_data);
 	send_N   .push_back(N);
 	send_rank.push_back(m_it->first);
 	send_cctc.push_back(&(m_it->second));
+
+        the_send_data += N;
     }
 
 #ifdef _OPENMP
@@ -1455,7 +1543,6 @@ MultiFab::SumBoundary (int scomp,
     } else {
 	for (int i=0; i<N_snds; ++i) {
             ParallelDescriptor::Send(send_data[i],send_N[i],send_rank[i],SeqNum);
-            BoxLib::The_Arena()->free(send_data[i]);
         }
     }
 
@@ -1477,7 +1564,7 @@ MultiFab::SumBoundary (int scomp,
     //
     //  wait and unpack
     //
-    const int N_rcvs = TheSI.m_RcvTags->size();
+    const int N_rcvs = TheSI.m_SndTags->size();
 
     if (N_rcvs > 0)
     {
@@ -1521,10 +1608,11 @@ MultiFab::SumBoundary (int scomp,
         }
     }
 
-    BoxLib::The_Arena()->free(the_recv_data);
-
     if (FabArrayBase::do_async_sends && !TheSI.m_RcvTags->empty())
-        FabArrayBase::GrokAsyncSends(TheSI.m_RcvTags->size(),send_reqs,send_data,stats);
+        FabArrayBase::WaitAsyncSends(TheSI.m_RcvTags->size(),send_reqs,stats);
+
+    FabArrayBase::ReturnCommBuffer(TheSI.m_RcvBuf,recv_buf);
+    FabArrayBase::ReturnCommBuffer(TheSI.m_SndBuf,send_buf);
 
 #endif /*BL_USE_MPI*/
 }
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <algorithm>
 
 #include <Utility.H>
 #include <BLProfiler.H>
@@ -39,6 +40,16 @@ namespace ParallelDescriptor
     MPI_Group m_group_perfmon = MPI_GROUP_NULL;
 
     int m_MinTag = 1000, m_MaxTag = -1;
+    //
+    // The next tag SeqNum() will hand out.
+    //
+    int m_SeqNo = m_MinTag;
+    //
+    // What StartSubCommunicator() replaced.
+    //
+    MPI_Comm m_comm_comp_save    = MPI_COMM_NULL;
+    int      m_nProcs_comp_save  = -1;
+    int      m_SeqNo_save        = -1;
 
     const int ioProcessor = 0;
 
@@ -164,6 +175,41 @@ operator<< (std::ostream&                              os,
 }
 #endif
 
+int
+ParallelDescriptor::ReduceBatch::addSum (Real r)
+{
+    BL_ASSERT(!m_posted);
+    m_buf.push_back(r);
+    m_buf.push_back(0);
+    m_val.push_back(r);
+    return m_val.size() - 1;
+}
+
+int
+ParallelDescriptor::ReduceBatch::addMax (Real r)
+{
+    BL_ASSERT(!m_posted);
+    m_buf.push_back(r);
+    m_buf.push_back(1);
+    m_val.push_back(r);
+    return m_val.size() - 1;
+}
+
+void
+ParallelDescriptor::ReduceBatch::reduce ()
+{
+    post();
+    wait();
+}
+
+void
+ParallelDescriptor::ReduceBatch::clear ()
+{
+    BL_ASSERT(!m_posted);
+    m_val.clear();
+    m_buf.clear();
+}
+
 #ifdef BL_USE_MPI
 
 #include <ccse-mpi.H>
@@ -190,7 +236,27 @@ namespace
 	}
 	return buf;
     }
+    //
+    // Used by ReduceBatch: each element is a (value,op) pair where
+    // op is 0 for a sum and 1 for a max.
+    //
+    MPI_Datatype reduce_batch_type = MPI_DATATYPE_NULL;
+    MPI_Op       reduce_batch_op   = MPI_OP_NULL;
 
+    void
+    ReduceBatchOp (void* invec, void* inoutvec, int* len, MPI_Datatype*)
+    {
+        const Real* in  = static_cast<const Real*>(invec);
+        Real*       out = static_cast<Real*>(inoutvec);
+
+        for (int i = 0, N = 2 * *len; i < N; i += 2)
+        {
+            if (out[i+1] == 0)
+                out[i] += in[i];
+            else
+                out[i] = std::max(out[i],in[i]);
+        }
+    }
 }
 
 namespace ParallelDescriptor
@@ -378,6 +444,12 @@ ParallelDescriptor::EndParallel ()
     BL_ASSERT(m_MyId_all != -1);
     BL_ASSERT(m_nProcs_all != -1);
 
+    if (reduce_batch_op != MPI_OP_NULL)
+    {
+        BL_MPI_REQUIRE( MPI_Op_free(&reduce_batch_op) );
+        BL_MPI_REQUIRE( MPI_Type_free(&reduce_batch_type) );
+    }
+
     BL_MPI_REQUIRE( MPI_Finalize() );
 }
 
@@ -439,6 +511,90 @@ ParallelDescriptor::Comm_dup (MPI_Comm comm, MPI_Comm& newcomm)
     BL_MPI_REQUIRE( MPI_Comm_dup(comm, &newcomm) );
 }
 
+void
+ParallelDescriptor::Comm_free (MPI_Comm& comm)
+{
+    if (comm != MPI_COMM_NULL)
+        BL_MPI_REQUIRE( MPI_Comm_free(&comm) );
+}
+
+MPI_Comm
+ParallelDescriptor::SubCommunicator (int nprocs)
+{
+    BL_PROFILE_S("ParallelDescriptor::SubCommunicator()");
+    BL_ASSERT(nprocs > 0 && nprocs <= NProcs());
+
+    const int color = (MyProc() < nprocs) ? 0 : MPI_UNDEFINED;
+
+    MPI_Comm comm;
+
+    BL_MPI_REQUIRE( MPI_Comm_split(Communicator(), color, MyProc(), &comm) );
+
+    return comm;
+}
+
+ParallelDescriptor::ReduceBatch::~ReduceBatch ()
+{
+    if (m_posted) wait();
+}
+
+void
+ParallelDescriptor::ReduceBatch::post ()
+{
+    BL_PROFILE_S("ParallelDescriptor::ReduceBatch::post()");
+    BL_ASSERT(!m_posted);
+
+    if (m_val.empty()) return;
+
+    if (reduce_batch_op == MPI_OP_NULL)
+    {
+        BL_MPI_REQUIRE( MPI_Type_contiguous(2, Mpi_typemap<Real>::type(), &reduce_batch_type) );
+        BL_MPI_REQUIRE( MPI_Type_commit(&reduce_batch_type) );
+        BL_MPI_REQUIRE( MPI_Op_create(ReduceBatchOp, 1, &reduce_batch_op) );
+    }
+
+    BL_COMM_PROFILE_ALLREDUCE(BLProfiler::AllReduceR, BLProfiler::BeforeCall(), true);
+
+    m_posted = true;
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    BL_MPI_REQUIRE( MPI_Iallreduce(MPI_IN_PLACE,
+                                   m_buf.dataPtr(),
+                                   m_val.size(),
+                                   reduce_batch_type,
+                                   reduce_batch_op,
+                                   Communicator(),
+                                   &m_req) );
+#else
+    BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE,
+                                  m_buf.dataPtr(),
+                                  m_val.size(),
+                                  reduce_batch_type,
+                                  reduce_batch_op,
+                                  Communicator()) );
+#endif
+}
+
+void
+ParallelDescriptor::ReduceBatch::wait ()
+{
+    BL_PROFILE_S("ParallelDescriptor::ReduceBatch::wait()");
+
+    if (!m_posted) return;
+
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    MPI_Status status;
+    BL_MPI_REQUIRE( MPI_Wait(&m_req, &status) );
+#endif
+
+    BL_COMM_PROFILE_ALLREDUCE(BLProfiler::AllReduceR, m_val.size() * sizeof(Real), false);
+
+    m_posted = false;
+
+    for (int i = 0, N = m_val.size(); i < N; i++)
+        m_val[i] = m_buf[2*i];
+}
+
 void
 ParallelDescriptor::util::DoAllReduceReal (Real&  r,
                                            MPI_Op op)
@@ -1190,6 +1346,10 @@ ParallelDescriptor::Message::test ()
 
 void ParallelDescriptor::EndParallel () {}
 
+ParallelDescriptor::ReduceBatch::~ReduceBatch () {}
+void ParallelDescriptor::ReduceBatch::post () {}
+void ParallelDescriptor::ReduceBatch::wait () {}
+
 void ParallelDescriptor::Abort ()
 { 
 #ifdef WIN32
@@ -1213,6 +1373,10 @@ void ParallelDescriptor::Barrier (const std::string &message) {}
 void ParallelDescriptor::Barrier (MPI_Comm, const std::string &message) {}
 
 void ParallelDescriptor::Test (MPI_Request&, int&, MPI_Status&) {}
+
+void ParallelDescriptor::Comm_free (MPI_Comm&) {}
+
+MPI_Comm ParallelDescriptor::SubCommunicator (int) { return m_comm_comp; }
 void ParallelDescriptor::IProbe (int, int, int&, MPI_Status&) {}
 
 void ParallelDescriptor::Comm_dup (MPI_Comm, MPI_Comm&) {}
@@ -1297,18 +1461,50 @@ ParallelDescriptor::Waitsome (Array<MPI_Request>& reqs,
 int
 ParallelDescriptor::SeqNum ()
 {
-    static int seqno = m_MinTag;
+    int result = m_SeqNo++;
 
-    int result = seqno++;
-
-    if (seqno > m_MaxTag) {
-      seqno = m_MinTag;
+    if (m_SeqNo > m_MaxTag) {
+      m_SeqNo = m_MinTag;
       BL_COMM_PROFILE_TAGWRAP();
     }
 
     return result;
 }
 
+void
+ParallelDescriptor::StartSubCommunicator (MPI_Comm comm)
+{
+    BL_ASSERT(comm != MPI_COMM_NULL || NProcs() == 1);
+    BL_ASSERT(m_nProcs_comp_save == -1);
+
+    m_comm_comp_save   = m_comm_comp;
+    m_nProcs_comp_save = m_nProcs_comp;
+    m_SeqNo_save       = m_SeqNo;
+
+#ifdef BL_USE_MPI
+    int rank;
+    BL_MPI_REQUIRE( MPI_Comm_rank(comm, &rank) );
+    BL_MPI_REQUIRE( MPI_Comm_size(comm, &m_nProcs_comp) );
+    if (rank != m_MyId_comp)
+        BoxLib::Abort("ParallelDescriptor::StartSubCommunicator(): processor numbers differ");
+#endif
+
+    m_comm_comp = comm;
+}
+
+void
+ParallelDescriptor::EndSubCommunicator ()
+{
+    BL_ASSERT(m_nProcs_comp_save != -1);
+
+    m_comm_comp   = m_comm_comp_save;
+    m_nProcs_comp = m_nProcs_comp_save;
+    m_SeqNo       = m_SeqNo_save;
+
+    m_comm_comp_save   = MPI_COMM_NULL;
+    m_nProcs_comp_save = -1;
+}
+
 
 #include <BLFort.H>
 
@@ -0,0 +1,437 @@
+
+#include <winstd.H>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <TArena.H>
+#include <BLassert.H>
+#include <Utility.H>
+
+namespace
+{
+    //
+    // Every block starts with a header recording where it came from.
+    // It's a full cache line so the memory we hand out stays 64-byte aligned.
+    //
+    struct Header
+    {
+        int         m_class;
+        int         m_kind;
+        std::size_t m_size;
+        std::size_t m_nbytes;
+    };
+
+    const std::size_t HeaderSize = 64;
+
+    enum { Heap = 0, Mapped = 1 };
+    //
+    // The smallest size class is 2^MinClassShift bytes.
+    //
+    const int MinClassShift      = 6;
+    const int ClassesPerDoubling = 4;
+
+    inline Header* header_of (void* raw) { return static_cast<Header*>(raw); }
+}
+
+TArena::TArena (std::size_t thread_cache_size,
+                std::size_t max_cached_size,
+                bool        use_huge_pages,
+                std::size_t huge_page_size)
+    :
+    m_thread_cache_size(thread_cache_size),
+    m_use_huge_pages(use_huge_pages),
+    m_huge_page_size(huge_page_size)
+{
+    BL_ASSERT(sizeof(Header) <= HeaderSize);
+
+    m_nclass     = size_class(max_cached_size) + 1;
+    m_max_cached = class_size(m_nclass-1);
+
+#ifdef _OPENMP
+    m_nthreads = omp_get_max_threads();
+#else
+    m_nthreads = 1;
+#endif
+
+    m_cache.resize(m_nthreads);
+
+    for (int i = 0; i < m_nthreads; i++)
+        m_cache[i].m_bins.resize(m_nclass);
+
+    m_central.resize(m_nclass);
+    //
+    // The last one is for threads without a cache of their own.
+    //
+    m_stats.resize(m_nthreads+1);
+
+    m_claimed.resize(m_nthreads, 0);
+
+    pthread_key_create(&m_slot_key, 0);
+    pthread_mutex_init(&m_shared_lock, 0);
+    pthread_mutex_init(&m_central_lock, 0);
+}
+
+TArena::~TArena ()
+{
+    for (int i = 0; i < m_nthreads; i++)
+        for (int c = 0; c < m_nclass; c++)
+            for (int j = 0, N = m_cache[i].m_bins[c].size(); j < N; j++)
+            {
+                const Header* hdr = header_of(m_cache[i].m_bins[c][j]);
+                raw_free(m_cache[i].m_bins[c][j], hdr->m_size, hdr->m_kind);
+            }
+
+    for (int c = 0; c < m_nclass; c++)
+        for (int j = 0, N = m_central[c].size(); j < N; j++)
+        {
+            const Header* hdr = header_of(m_central[c][j]);
+            raw_free(m_central[c][j], hdr->m_size, hdr->m_kind);
+        }
+
+    pthread_key_delete(m_slot_key);
+    pthread_mutex_destroy(&m_shared_lock);
+    pthread_mutex_destroy(&m_central_lock);
+}
+
+int
+TArena::size_class (std::size_t sz)
+{
+    if (sz <= (std::size_t(1) << MinClassShift))
+        return 0;
+    //
+    // Find p such that 2^p < sz <= 2^(p+1) and then which quarter
+    // of (2^p, 2^(p+1)] sz falls in.
+    //
+    int p = 0;
+
+    for (std::size_t s = sz - 1; s > 1; s >>= 1)
+        p++;
+
+    const std::size_t step = std::size_t(1) << (p - 2);
+    const std::size_t m    = (sz - (std::size_t(1) << p) + step - 1) / step;
+
+    return (p - MinClassShift) * ClassesPerDoubling + int(m);
+}
+
+std::size_t
+TArena::class_size (int c)
+{
+    if (c == 0)
+        return std::size_t(1) << MinClassShift;
+
+    const int p = MinClassShift + (c - 1) / ClassesPerDoubling;
+    const int m = (c - 1) % ClassesPerDoubling + 1;
+
+    return (std::size_t(1) << p) + m * (std::size_t(1) << (p - 2));
+}
+
+int
+TArena::thread_slot ()
+{
+    //
+    // The slot plus one, so zero means we haven't got one yet.
+    //
+    const long have = reinterpret_cast<long>(pthread_getspecific(m_slot_key));
+
+    if (have > 0)
+        return int(have - 1);
+    //
+    // Thread numbers aren't unique across threads that aren't in the same
+    // OpenMP team, e.g. in nested regions or threads of our own, which
+    // all think they're thread 0, so the first to ask for one gets it.
+    //
+#ifdef _OPENMP
+    const int tid = omp_get_thread_num();
+#else
+    const int tid = 0;
+#endif
+
+    int slot = m_nthreads;
+
+    pthread_mutex_lock(&m_shared_lock);
+
+    if (tid < m_nthreads && !m_claimed[tid])
+    {
+        m_claimed[tid] = 1;
+
+        slot = tid;
+    }
+
+    pthread_mutex_unlock(&m_shared_lock);
+
+    pthread_setspecific(m_slot_key, reinterpret_cast<void*>(long(slot + 1)));
+
+    return slot;
+}
+
+void*
+TArena::alloc (std::size_t nbytes)
+{
+    const int slot = thread_slot();
+
+    if (slot < m_nthreads)
+        return alloc_doit(nbytes, slot);
+
+    pthread_mutex_lock(&m_shared_lock);
+
+    void* vp = alloc_doit(nbytes, slot);
+
+    pthread_mutex_unlock(&m_shared_lock);
+
+    return vp;
+}
+
+void
+TArena::free (void* vp)
+{
+    if (vp == 0)
+        //
+        // Allow calls with NULL as allowed by C++ delete.
+        //
+        return;
+
+    const int slot = thread_slot();
+
+    if (slot < m_nthreads)
+    {
+        free_doit(vp, slot);
+    }
+    else
+    {
+        pthread_mutex_lock(&m_shared_lock);
+
+        free_doit(vp, slot);
+
+        pthread_mutex_unlock(&m_shared_lock);
+    }
+}
+
+void*
+TArena::alloc_doit (std::size_t nbytes,
+                    int         slot)
+{
+    Stats& stats = m_stats[slot];
+
+    const std::size_t total = HeaderSize + Arena::align(nbytes == 0 ? 1 : nbytes);
+
+    const int c = (total <= m_max_cached) ? size_class(total) : -1;
+
+    void* raw = 0;
+
+    if (c >= 0)
+    {
+        if (slot < m_nthreads && !m_cache[slot].m_bins[c].empty())
+        {
+            std::vector<void*>& bin = m_cache[slot].m_bins[c];
+
+            raw = bin.back();
+
+            bin.pop_back();
+
+            m_cache[slot].m_bytes -= class_size(c);
+
+            stats.m_thread_hits++;
+        }
+        else
+        {
+            pthread_mutex_lock(&m_central_lock);
+
+            if (!m_central[c].empty())
+            {
+                raw = m_central[c].back();
+                m_central[c].pop_back();
+            }
+
+            pthread_mutex_unlock(&m_central_lock);
+
+            if (raw != 0)
+                stats.m_central_hits++;
+        }
+    }
+
+    if (raw == 0)
+    {
+        const std::size_t sz = (c >= 0) ? class_size(c) : total;
+
+        int kind = Heap;
+
+        raw = raw_alloc(sz, kind);
+
+        Header* hdr = header_of(raw);
+
+        hdr->m_class = c;
+        hdr->m_kind  = kind;
+        hdr->m_size  = sz;
+
+        stats.m_misses++;
+        stats.m_heap += sz;
+    }
+
+    Header* hdr = header_of(raw);
+
+    hdr->m_nbytes = nbytes;
+
+    stats.m_in_use    += hdr->m_size;
+    stats.m_requested += nbytes;
+
+    return static_cast<char*>(raw) + HeaderSize;
+}
+
+void
+TArena::free_doit (void* vp,
+                   int   slot)
+{
+    Stats& stats = m_stats[slot];
+
+    void* raw = static_cast<char*>(vp) - HeaderSize;
+
+    const Header* hdr = header_of(raw);
+
+    const int         c  = hdr->m_class;
+    const std::size_t sz = hdr->m_size;
+
+    BL_ASSERT(c < m_nclass);
+
+    stats.m_in_use    -= sz;
+    stats.m_requested -= hdr->m_nbytes;
+
+    if (c < 0)
+    {
+        stats.m_heap -= sz;
+
+        raw_free(raw, sz, hdr->m_kind);
+    }
+    else if (slot < m_nthreads && m_cache[slot].m_bytes + sz <= m_thread_cache_size)
+    {
+        m_cache[slot].m_bins[c].push_back(raw);
+
+        m_cache[slot].m_bytes += sz;
+    }
+    else
+    {
+        pthread_mutex_lock(&m_central_lock);
+
+        m_central[c].push_back(raw);
+
+        pthread_mutex_unlock(&m_central_lock);
+    }
+}
+
+void*
+TArena::raw_alloc (std::size_t sz,
+                   int&        kind)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (m_use_huge_pages && sz >= m_huge_page_size)
+    {
+        void* p = ::mmap(0, sz, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+        if (p != MAP_FAILED)
+        {
+            //
+            // Only a hint -- we still get memory if the kernel says no.
+            //
+            ::madvise(p, sz, MADV_HUGEPAGE);
+
+            kind = Mapped;
+
+            return p;
+        }
+    }
+#endif
+
+    void* p = 0;
+
+    if (posix_memalign(&p, HeaderSize, sz) != 0)
+        BoxLib::OutOfMemory();
+
+    kind = Heap;
+
+    return p;
+}
+
+void
+TArena::raw_free (void*       p,
+                  std::size_t sz,
+                  int         kind)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (kind == Mapped)
+    {
+        ::munmap(p, sz);
+        return;
+    }
+#endif
+    ::free(p);
+}
+
+std::size_t
+TArena::heap_space_used () const
+{
+    long r = 0;
+
+    for (int i = 0, N = m_stats.size(); i < N; i++)
+        r += m_stats[i].m_heap;
+
+    return r;
+}
+
+std::size_t
+TArena::heap_space_actually_used () const
+{
+    long r = 0;
+
+    for (int i = 0, N = m_stats.size(); i < N; i++)
+        r += m_stats[i].m_in_use;
+
+    return r;
+}
+
+double
+TArena::hit_rate () const
+{
+    long hits = 0, total = 0;
+
+    for (int i = 0, N = m_stats.size(); i < N; i++)
+    {
+        hits  += m_stats[i].m_thread_hits + m_stats[i].m_central_hits;
+        total += m_stats[i].m_thread_hits + m_stats[i].m_central_hits + m_stats[i].m_misses;
+    }
+
+    return total > 0 ? double(hits)/total : 0;
+}
+
+double
+TArena::thread_hit_rate () const
+{
+    long hits = 0, total = 0;
+
+    for (int i = 0, N = m_stats.size(); i < N; i++)
+    {
+        hits  += m_stats[i].m_thread_hits;
+        total += m_stats[i].m_thread_hits + m_stats[i].m_central_hits + m_stats[i].m_misses;
+    }
+
+    return total > 0 ? double(hits)/total : 0;
+}
+
+double
+TArena::fragmentation () const
+{
+    long heap = 0, requested = 0;
+
+    for (int i = 0, N = m_stats.size(); i < N; i++)
+    {
+        heap      += m_stats[i].m_heap;
+        requested += m_stats[i].m_requested;
+    }
+
+    return heap > 0 ? 1 - double(requested)/heap : 0;
+}
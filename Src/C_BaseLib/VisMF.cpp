@@ -1,10 +1,21 @@
 
 #include <winstd.H>
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <sstream>
 #include <vector>
 #include <deque>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 //
 // This MUST be defined if don't have pubsetbuf() in I/O Streams Library.
 //
@@ -13,14 +24,18 @@
 #endif
 
 #include <ccse-mpi.H>
+#include <FPC.H>
 #include <Utility.H>
 #include <VisMF.H>
 #include <ParmParse.H>
+#include <MemProfiler.H>
 
 static const char* TheMultiFabHdrFileSuffix = "_H";
 
 static const char* TheFabOnDiskPrefix = "FabOnDisk:";
 
+static const char* FabFileSuffix = "_D_";
+
 int VisMF::verbose = 1;
 
 //
@@ -29,11 +44,483 @@ int VisMF::verbose = 1;
 int VisMF::nOutFiles(64);
 int VisMF::nMFFileInStreams(1);
 
+bool VisMF::async_write(false);
+
+int VisMF::aggregators_per_node(0);
+
+bool VisMF::chunked_read(false);
+
 namespace
 {
     bool initialized = false;
 }
 
+namespace
+{
+    //
+    // A block of bytes for the writer thread to put at m_offset in m_file.
+    // If m_trunc the file is truncated first.  Otherwise the file is cut
+    // to m_length bytes afterwards in case we're overwriting a longer one.
+    // CPUs sharing a file all pass the same m_length, so no one cuts off
+    // anyone else's data.
+    //
+    struct AsyncJob
+    {
+        std::string m_file;
+        long        m_offset;
+        long        m_length;
+        bool        m_trunc;
+        std::string m_data;
+    };
+
+    pthread_mutex_t       async_mutex   = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t        async_cond    = PTHREAD_COND_INITIALIZER;
+    pthread_t             async_thread;
+    bool                  async_running = false;
+    bool                  async_busy    = false;
+    bool                  async_quit    = false;
+    int                   async_errors  = 0;
+    std::deque<AsyncJob*> async_jobs;
+    //
+    // Write all len bytes of buf at off in fd.
+    //
+    bool
+    WriteAt (int         fd,
+             const char* buf,
+             std::size_t len,
+             off_t       off)
+    {
+        while (len > 0)
+        {
+            const ssize_t n = ::pwrite(fd, buf, len, off);
+
+            if (n < 0)
+            {
+                if (errno != EINTR) return false;
+                continue;
+            }
+            buf += n; len -= n; off += n;
+        }
+
+        return true;
+    }
+
+    bool
+    AsyncDoit (const AsyncJob& job)
+    {
+        int flags = O_WRONLY|O_CREAT;
+
+        if (job.m_trunc) flags |= O_TRUNC;
+
+        const int fd = ::open(job.m_file.c_str(), flags, 0666);
+
+        if (fd < 0) return false;
+
+        bool ok = WriteAt(fd, job.m_data.data(), job.m_data.size(), job.m_offset);
+
+        if (ok && !job.m_trunc)
+            ok = (::ftruncate(fd, job.m_length) == 0);
+
+        if (::close(fd) != 0)
+            ok = false;
+
+        return ok;
+    }
+
+    void*
+    AsyncWriter (void*)
+    {
+        pthread_mutex_lock(&async_mutex);
+
+        for (;;)
+        {
+            while (async_jobs.empty() && !async_quit)
+                pthread_cond_wait(&async_cond, &async_mutex);
+
+            if (async_jobs.empty()) break;
+
+            AsyncJob* job = async_jobs.front();
+
+            async_jobs.pop_front();
+
+            async_busy = true;
+
+            pthread_mutex_unlock(&async_mutex);
+
+            const bool ok = AsyncDoit(*job);
+
+            if (!ok)
+                std::cerr << "VisMF: asynchronous write to " << job->m_file
+                          << " failed on CPU " << ParallelDescriptor::MyProc() << std::endl;
+
+            delete job;
+
+            pthread_mutex_lock(&async_mutex);
+
+            if (!ok) async_errors++;
+
+            async_busy = false;
+
+            pthread_cond_broadcast(&async_cond);
+        }
+
+        pthread_mutex_unlock(&async_mutex);
+
+        return 0;
+    }
+
+    void
+    AsyncPush (AsyncJob* job)
+    {
+        pthread_mutex_lock(&async_mutex);
+
+        if (!async_running)
+        {
+            async_quit = false;
+
+            if (pthread_create(&async_thread, 0, AsyncWriter, 0) != 0)
+                BoxLib::Abort("VisMF: couldn't start the asynchronous writer");
+
+            async_running = true;
+        }
+
+        async_jobs.push_back(job);
+
+        pthread_cond_broadcast(&async_cond);
+
+        pthread_mutex_unlock(&async_mutex);
+    }
+    //
+    // Wait for our writer thread to finish what it's got.
+    // Returns and resets the number of failed writes.
+    //
+    int
+    AsyncDrain ()
+    {
+        pthread_mutex_lock(&async_mutex);
+
+        while (!async_jobs.empty() || async_busy)
+            pthread_cond_wait(&async_cond, &async_mutex);
+
+        const int nerrors = async_errors;
+
+        async_errors = 0;
+
+        pthread_mutex_unlock(&async_mutex);
+
+        return nerrors;
+    }
+    //
+    // Aggregated writes move data to the aggregators in pieces no bigger
+    // than this, so an aggregator can write one piece while receiving
+    // the next.
+    //
+    const int AggPieceSize = 32*1024*1024;
+    //
+    // len bytes from CPU src that go at off in an aggregator's file.
+    //
+    struct AggPiece
+    {
+        int  src;
+        long off;
+        long len;
+    };
+#ifdef BL_USE_MPI
+    //
+    // An ostream writes FABs through one of these to find the bytes they
+    // take on disk, and where each starts, without keeping them.
+    //
+    class CountBuf
+        :
+        public std::streambuf
+    {
+    public:
+        CountBuf () : m_count(0) {}
+
+        long count () const { return m_count; }
+
+    protected:
+
+        virtual std::streamsize xsputn (const char*, std::streamsize n)
+        {
+            m_count += n;
+            return n;
+        }
+
+        virtual int_type overflow (int_type c)
+        {
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+                m_count++;
+            return traits_type::not_eof(c);
+        }
+        //
+        // Only the tellp() and seekp(0,end) of VisMF::FileOffset().
+        //
+        virtual pos_type seekoff (off_type off, std::ios_base::seekdir, std::ios_base::openmode)
+        {
+            return (off == 0) ? pos_type(m_count) : pos_type(off_type(-1));
+        }
+
+    private:
+
+        long m_count;
+    };
+    //
+    // An ostream writes total bytes of FABs through one of these, which
+    // hands them on in pieces of AggPieceSize bytes, the last maybe
+    // shorter, as the pieces fill up.  There are two buffers, so one can
+    // fill while the other's piece is on its way.  Call finish() after
+    // the last write.
+    //
+    class PieceBuf
+        :
+        public std::streambuf
+    {
+    public:
+
+        explicit PieceBuf (long total)
+            :
+            m_size(std::max(1L, std::min(total, long(AggPieceSize)))),
+            m_which(0)
+        {
+            m_buf[0].resize(m_size);
+            setp(&m_buf[0][0], &m_buf[0][0] + m_size);
+        }
+
+        virtual ~PieceBuf () {}
+
+        bool finish () { return handOn(); }
+
+    protected:
+        //
+        // Hand on the n bytes at p, which are in buffer which.  It isn't
+        // filled again until reclaim(which) has returned.
+        //
+        virtual bool emit (const char* p, long n, int which) = 0;
+
+        virtual void reclaim (int which) = 0;
+
+        virtual int_type overflow (int_type c)
+        {
+            if (!handOn())
+                return traits_type::eof();
+
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+
+            return traits_type::not_eof(c);
+        }
+
+    private:
+
+        bool handOn ()
+        {
+            const long n = pptr() - pbase();
+
+            if (n == 0) return true;
+
+            const bool ok = emit(pbase(), n, m_which);
+
+            m_which = 1 - m_which;
+
+            reclaim(m_which);
+
+            if (m_buf[m_which].empty())
+                m_buf[m_which].resize(m_size);
+
+            setp(&m_buf[m_which][0], &m_buf[m_which][0] + m_size);
+
+            return ok;
+        }
+
+        const long        m_size;
+        int               m_which;
+        std::vector<char> m_buf[2];
+    };
+    //
+    // Sends the pieces to an aggregator.
+    //
+    class SendPieceBuf
+        :
+        public PieceBuf
+    {
+    public:
+
+        SendPieceBuf (long total, int dest, int tag)
+            :
+            PieceBuf(total),
+            m_dest(dest),
+            m_tag(tag)
+        {
+            m_req[0] = m_req[1] = MPI_REQUEST_NULL;
+        }
+
+        virtual ~SendPieceBuf () { reclaim(0); reclaim(1); }
+
+    protected:
+
+        virtual bool emit (const char* p, long n, int which)
+        {
+            BL_MPI_REQUIRE( MPI_Isend(const_cast<char*>(p),
+                                      n,
+                                      MPI_CHAR,
+                                      m_dest,
+                                      m_tag,
+                                      ParallelDescriptor::Communicator(),
+                                      &m_req[which]) );
+            return true;
+        }
+
+        virtual void reclaim (int which)
+        {
+            BL_MPI_REQUIRE( MPI_Wait(&m_req[which], MPI_STATUS_IGNORE) );
+        }
+
+    private:
+
+        int         m_dest;
+        int         m_tag;
+        MPI_Request m_req[2];
+    };
+    //
+    // Writes the pieces to fd, one after the other from off on.
+    //
+    class WritePieceBuf
+        :
+        public PieceBuf
+    {
+    public:
+
+        WritePieceBuf (long total, int fd, long off)
+            :
+            PieceBuf(total),
+            m_fd(fd),
+            m_off(off)
+        {}
+
+    protected:
+
+        virtual bool emit (const char* p, long n, int)
+        {
+            const bool ok = WriteAt(m_fd, p, n, m_off);
+            m_off += n;
+            return ok;
+        }
+
+        virtual void reclaim (int) {}
+
+    private:
+
+        int  m_fd;
+        long m_off;
+    };
+    //
+    // Post the receive of piece p into b.
+    //
+    void
+    RecvPiece (const AggPiece&    p,
+               std::vector<char>& b,
+               int                tag,
+               MPI_Request&       req)
+    {
+        if (b.size() < std::size_t(p.len))
+            b.resize(p.len);
+
+        BL_MPI_REQUIRE( MPI_Irecv(&b[0],
+                                  p.len,
+                                  MPI_CHAR,
+                                  p.src,
+                                  tag,
+                                  ParallelDescriptor::Communicator(),
+                                  &req) );
+    }
+    //
+    // Read all len bytes at off in fd into buf.
+    //
+    bool
+    ReadAt (int         fd,
+            char*       buf,
+            std::size_t len,
+            off_t       off)
+    {
+        while (len > 0)
+        {
+            const ssize_t n = ::pread(fd, buf, len, off);
+
+            if (n < 0)
+            {
+                if (errno != EINTR) return false;
+                continue;
+            }
+            if (n == 0) return false;
+
+            buf += n; len -= n; off += n;
+        }
+
+        return true;
+    }
+#endif /*BL_USE_MPI*/
+    //
+    // The most a CPU reads, and so sends, in one round of a chunked read.
+    //
+    const long ChunkReadSize = 1024L*1024L*1024L;
+    //
+    // An istream reads FABs straight out of a buffer through one of these.
+    //
+    class ChunkBuf
+        :
+        public std::streambuf
+    {
+    public:
+        ChunkBuf (char* p, long n) { setg(p, p, p + n); }
+    };
+    //
+    // The lowest numbered CPU on the same node as each CPU.
+    //
+    Array<int> node_leader;
+
+#ifdef BL_USE_MPI
+    const Array<int>&
+    NodeLeaders ()
+    {
+        if (node_leader.empty())
+        {
+            int leader = ParallelDescriptor::MyProc();
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+            MPI_Comm node_comm;
+
+            BL_MPI_REQUIRE( MPI_Comm_split_type(ParallelDescriptor::Communicator(),
+                                                MPI_COMM_TYPE_SHARED,
+                                                ParallelDescriptor::MyProc(),
+                                                MPI_INFO_NULL,
+                                                &node_comm) );
+
+            BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE, &leader, 1, MPI_INT, MPI_MIN, node_comm) );
+
+            BL_MPI_REQUIRE( MPI_Comm_free(&node_comm) );
+#endif
+            //
+            // Without MPI-3 every CPU is taken to be on a node of its own.
+            //
+            node_leader.resize(ParallelDescriptor::NProcs());
+
+            BL_MPI_REQUIRE( MPI_Allgather(&leader,
+                                          1,
+                                          MPI_INT,
+                                          node_leader.dataPtr(),
+                                          1,
+                                          MPI_INT,
+                                          ParallelDescriptor::Communicator()) );
+        }
+
+        return node_leader;
+    }
+#endif /*BL_USE_MPI*/
+}
+
 void
 VisMF::Initialize ()
 {
@@ -50,15 +537,87 @@ VisMF::Initialize ()
     ParmParse pp("vismf");
     pp.query("v",verbose);
 
+    int naggregators = aggregators_per_node;
+    pp.query("aggregators_per_node",naggregators);
+    VisMF::SetAggregatorsPerNode(naggregators);
+
+    int chunked = chunked_read;
+    pp.query("chunked_read",chunked);
+    VisMF::SetChunkedRead(chunked);
+
     initialized = true;
 }
 
 void
 VisMF::Finalize ()
 {
+    AsyncDrain();
+
+    if (async_running)
+    {
+        pthread_mutex_lock(&async_mutex);
+        async_quit = true;
+        pthread_cond_broadcast(&async_cond);
+        pthread_mutex_unlock(&async_mutex);
+
+        pthread_join(async_thread, 0);
+
+        async_running = false;
+    }
+
+    node_leader.clear();
+
     initialized = false;
 }
 
+void
+VisMF::SetAsyncWrite (bool async)
+{
+    async_write = async;
+}
+
+bool
+VisMF::GetAsyncWrite ()
+{
+    return async_write;
+}
+
+void
+VisMF::SetAggregatorsPerNode (int n)
+{
+    aggregators_per_node = std::max(0, n);
+}
+
+int
+VisMF::GetAggregatorsPerNode ()
+{
+    return aggregators_per_node;
+}
+
+void
+VisMF::SetChunkedRead (bool chunked)
+{
+    chunked_read = chunked;
+}
+
+bool
+VisMF::GetChunkedRead ()
+{
+    return chunked_read;
+}
+
+int
+VisMF::AsyncWait ()
+{
+    BL_PROFILE("VisMF::AsyncWait()");
+
+    int nerrors = AsyncDrain();
+
+    ParallelDescriptor::ReduceIntSum(nerrors);
+
+    return nerrors;
+}
+
 void
 VisMF::SetNOutFiles (int noutfiles)
 {
@@ -242,6 +801,13 @@ operator<< (std::ostream&        os,
     os << hd.m_min      << '\n';
     os << hd.m_max      << '\n';
 
+    if (hd.m_vers == VisMF::Header::Version_2)
+    {
+        os << hd.m_fod.size() << '\n';
+        for (int i = 0; i < hd.m_fod.size(); i++)
+            os << hd.m_fod[i].m_size << '\n';
+    }
+
     os.flags(oflags);
     os.precision(old_prec);
 
@@ -256,7 +822,8 @@ operator>> (std::istream&  is,
             VisMF::Header& hd)
 {
     is >> hd.m_vers;
-    BL_ASSERT(hd.m_vers == VisMF::Header::Version);
+    if (hd.m_vers != VisMF::Header::Version && hd.m_vers != VisMF::Header::Version_2)
+        BoxLib::Error("Bad VisMF::Header version");
 
     int how;
     is >> how;
@@ -287,18 +854,32 @@ operator>> (std::istream&  is,
     BL_ASSERT(hd.m_ba.size() == hd.m_min.size());
     BL_ASSERT(hd.m_ba.size() == hd.m_max.size());
 
+    if (hd.m_vers == VisMF::Header::Version_2)
+    {
+        long N;
+        is >> N;
+        BL_ASSERT(N == hd.m_fod.size());
+        for (int i = 0; i < N; i++)
+            is >> hd.m_fod[i].m_size;
+    }
+
     if (!is.good())
         BoxLib::Error("Read of VisMF::Header failed");
 
     return is;
 }
 
-VisMF::FabOnDisk::FabOnDisk () {}
+VisMF::FabOnDisk::FabOnDisk ()
+    :
+    m_head(0),
+    m_size(0)
+{}
 
 VisMF::FabOnDisk::FabOnDisk (const std::string& name, long offset)
     :
     m_name(name),
-    m_head(offset)
+    m_head(offset),
+    m_size(0)
 {}
 
 int
@@ -349,7 +930,7 @@ VisMF::GetFab (int fabIndex,
 {
     if (m_pa[ncomp][fabIndex] == 0)
     {
-        m_pa[ncomp][fabIndex] = VisMF::readFAB(fabIndex,m_mfname,m_hdr,ncomp);
+        m_pa[ncomp][fabIndex] = mapFAB(fabIndex,ncomp);
     }
     return *m_pa[ncomp][fabIndex];
 }
@@ -462,8 +1043,10 @@ VisMF::Write (const FArrayBox&   fab,
     //
     // Add in the number of bytes in the FAB including the FAB header.
     //
-    bytes += (VisMF::FileOffset(os) - fab_on_disk.m_head);
-    
+    fab_on_disk.m_size = VisMF::FileOffset(os) - fab_on_disk.m_head;
+
+    bytes += fab_on_disk.m_size;
+
     return fab_on_disk;
 }
 
@@ -483,7 +1066,7 @@ VisMF::Header::Header ()
 VisMF::Header::Header (const MultiFab& mf,
                        VisMF::How      how)
     :
-    m_vers(VisMF::Header::Version),
+    m_vers(FArrayBox::getFormat() == FABio::FAB_COMPRESSED ? int(VisMF::Header::Version_2) : int(VisMF::Header::Version)),
     m_how(how),
     m_ncomp(mf.nComp()),
     m_ngrow(mf.nGrow()),
@@ -669,21 +1252,108 @@ VisMF::WriteHeader (const std::string& mf_name,
     return bytes;
 }
 
-long
-VisMF::Write (const MultiFab&    mf,
-              const std::string& mf_name,
-              VisMF::How         how,
-              bool               set_ghost)
+void
+VisMF::GatherFabOnDisk (const MultiFab&    mf,
+                        const std::string& mf_name,
+                        VisMF::Header&     hdr,
+                        const Array<int>*  fileNumber)
 {
-    BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
+#ifdef BL_USE_MPI
+    const int NProcs = ParallelDescriptor::NProcs();
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
 
-    static const char* FabFileSuffix = "_D_";
+    Array<int> nmtags(NProcs,0);
+    Array<int> offset(NProcs,0);
 
-    VisMF::Initialize();
+    const Array<int>& pmap = mf.DistributionMap().ProcessorMap();
 
-    VisMF::Header hdr(mf, how);
+    for (int i = 0, N = mf.size(); i < N; i++)
+        nmtags[pmap[i]]++;
 
-    if (set_ghost)
+    for (int i = 1, N = offset.size(); i < N; i++)
+        offset[i] = offset[i-1] + nmtags[i-1];
+
+    //
+    // Two longs per FAB: its offset and its size.
+    //
+    for (int i = 0; i < NProcs; i++)
+    {
+        nmtags[i] *= 2;
+        offset[i] *= 2;
+    }
+
+    Array<long> senddata(nmtags[ParallelDescriptor::MyProc()]);
+
+    if (senddata.empty())
+        //
+        // Can't let senddata be empty as senddata.dataPtr() will fail.
+        //
+        senddata.resize(1);
+
+    int ioffset = 0;
+
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        senddata[ioffset++] = hdr.m_fod[mfi.index()].m_head;
+        senddata[ioffset++] = hdr.m_fod[mfi.index()].m_size;
+    }
+
+    BL_ASSERT(ioffset == nmtags[ParallelDescriptor::MyProc()]);
+
+    Array<long> recvdata(2*mf.size());
+
+    BL_COMM_PROFILE(BLProfiler::Gatherv, recvdata.size() * sizeof(long),
+                    ParallelDescriptor::MyProc(), BLProfiler::BeforeCall());
+
+    BL_MPI_REQUIRE( MPI_Gatherv(senddata.dataPtr(),
+                                nmtags[ParallelDescriptor::MyProc()],
+                                ParallelDescriptor::Mpi_typemap<long>::type(),
+                                recvdata.dataPtr(),
+                                nmtags.dataPtr(),
+                                offset.dataPtr(),
+                                ParallelDescriptor::Mpi_typemap<long>::type(),
+                                IOProc,
+                                ParallelDescriptor::Communicator()) );
+
+    BL_COMM_PROFILE(BLProfiler::Gatherv, recvdata.size() * sizeof(long),
+                    ParallelDescriptor::MyProc(), BLProfiler::AfterCall());
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        Array<int> cnt(NProcs,0);
+
+        for (int j = 0, N = mf.size(); j < N; ++j)
+        {
+            const int i = pmap[j];
+
+            hdr.m_fod[j].m_head = recvdata[offset[i]+cnt[i]];
+            hdr.m_fod[j].m_size = recvdata[offset[i]+cnt[i]+1];
+
+            const int nfile = fileNumber ? (*fileNumber)[i] : i % nOutFiles;
+
+            std::string name = BoxLib::Concatenate(mf_name + FabFileSuffix, nfile, 4);
+
+            hdr.m_fod[j].m_name = VisMF::BaseName(name);
+
+            cnt[i] += 2;
+        }
+    }
+#endif /*BL_USE_MPI*/
+}
+
+long
+VisMF::Write (const MultiFab&    mf,
+              const std::string& mf_name,
+              VisMF::How         how,
+              bool               set_ghost)
+{
+    BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
+
+    VisMF::Initialize();
+
+    VisMF::Header hdr(mf, how);
+
+    if (set_ghost)
     {
         MultiFab* the_mf = const_cast<MultiFab*>(&mf);
 
@@ -704,6 +1374,14 @@ VisMF::Write (const MultiFab&    mf,
         }
     }
 
+    if (async_write)
+        return VisMF::WriteAsync(mf, mf_name, hdr);
+
+#ifdef BL_USE_MPI
+    if (aggregators_per_node > 0)
+        return VisMF::WriteAggregated(mf, mf_name, hdr);
+#endif
+
     long        bytes    = 0;
     const int   MyProc   = ParallelDescriptor::MyProc();
     const int   NProcs   = ParallelDescriptor::NProcs();
@@ -774,76 +1452,616 @@ VisMF::Write (const MultiFab&    mf,
 
 #ifdef BL_USE_MPI
     ParallelDescriptor::Barrier("VisMF::Write");
+#endif
 
-    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    VisMF::GatherFabOnDisk(mf, mf_name, hdr);
 
-    Array<int> nmtags(NProcs,0);
-    Array<int> offset(NProcs,0);
+    bytes += VisMF::WriteHeader(mf_name, hdr);
 
-    const Array<int>& pmap = mf.DistributionMap().ProcessorMap();
+    return bytes;
+}
 
-    for (int i = 0, N = mf.size(); i < N; i++)
-        nmtags[pmap[i]]++;
+long
+VisMF::WriteAsync (const MultiFab&    mf,
+                   const std::string& mf_name,
+                   VisMF::Header&     hdr)
+{
+    BL_PROFILE("VisMF::WriteAsync()");
 
-    for (int i = 1, N = offset.size(); i < N; i++)
-        offset[i] = offset[i-1] + nmtags[i-1];
+    const int   MyProc   = ParallelDescriptor::MyProc();
+    const int   NProcs   = ParallelDescriptor::NProcs();
+    std::string FullName = BoxLib::Concatenate(mf_name + FabFileSuffix, MyProc % nOutFiles, 4);
 
-    Array<long> senddata(nmtags[ParallelDescriptor::MyProc()]);
+    const std::string BName = VisMF::BaseName(FullName);
 
-    if (senddata.empty())
-        //
-        // Can't let senddata be empty as senddata.dataPtr() will fail.
-        //
-        senddata.resize(1);
+    AsyncJob* job = new AsyncJob;
+    //
+    // Snapshot our FABs as they'll appear on disk.
+    //
+    {
+        std::ostringstream os;
 
-    int ioffset = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            long nb = 0;
 
-    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
-        senddata[ioffset++] = hdr.m_fod[mfi.index()].m_head;
+            hdr.m_fod[mfi.index()] = VisMF::Write(mf[mfi], BName, os, nb);
+        }
 
-    BL_ASSERT(ioffset == nmtags[ParallelDescriptor::MyProc()]);
+        if (!os.good())
+            BoxLib::Abort("VisMF::WriteAsync(): couldn't copy FABs");
 
-    Array<long> recvdata(mf.size());
+        job->m_data = os.str();
+    }
 
-    BL_COMM_PROFILE(BLProfiler::Gatherv, recvdata.size() * sizeof(long),
-                    ParallelDescriptor::MyProc(), BLProfiler::BeforeCall());
+    long bytes = job->m_data.size();
+    //
+    // Work out where our bytes go.  As in the synchronous case the CPUs
+    // sharing a file append to it in order of MyProc.
+    //
+    Array<long> nbytes(NProcs,0);
 
-    BL_MPI_REQUIRE( MPI_Gatherv(senddata.dataPtr(),
-                                nmtags[ParallelDescriptor::MyProc()],
-                                ParallelDescriptor::Mpi_typemap<long>::type(),
-                                recvdata.dataPtr(),
-                                nmtags.dataPtr(),
-                                offset.dataPtr(),
-                                ParallelDescriptor::Mpi_typemap<long>::type(),
-                                IOProc,
-                                ParallelDescriptor::Communicator()) );
+#ifdef BL_USE_MPI
+    BL_MPI_REQUIRE( MPI_Allgather(&bytes,
+                                  1,
+                                  ParallelDescriptor::Mpi_typemap<long>::type(),
+                                  nbytes.dataPtr(),
+                                  1,
+                                  ParallelDescriptor::Mpi_typemap<long>::type(),
+                                  ParallelDescriptor::Communicator()) );
+#else
+    nbytes[0] = bytes;
+#endif
 
-    BL_COMM_PROFILE(BLProfiler::Gatherv, recvdata.size() * sizeof(long),
-                    ParallelDescriptor::MyProc(), BLProfiler::AfterCall());
+    job->m_file   = FullName;
+    job->m_offset = 0;
+    job->m_length = 0;
+    job->m_trunc  = false;
+
+    for (int i = MyProc % nOutFiles; i < NProcs; i += nOutFiles)
+    {
+        if (i < MyProc)
+            job->m_offset += nbytes[i];
+
+        job->m_length += nbytes[i];
+    }
+
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        hdr.m_fod[mfi.index()].m_head += job->m_offset;
+
+    if (bytes > 0)
+        AsyncPush(job);
+    else
+        delete job;
+
+    VisMF::GatherFabOnDisk(mf, mf_name, hdr);
 
     if (ParallelDescriptor::IOProcessor())
     {
-        Array<int> cnt(NProcs,0);
+        AsyncJob* hjob = new AsyncJob;
 
-        for (int j = 0, N = mf.size(); j < N; ++j)
+        std::ostringstream os;
+
+        os << hdr;
+
+        hjob->m_file   = mf_name + TheMultiFabHdrFileSuffix;
+        hjob->m_offset = 0;
+        hjob->m_length = 0;
+        hjob->m_trunc  = true;
+        hjob->m_data   = os.str();
+
+        bytes += hjob->m_data.size();
+
+        AsyncPush(hjob);
+    }
+
+    return bytes;
+}
+
+#ifdef BL_USE_MPI
+long
+VisMF::WriteAggregated (const MultiFab&    mf,
+                        const std::string& mf_name,
+                        VisMF::Header&     hdr)
+{
+    BL_PROFILE("VisMF::WriteAggregated()");
+
+    const int         MyProc = ParallelDescriptor::MyProc();
+    const int         NProcs = ParallelDescriptor::NProcs();
+    const Array<int>& leader = NodeLeaders();
+    //
+    // Split the CPUs on each node into up to aggregators_per_node runs
+    // of consecutive CPUs.  The first CPU of each run is its aggregator.
+    //
+    std::map<int,int> node_size, node_pos;
+
+    for (int i = 0; i < NProcs; i++)
+        node_size[leader[i]]++;
+
+    Array<int> agg_of(NProcs);
+
+    std::map< std::pair<int,int>,int > first_in_run;
+
+    for (int i = 0; i < NProcs; i++)
+    {
+        const int S   = node_size[leader[i]];
+        const int K   = std::min(aggregators_per_node, S);
+        const int run = (node_pos[leader[i]]++ * K) / S;
+
+        agg_of[i] = first_in_run.insert(std::make_pair(std::make_pair(leader[i],run),i)).first->second;
+    }
+    //
+    // The aggregators take turns at the files in order of CPU number.
+    //
+    Array<int> agg_num(NProcs,-1);
+
+    int NAggs = 0;
+
+    for (int i = 0; i < NProcs; i++)
+        if (agg_of[i] == i)
+            agg_num[i] = NAggs++;
+
+    const int NFiles = std::min(nOutFiles, NAggs);
+
+    Array<int> file_of(NProcs);
+
+    for (int i = 0; i < NProcs; i++)
+        file_of[i] = agg_num[agg_of[i]] % NFiles;
+
+    std::string FullName = BoxLib::Concatenate(mf_name + FabFileSuffix, file_of[MyProc], 4);
+
+    const std::string BName = VisMF::BaseName(FullName);
+    //
+    // Where our FABs go relative to one another, and how many bytes they
+    // take, from a dry run.  They're written for real FAB by FAB once we
+    // know where, so no more than a couple of pieces are ever held.
+    //
+    long bytes = 0;
+    {
+        CountBuf     cb;
+        std::ostream os(&cb);
+
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
         {
-            const int i = pmap[j];
+            long nb = 0;
 
-            hdr.m_fod[j].m_head = recvdata[offset[i]+cnt[i]];
+            hdr.m_fod[mfi.index()] = VisMF::Write(mf[mfi], BName, os, nb);
+        }
 
-            std::string name = BoxLib::Concatenate(mf_name + FabFileSuffix, i % nOutFiles, 4);
+        if (!os.good())
+            BoxLib::Abort("VisMF::WriteAggregated(): couldn't size FABs");
 
-            hdr.m_fod[j].m_name = VisMF::BaseName(name);
+        bytes = cb.count();
+    }
+
+    Array<long> nbytes(NProcs,0);
+
+    BL_MPI_REQUIRE( MPI_Allgather(&bytes,
+                                  1,
+                                  ParallelDescriptor::Mpi_typemap<long>::type(),
+                                  nbytes.dataPtr(),
+                                  1,
+                                  ParallelDescriptor::Mpi_typemap<long>::type(),
+                                  ParallelDescriptor::Communicator()) );
+    //
+    // Work out where everything goes.  Within a file each aggregator's
+    // CPUs follow one another in order, and the aggregators follow one
+    // another in order.
+    //
+    Array< Array<int> > members(NAggs);
+
+    for (int i = 0; i < NProcs; i++)
+        members[agg_num[agg_of[i]]].push_back(i);
+
+    Array<long> offset(NProcs,0), file_length(NFiles,0);
 
-            cnt[i]++;
+    for (int j = 0; j < NAggs; j++)
+    {
+        const int f = j % NFiles;
+
+        for (int k = 0; k < members[j].size(); k++)
+        {
+            offset[members[j][k]] = file_length[f];
+
+            file_length[f] += nbytes[members[j][k]];
         }
     }
-#endif /*BL_USE_MPI*/
+
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        hdr.m_fod[mfi.index()].m_head += offset[MyProc];
+
+    const int SeqNum = ParallelDescriptor::SeqNum();
+
+    if (agg_of[MyProc] != MyProc)
+    {
+        SendPieceBuf sb(bytes, agg_of[MyProc], SeqNum);
+        std::ostream os(&sb);
+
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+            mf[mfi].writeOn(os);
+
+        if (!os.good() || !sb.finish())
+            BoxLib::Abort("VisMF::WriteAggregated(): couldn't send FABs");
+    }
+    else
+    {
+        //
+        // Our CPUs' data is streamed in, the next piece arriving while
+        // the last is being written.  The first one arrives while we
+        // write our own.
+        //
+        std::vector<AggPiece> pieces;
+
+        const Array<int>& mine = members[agg_num[MyProc]];
+
+        for (int k = 0; k < mine.size(); k++)
+        {
+            const int src = mine[k];
+
+            if (src == MyProc) continue;
+
+            for (long pos = 0; pos < nbytes[src]; pos += AggPieceSize)
+            {
+                AggPiece p;
+                p.src = src;
+                p.off = offset[src] + pos;
+                p.len = std::min(long(AggPieceSize), nbytes[src] - pos);
+                pieces.push_back(p);
+            }
+        }
+
+        const int fd = ::open(FullName.c_str(), O_WRONLY|O_CREAT, 0666);
+
+        if (fd < 0)
+            BoxLib::FileOpenFailed(FullName);
+
+        std::vector<char> buf[2];
+        MPI_Request       req[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+        const int         N      = pieces.size();
+
+        if (N > 0)
+            RecvPiece(pieces[0], buf[0], SeqNum, req[0]);
+
+        bool ok;
+        {
+            WritePieceBuf wb(bytes, fd, offset[MyProc]);
+            std::ostream  os(&wb);
+
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+                mf[mfi].writeOn(os);
+
+            ok = os.good() && wb.finish();
+        }
+
+        for (int i = 0; i < N; i++)
+        {
+            if (i+1 < N)
+                RecvPiece(pieces[i+1], buf[(i+1)%2], SeqNum, req[(i+1)%2]);
+
+            BL_MPI_REQUIRE( MPI_Wait(&req[i%2], MPI_STATUS_IGNORE) );
+
+            if (ok)
+                ok = WriteAt(fd, &buf[i%2][0], pieces[i].len, pieces[i].off);
+        }
+        //
+        // All the aggregators sharing a file cut it to the same length,
+        // so no one cuts off anyone else's data.
+        //
+        if (ok)
+            ok = (::ftruncate(fd, file_length[file_of[MyProc]]) == 0);
+
+        if (::close(fd) != 0)
+            ok = false;
+
+        if (!ok)
+            BoxLib::Error("VisMF::WriteAggregated(): write failed");
+    }
+
+    ParallelDescriptor::Barrier("VisMF::WriteAggregated");
+
+    VisMF::GatherFabOnDisk(mf, mf_name, hdr, &file_of);
 
     bytes += VisMF::WriteHeader(mf_name, hdr);
 
     return bytes;
 }
+#endif /*BL_USE_MPI*/
+
+#ifdef BL_USE_MPI
+void
+VisMF::ReadChunked (MultiFab&            mf,
+                    const std::string&   mf_name,
+                    const VisMF::Header& hdr)
+{
+    BL_PROFILE("VisMF::ReadChunked()");
+
+    const int                  MyProc = ParallelDescriptor::MyProc();
+    const int                  NProcs = ParallelDescriptor::NProcs();
+    const int                  NBoxes = hdr.m_ba.size();
+    const DistributionMapping& dmap   = mf.DistributionMap();
+    //
+    // Number the files and put the FABs in the order they lie on disk.
+    //
+    std::map<std::string,int> file_num;
+
+    for (int i = 0; i < NBoxes; i++)
+        file_num.insert(std::make_pair(hdr.m_fod[i].m_name,0));
+
+    Array<std::string> files;
+
+    for (std::map<std::string,int>::iterator it = file_num.begin(), End = file_num.end();
+         it != End;
+         ++it)
+    {
+        it->second = files.size();
+
+        files.push_back(VisMF::DirName(mf_name) + it->first);
+    }
+
+    const int NFiles = files.size();
+
+    std::vector< std::pair<std::pair<int,long>,int> > on_disk(NBoxes);
+
+    for (int i = 0; i < NBoxes; i++)
+        on_disk[i] = std::make_pair(std::make_pair(file_num[hdr.m_fod[i].m_name],hdr.m_fod[i].m_head),i);
+
+    std::sort(on_disk.begin(), on_disk.end());
+    //
+    // A Version_2 header knows how big each FAB is on disk.  Otherwise a
+    // FAB runs up to the next one in its file and the last one in a file
+    // runs to the end of the file; the CPUs share out the stat()s.
+    //
+    const bool have_sizes = (hdr.m_vers == VisMF::Header::Version_2);
+
+    Array<long> file_size(NFiles,0);
+
+    if (!have_sizes)
+    {
+        for (int f = MyProc; f < NFiles; f += NProcs)
+        {
+            struct stat st;
+
+            if (::stat(files[f].c_str(), &st) != 0)
+                BoxLib::FileOpenFailed(files[f]);
+
+            file_size[f] = st.st_size;
+        }
+
+        if (NFiles > 0)
+            ParallelDescriptor::ReduceLongMax(file_size.dataPtr(), NFiles);
+    }
+
+    Array<int>  fnum(NBoxes), idx(NBoxes);
+    Array<long> head(NBoxes), length(NBoxes);
+
+    long total = 0;
+
+    for (int k = 0; k < NBoxes; k++)
+    {
+        fnum[k] = on_disk[k].first.first;
+        head[k] = on_disk[k].first.second;
+        idx[k]  = on_disk[k].second;
+
+        if (have_sizes)
+        {
+            length[k] = hdr.m_fod[idx[k]].m_size;
+        }
+        else
+        {
+            const bool last = (k+1 == NBoxes || on_disk[k+1].first.first != fnum[k]);
+
+            length[k] = (last ? file_size[fnum[k]] : on_disk[k+1].first.second) - head[k];
+        }
+
+        if (length[k] <= 0)
+            BoxLib::Abort("VisMF::ReadChunked(): FAB offsets don't match the files");
+
+        total += length[k];
+    }
+    //
+    // Cut the FABs, in disk order, into NRounds*NProcs runs of about the
+    // same number of bytes.  In round r CPU p reads run r*NProcs+p.  A
+    // run is never more than ChunkReadSize bytes unless one FAB is.
+    //
+    const long PerRound = long(NProcs)*ChunkReadSize;
+    const int  NRounds  = std::max(1L, (total + PerRound - 1) / PerRound);
+    const long NChunks  = long(NRounds)*NProcs;
+
+    Array<long> chunk(NBoxes);
+
+    for (long k = 0, pos = 0; k < NBoxes; k++)
+    {
+        chunk[k] = std::min(NChunks-1, long((pos + length[k]/2) * (double(NChunks) / total)));
+
+        pos += length[k];
+    }
+
+    for (int r = 0; r < NRounds; r++)
+    {
+        const int SeqNum = ParallelDescriptor::SeqNum();
+
+        const long first = long(r)*NProcs;
+        const long mine  = first + MyProc;
+        //
+        // The FABs of this round are kb to ke-1 in disk order, and we read
+        // mb to me-1 of them.
+        //
+        const int kb = std::lower_bound(chunk.begin(), chunk.end(), first)         - chunk.begin();
+        const int ke = std::lower_bound(chunk.begin(), chunk.end(), first+NProcs)  - chunk.begin();
+        const int mb = std::lower_bound(chunk.begin(), chunk.end(), mine)          - chunk.begin();
+        const int me = std::lower_bound(chunk.begin(), chunk.end(), mine+1)        - chunk.begin();
+        //
+        // Read our run with one read per stretch of FABs that follow each
+        // other in a file.  Without sizes in the header there are no gaps.
+        //
+        std::vector<char> raw(std::accumulate(length.begin()+mb, length.begin()+me, 0L));
+
+        long pos = 0;
+
+        for (int k = mb; k < me; )
+        {
+            int  n   = k;
+            long len = 0;
+
+            for ( ; n < me && fnum[n] == fnum[k] && (n == k || head[n] == head[n-1] + length[n-1]); n++)
+                len += length[n];
+
+            const int fd = ::open(files[fnum[k]].c_str(), O_RDONLY);
+
+            if (fd < 0)
+                BoxLib::FileOpenFailed(files[fnum[k]]);
+
+            if (!ReadAt(fd, &raw[pos], len, head[k]))
+                BoxLib::Error("VisMF::ReadChunked(): read failed");
+
+            ::close(fd);
+
+            pos += len;
+            k    = n;
+        }
+        //
+        // Gather what goes to each of the other CPUs, in disk order.
+        //
+        Array<long>       send_cnt(NProcs,0), send_off(NProcs+1,0);
+        Array<char*>      where(NBoxes,0);
+        std::vector<char> sendbuf;
+
+        for (int k = mb; k < me; k++)
+            if (dmap[idx[k]] != MyProc)
+                send_cnt[dmap[idx[k]]] += length[k];
+
+        for (int p = 0; p < NProcs; p++)
+            send_off[p+1] = send_off[p] + send_cnt[p];
+
+        sendbuf.resize(send_off[NProcs]);
+
+        pos = 0;
+
+        for (int k = mb; k < me; pos += length[k++])
+        {
+            const int owner = dmap[idx[k]];
+
+            if (owner == MyProc)
+            {
+                where[k] = &raw[pos];
+            }
+            else
+            {
+                memcpy(&sendbuf[send_off[owner]], &raw[pos], length[k]);
+
+                send_off[owner] += length[k];
+            }
+        }
+        //
+        // And what we get from them.  We know which FABs each CPU reads
+        // so no counts need to be exchanged.
+        //
+        Array<long>       recv_cnt(NProcs,0), recv_off(NProcs+1,0);
+        std::vector<char> recvbuf;
+
+        for (int k = kb; k < ke; k++)
+            if (dmap[idx[k]] == MyProc && chunk[k] != mine)
+                recv_cnt[chunk[k]-first] += length[k];
+
+        for (int p = 0; p < NProcs; p++)
+            recv_off[p+1] = recv_off[p] + recv_cnt[p];
+
+        recvbuf.resize(recv_off[NProcs]);
+
+        Array<MPI_Request> reqs;
+
+        for (int p = 0; p < NProcs; p++)
+        {
+            if (recv_cnt[p] == 0) continue;
+
+            if (recv_cnt[p] > INT_MAX)
+                BoxLib::Abort("VisMF::ReadChunked(): message too big");
+
+            MPI_Request req;
+
+            BL_MPI_REQUIRE( MPI_Irecv(&recvbuf[recv_off[p]],
+                                      recv_cnt[p],
+                                      MPI_CHAR,
+                                      p,
+                                      SeqNum,
+                                      ParallelDescriptor::Communicator(),
+                                      &req) );
+            reqs.push_back(req);
+        }
+
+        for (int p = 0; p < NProcs; p++)
+        {
+            if (send_cnt[p] == 0) continue;
+
+            if (send_cnt[p] > INT_MAX)
+                BoxLib::Abort("VisMF::ReadChunked(): message too big");
+
+            MPI_Request req;
+
+            BL_MPI_REQUIRE( MPI_Isend(&sendbuf[send_off[p]-send_cnt[p]],
+                                      send_cnt[p],
+                                      MPI_CHAR,
+                                      p,
+                                      SeqNum,
+                                      ParallelDescriptor::Communicator(),
+                                      &req) );
+            reqs.push_back(req);
+        }
+
+        for (int k = kb; k < ke; k++)
+        {
+            if (dmap[idx[k]] == MyProc && chunk[k] != mine)
+            {
+                const int p = chunk[k] - first;
+
+                where[k] = &recvbuf[recv_off[p]];
+
+                recv_off[p] += length[k];
+            }
+        }
+
+        if (!reqs.empty())
+            BL_MPI_REQUIRE( MPI_Waitall(reqs.size(), reqs.dataPtr(), MPI_STATUSES_IGNORE) );
+        //
+        // Turn the bytes into FABs.  setFab() isn't thread safe so the
+        // threads only do the conversions.
+        //
+        Array<int> ours;
+
+        for (int k = kb; k < ke; k++)
+            if (where[k])
+                ours.push_back(k);
+
+        const int N   = ours.size();
+        const int tag = MemProfiler::CurrentTag();
+
+        Array<FArrayBox*> fabs(N,0);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < N; i++)
+        {
+            MemProfiler::TagScope mts(tag);
+
+            const int k = ours[i];
+
+            ChunkBuf     sb(where[k], length[k]);
+            std::istream is(&sb);
+
+            fabs[i] = new FArrayBox;
+
+            fabs[i]->readFrom(is);
+
+            if (is.fail())
+                BoxLib::Abort("VisMF::ReadChunked(): couldn't read a FAB");
+        }
+
+        for (int i = 0; i < N; i++)
+            mf.setFab(idx[ours[i]], fabs[i]);
+    }
+}
+#endif /*BL_USE_MPI*/
 
 VisMF::VisMF (const std::string& mf_name)
     :
@@ -873,6 +2091,144 @@ VisMF::VisMF (const std::string& mf_name)
     }
 }
 
+VisMF::~VisMF ()
+{
+    //
+    // The FABs in m_pa may alias our mappings.
+    //
+    clear();
+
+    for (std::map< std::string,std::pair<char*,long> >::iterator it = m_maps.begin(), End = m_maps.end();
+         it != End;
+         ++it)
+    {
+        if (it->second.first)
+            munmap(it->second.first, it->second.second);
+    }
+}
+
+FArrayBox*
+VisMF::mapFAB (int idx,
+               int ncomp) const
+{
+    BL_ASSERT(0 <= ncomp && ncomp < m_hdr.m_ncomp);
+
+    std::string FullName = VisMF::DirName(m_mfname);
+
+    FullName += m_hdr.m_fod[idx].m_name;
+
+    std::pair<char*,long> mapping;
+    //
+    // Threads may map FABs of the same VisMF concurrently.
+    //
+#ifdef _OPENMP
+#pragma omp critical(VisMF_mapFAB)
+#endif
+    {
+        std::map< std::string,std::pair<char*,long> >::iterator it = m_maps.find(FullName);
+
+        if (it == m_maps.end())
+        {
+            std::pair<char*,long> m(static_cast<char*>(0),0L);
+
+            const int fd = open(FullName.c_str(), O_RDONLY);
+
+            if (fd < 0)
+                BoxLib::FileOpenFailed(FullName);
+
+            struct stat st;
+
+            if (fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                //
+                // Private and writable so the FABs can be modified in memory.
+                //
+                void* addr = mmap(0, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+                if (addr != MAP_FAILED)
+                {
+                    m.first  = static_cast<char*>(addr);
+                    m.second = st.st_size;
+                }
+            }
+
+            close(fd);
+            //
+            // Remember failures too so we don't keep on trying.
+            //
+            it = m_maps.insert(std::make_pair(FullName,m)).first;
+        }
+
+        mapping = it->second;
+    }
+
+    const char* base   = mapping.first;
+    const long  length = mapping.second;
+    const long  head   = m_hdr.m_fod[idx].m_head;
+
+    if (base && head < length && !RealDescriptor::GetFixDenormals())
+    {
+        //
+        // The FAB header is a single line.
+        //
+        const char* hp = base + head;
+        const char* nl = static_cast<const char*>(memchr(hp, '\n', length - head));
+
+        if (nl)
+        {
+            std::istringstream is(std::string(hp, nl - hp));
+
+            char c1 = 0, c2 = 0, c3 = 0, c4 = 0;
+
+            is >> c1 >> c2 >> c3 >> c4;
+
+            if (c1 == 'F' && c2 == 'A' && c3 == 'B' && c4 != ':')
+            {
+                //
+                // Only the "new" FAB format can hold native data.
+                //
+                is.putback(c4);
+
+                RealDescriptor rd;
+                Box            bx;
+                int            nvar;
+
+                is >> rd >> bx >> nvar;
+
+                const long npts   = bx.numPts();
+                const long offset = (nl + 1 - base) + ncomp*npts*long(sizeof(Real));
+
+                Box fab_box = m_hdr.m_ba[idx];
+
+                if (m_hdr.m_ngrow)
+                    fab_box.grow(m_hdr.m_ngrow);
+
+                if (!is.fail()                                &&
+                    rd == FPC::NativeRealDescriptor()         &&
+                    bx == fab_box                             &&
+                    nvar == m_hdr.m_ncomp                     &&
+                    offset + npts*long(sizeof(Real)) <= length)
+                {
+                    Real* p = reinterpret_cast<Real*>(mapping.first + offset);
+                    //
+                    // The FAB header is text so the data needn't be aligned.
+                    //
+                    if (reinterpret_cast<std::size_t>(p) % sizeof(Real) == 0)
+                        return new FArrayBox(bx, 1, p);
+
+                    FArrayBox* fab = new FArrayBox(bx, 1);
+
+                    memcpy(fab->dataPtr(), p, npts*sizeof(Real));
+
+                    return fab;
+                }
+            }
+        }
+    }
+
+    return VisMF::readFAB(idx,m_mfname,m_hdr,ncomp);
+}
+
 FArrayBox*
 VisMF::readFAB (int                  idx,
                 const std::string&   mf_name,
@@ -975,6 +2331,14 @@ VisMF::Read (MultiFab&          mf,
     mf.define(hdr.m_ba, hdr.m_ncomp, hdr.m_ngrow, Fab_noallocate);
 
 #ifdef BL_USE_MPI
+    if (chunked_read && ParallelDescriptor::NProcs() > 1)
+    {
+        VisMF::ReadChunked(mf, mf_name, hdr);
+
+        BL_ASSERT(mf.ok());
+
+        return;
+    }
     //
     // Here we limit the number of open files when reading a multifab.
     //
@@ -1266,7 +2630,7 @@ VisMF::clear (int fabIndex)
 {
     for (int ncomp = 0, N = m_pa.size(); ncomp < N; ++ncomp)
     {
-        clear(ncomp, fabIndex);
+        clear(fabIndex, ncomp);
     }
 }
 
@@ -1277,7 +2641,7 @@ VisMF::clear ()
     {
         for (int fabIndex = 0, M = m_pa[ncomp].size(); fabIndex < M; ++fabIndex)
         {
-            clear(ncomp, fabIndex);
+            clear(fabIndex, ncomp);
         }
     }
 }
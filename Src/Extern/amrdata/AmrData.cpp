@@ -134,6 +134,7 @@ extern "C" {
 bool AmrData::verbose = false;
 int  AmrData::skipPltLines  = 0;
 int  AmrData::sBoundaryWidth = 0;
+long AmrData::fabCacheBudget = 0;
 
 // ---------------------------------------------------------------
 AmrData::AmrData() {
@@ -143,6 +144,7 @@ AmrData::AmrData() {
   plotVars.clear();
   nRegions = 0;
   boundaryWidth = 0;
+  fabCacheBytes = 0;
 }
 
 
@@ -1141,13 +1143,9 @@ void AmrData::FillVar(MultiFab &destMultiFab, int finestFillLevel,
     int stateIndex(StateNumber(varNames[currentFillIndex]));
     // ensure the required grids are in memory
     for(currentLevel = 0; currentLevel <= finestFillLevel; ++currentLevel) {
-      for(int iBox = 0; iBox < destBoxes.size(); ++iBox) {
-	Box tempCoarseBox(destBoxes[iBox]);
-        if(currentLevel != finestFillLevel) {
-          tempCoarseBox.coarsen(cumulativeRefRatios[currentLevel]);
-        }
-        GetGrids(currentLevel, stateIndex, tempCoarseBox);
-      }
+      BoxArray coarseDestBoxes(destBoxes);
+      coarseDestBoxes.coarsen(cumulativeRefRatios[currentLevel]);
+      GetGrids(currentLevel, stateIndex, coarseDestBoxes);
     }
 
     MultiFabCopyDescriptor multiFabCopyDesc;
@@ -1271,11 +1269,12 @@ void AmrData::FillVar(MultiFab &destMultiFab, int finestFillLevel,
 
     multiFabCopyDesc.CollectData();
 
-
-    for(int currentIndex = 0; currentIndex < destBoxes.size(); ++currentIndex) {
-      if(destMultiFab.DistributionMap()[currentIndex] != myProc) {
-	continue;
-      }
+    // the fabs are filled independently from the collected data
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for(MFIter mfi(destMultiFab); mfi.isValid(); ++mfi) {
+      int currentIndex(mfi.index());
       for(int currentLevel(0); currentLevel <= finestFillLevel; ++currentLevel) {
         for(int currentBox(0);
             currentBox < fillBoxId[currentIndex][currentLevel].size();
@@ -1331,7 +1330,9 @@ void AmrData::FillVar(MultiFab &destMultiFab, int finestFillLevel,
             }
         }
       }  // end for(currentLevel...)
-    }  // end for(currentIndex...)
+    }  // end for(mfi...)
+
+    TrimFabCache();
 
   }  // end for(currentFillIndex...)
 }
@@ -1371,13 +1372,9 @@ void AmrData::FillVar(Array<FArrayBox *> &destFabs, const Array<Box> &destBoxes,
 
     // ensure the required grids are in memory
     for(currentLevel = 0; currentLevel <= finestFillLevel; ++currentLevel) {
-      for(int iBox = 0; iBox < destBoxes.size(); ++iBox) {
-	Box tempCoarseBox(destBoxes[iBox]);
-        if(currentLevel != finestFillLevel) {
-          tempCoarseBox.coarsen(cumulativeRefRatios[currentLevel]);
-        }
-        GetGrids(currentLevel, stateIndex, tempCoarseBox);
-      }
+      BoxArray coarseDestBoxes(destBoxes.dataPtr(), destBoxes.size());
+      coarseDestBoxes.coarsen(cumulativeRefRatios[currentLevel]);
+      GetGrids(currentLevel, stateIndex, coarseDestBoxes);
     }
 
     MultiFabCopyDescriptor multiFabCopyDesc;
@@ -1496,12 +1493,13 @@ void AmrData::FillVar(Array<FArrayBox *> &destFabs, const Array<Box> &destBoxes,
 
     multiFabCopyDesc.CollectData();
 
-
-    for(int currentIndex = 0; currentIndex < destBoxes.size(); ++currentIndex) {
+    // the fabs are filled independently from the collected data
+    int nFill(myproc == procWithFabs ? destBoxes.size() : 0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int currentIndex = 0; currentIndex < nFill; ++currentIndex) {
       for(int currentLevel = 0; currentLevel <= finestFillLevel; ++currentLevel) {
-	if(myproc != procWithFabs) {
-	  break;
-	}
         for(int currentBox(0);
             currentBox < fillBoxId[currentIndex][currentLevel].size();
             ++currentBox)
@@ -1558,6 +1556,8 @@ void AmrData::FillVar(Array<FArrayBox *> &destFabs, const Array<Box> &destBoxes,
         }
       }  // end for(currentLevel...)
     }  // end for(currentIndex...)
+
+    TrimFabCache();
 }    // end FillVar for a fab on a single processor
 
 
@@ -1680,8 +1680,14 @@ int AmrData::FinestIntersectingLevel(const Box &b, int startLevel) const {
 
 // ---------------------------------------------------------------
 MultiFab &AmrData::GetGrids(int level, int componentIndex) {
-  for(MFIter mfi(*dataGrids[level][componentIndex]); mfi.isValid(); ++mfi) {
-    DefineFab(level, componentIndex, mfi.index());
+  if(fileType == Amrvis::FAB || (fileType == Amrvis::MULTIFAB && level == 0)) {
+    // do nothing
+  } else {
+    Array<int> fabIndices;
+    for(MFIter mfi(*dataGrids[level][componentIndex]); mfi.isValid(); ++mfi) {
+      fabIndices.push_back(mfi.index());
+    }
+    DefineFabs(level, componentIndex, fabIndices);
   }
   return *dataGrids[level][componentIndex];
 }
@@ -1689,17 +1695,24 @@ MultiFab &AmrData::GetGrids(int level, int componentIndex) {
 
 // ---------------------------------------------------------------
 MultiFab &AmrData::GetGrids(int level, int componentIndex, const Box &onBox) {
+  return GetGrids(level, componentIndex, BoxArray(onBox));
+}
+
+
+// ---------------------------------------------------------------
+MultiFab &AmrData::GetGrids(int level, int componentIndex, const BoxArray &onBoxes) {
   if(fileType == Amrvis::FAB || (fileType == Amrvis::MULTIFAB && level == 0)) {
     // do nothing
   } else {
     int whichVisMF(compIndexToVisMFMap[componentIndex]);
-    for(MFIter mfi(*dataGrids[level][componentIndex]);
-        mfi.isValid(); ++mfi)
-    {
-      if(onBox.intersects(visMF[level][whichVisMF]->boxArray()[mfi.index()])) {
-        DefineFab(level, componentIndex, mfi.index());
+    const BoxArray &visMFBA = visMF[level][whichVisMF]->boxArray();
+    Array<int> fabIndices;
+    for(MFIter mfi(*dataGrids[level][componentIndex]); mfi.isValid(); ++mfi) {
+      if(onBoxes.intersects(visMFBA[mfi.index()])) {
+        fabIndices.push_back(mfi.index());
       }
     }
+    DefineFabs(level, componentIndex, fabIndices);
   }
   return *dataGrids[level][componentIndex];
 }
@@ -1712,17 +1725,103 @@ bool AmrData::DefineFab(int level, int componentIndex, int fabIndex) {
     int whichVisMF(compIndexToVisMFMap[componentIndex]);
     int whichVisMFComponent(compIndexToVisMFComponentMap[componentIndex]);
     dataGrids[level][componentIndex]->setFab(fabIndex,
-                visMF[level][whichVisMF]->readFAB(fabIndex, whichVisMFComponent));
+                visMF[level][whichVisMF]->mapFAB(fabIndex, whichVisMFComponent));
     dataGridsDefined[level][componentIndex][fabIndex] = true;
+    CacheFab(level, componentIndex, fabIndex);
+  } else {
+    TouchFab(level, componentIndex, fabIndex);
   }
   return true;
 }
 
 
+// ---------------------------------------------------------------
+void AmrData::DefineFabs(int level, int componentIndex,
+                         const Array<int> &fabIndices)
+{
+  Array<int> readIndices;
+  for(int i(0); i < fabIndices.size(); ++i) {
+    if(dataGridsDefined[level][componentIndex][fabIndices[i]]) {
+      TouchFab(level, componentIndex, fabIndices[i]);
+    } else {
+      readIndices.push_back(fabIndices[i]);
+    }
+  }
+
+  // reading (or mapping) each fab is independent of the others,
+  // so the threads keep several reads in flight
+  int whichVisMF(compIndexToVisMFMap[componentIndex]);
+  int whichVisMFComponent(compIndexToVisMFComponentMap[componentIndex]);
+  const VisMF *vismf = visMF[level][whichVisMF];
+  int nRead(readIndices.size());
+  Array<FArrayBox *> readFabs(nRead, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int i = 0; i < nRead; ++i) {
+    readFabs[i] = vismf->mapFAB(readIndices[i], whichVisMFComponent);
+  }
+
+  for(int i(0); i < nRead; ++i) {
+    dataGrids[level][componentIndex]->setFab(readIndices[i], readFabs[i]);
+    dataGridsDefined[level][componentIndex][readIndices[i]] = true;
+    CacheFab(level, componentIndex, readIndices[i]);
+  }
+}
+
+
+// ---------------------------------------------------------------
+void AmrData::CacheFab(int level, int componentIndex, int fabIndex) {
+  const FArrayBox &fab = (*dataGrids[level][componentIndex])[fabIndex];
+  CachedFab cf;
+  cf.level          = level;
+  cf.componentIndex = componentIndex;
+  cf.fabIndex       = fabIndex;
+  cf.nBytes         = fab.box().numPts() * fab.nComp() * sizeof(Real);
+
+  fabCacheList.push_front(cf);
+  fabCacheMap[FabCacheKey(level, componentIndex, fabIndex)] = fabCacheList.begin();
+  fabCacheBytes += cf.nBytes;
+}
+
+
+// ---------------------------------------------------------------
+void AmrData::TouchFab(int level, int componentIndex, int fabIndex) {
+  std::map<long, list<CachedFab>::iterator>::iterator it =
+                      fabCacheMap.find(FabCacheKey(level, componentIndex, fabIndex));
+  if(it != fabCacheMap.end()) {
+    fabCacheList.splice(fabCacheList.begin(), fabCacheList, it->second);
+  }
+}
+
+
+// ---------------------------------------------------------------
+void AmrData::TrimFabCache() {
+  while(fabCacheBudget > 0 && fabCacheBytes > fabCacheBudget && ! fabCacheList.empty()) {
+    const CachedFab &cf = fabCacheList.back();
+    dataGrids[cf.level][cf.componentIndex]->clearFab(cf.fabIndex);
+    dataGridsDefined[cf.level][cf.componentIndex][cf.fabIndex] = false;
+    fabCacheMap.erase(FabCacheKey(cf.level, cf.componentIndex, cf.fabIndex));
+    fabCacheBytes -= cf.nBytes;
+    fabCacheList.pop_back();
+  }
+}
+
+
 // ---------------------------------------------------------------
 void AmrData::FlushGrids(int componentIndex) {
 
   BL_ASSERT(componentIndex < nComp);
+  for(list<CachedFab>::iterator it = fabCacheList.begin(); it != fabCacheList.end(); ) {
+    if(it->componentIndex == componentIndex) {
+      fabCacheMap.erase(FabCacheKey(it->level, it->componentIndex, it->fabIndex));
+      fabCacheBytes -= it->nBytes;
+      it = fabCacheList.erase(it);
+    } else {
+      ++it;
+    }
+  }
   for(int lev(0); lev <= finestLevel; ++lev) {
     if(dataGrids.size() > lev
        && dataGrids[lev].size() > componentIndex
@@ -1888,9 +1987,13 @@ bool AmrData::MinMax(const Box &onBox, const string &derived, int level,
 #endif
 
   } else {
+    // first use the VisMF min and max wherever they are enough, then
+    // read and search the grids partly covered by onBox concurrently
+    Array<int> partialIndices;
+    Array<Real> partialMin, partialMax;
+    int whichVisMF(compIndexToVisMFMap[compIndex]);
+    int whichVisMFComponent(compIndexToVisMFComponentMap[compIndex]);
     for(MFIter gpli(*dataGrids[level][compIndex]); gpli.isValid(); ++gpli) {
-      int whichVisMF(compIndexToVisMFMap[compIndex]);
-      int whichVisMFComponent(compIndexToVisMFComponentMap[compIndex]);
       Real visMFMin(visMF[level][whichVisMF]->min(gpli.index(),
 		    whichVisMFComponent));
       Real visMFMax(visMF[level][whichVisMF]->max(gpli.index(),
@@ -1923,21 +2026,55 @@ bool AmrData::MinMax(const Box &onBox, const string &derived, int level,
       } else if(onBox.intersects(visMF[level][whichVisMF]->
 				 boxArray()[gpli.index()]))
       {
-        if(visMFMin < dataMin || visMFMax > dataMax) {  // do it the hard way
-	  DefineFab(level, compIndex, gpli.index());
-          valid = true;
-          overlap = onBox;
-          overlap &= gpli.validbox();
-          minVal = (*dataGrids[level][compIndex])[gpli].min(overlap, 0);
-          maxVal = (*dataGrids[level][compIndex])[gpli].max(overlap, 0);
+        partialIndices.push_back(gpli.index());
+        partialMin.push_back(visMFMin);
+        partialMax.push_back(visMFMax);
+      }
+    }
 
-          dataMin = min(dataMin, minVal);
-          dataMax = max(dataMax, maxVal);
-        }  // end if(visMFMin...)
+    // a grid whose VisMF range is already inside [dataMin, dataMax]
+    // cannot change the result
+    Array<int> searchIndices;
+    for(int i(0); i < partialIndices.size(); ++i) {
+      if(partialMin[i] < dataMin || partialMax[i] > dataMax) {  // do it the hard way
+        searchIndices.push_back(partialIndices[i]);
+      }
+    }
+    DefineFabs(level, compIndex, searchIndices);
+
+    int nSearch(searchIndices.size());
+    if(nSearch > 0) {
+      valid = true;
+    }
+    const MultiFab &grids = *dataGrids[level][compIndex];
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+      Real threadMin( std::numeric_limits<Real>::max());
+      Real threadMax(-std::numeric_limits<Real>::max());
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for(int i = 0; i < nSearch; ++i) {
+        const FArrayBox &fab = grids[searchIndices[i]];
+        Box overlap(onBox);
+        overlap &= grids.boxArray()[searchIndices[i]];
+        threadMin = min(threadMin, fab.min(overlap, 0));
+        threadMax = max(threadMax, fab.max(overlap, 0));
+      }
+#ifdef _OPENMP
+#pragma omp critical(AmrData_MinMax)
+#endif
+      {
+        dataMin = min(dataMin, threadMin);
+        dataMax = max(dataMax, threadMax);
       }
     }
   }
 
+  TrimFabCache();
+
   ParallelDescriptor::ReduceRealMin(dataMin);
   ParallelDescriptor::ReduceRealMax(dataMax);
 
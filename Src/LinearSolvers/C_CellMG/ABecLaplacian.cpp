@@ -130,6 +130,18 @@ ABecLaplacian::clearToLevel (int level)
         }
         b_valid[i] = false;
     }
+
+    for (int i = level+1; i < ca_valid.size(); ++i)
+    {
+        delete acoefs_ca[i];
+        acoefs_ca[i] = 0;
+        for (int j = 0; j < BL_SPACEDIM; ++j)
+        {
+            delete bcoefs_ca[i][j];
+            bcoefs_ca[i][j] = 0;
+        }
+        ca_valid[i] = false;
+    }
 }
 
 void
@@ -264,6 +276,54 @@ ABecLaplacian::bCoefficients (int dir,int level)
     return *bcoefs[level][dir];
 }
 
+LinOp*
+ABecLaplacian::agglomerate (int                        level,
+                            const DistributionMapping& dm,
+                            MPI_Comm                   comm)
+{
+    BL_PROFILE("ABecLaplacian::agglomerate()");
+
+    prepareForLevel(level);
+
+    MultiFab a(gbox[level], 1, 0, dm);
+
+    a.copy(*acoefs[level]);
+
+    PArray<MultiFab> b(BL_SPACEDIM, PArrayManage);
+
+    for (int i = 0; i < BL_SPACEDIM; ++i)
+    {
+        BoxArray edge_boxes(gbox[level]);
+        edge_boxes.surroundingNodes(i);
+        b.set(i, new MultiFab(edge_boxes, 1, 0, dm));
+        b[i].copy(*bcoefs[level][i]);
+    }
+
+    Array<int>  bct;
+    Array<Real> bcl;
+
+    allBndryConds(bct, bcl, dm, comm);
+
+#ifdef BL_USE_MPI
+    if (comm == MPI_COMM_NULL) return 0;
+#endif
+
+    DistributionMapping::StartSubset(comm, dm);
+
+    ABecLaplacian* lp = new ABecLaplacian(agglomeratedBndry(level, bct, bcl), h[level]);
+
+    agglomerateSettings(*lp);
+
+    lp->setScalars(alpha, beta);
+    lp->aCoefficients(a);
+    for (int i = 0; i < BL_SPACEDIM; ++i)
+        lp->bCoefficients(b[i], i);
+
+    DistributionMapping::EndSubset();
+
+    return lp;
+}
+
 void
 ABecLaplacian::setCoefficients (const MultiFab &_a,
                                 const MultiFab &_bX,
@@ -289,6 +349,8 @@ ABecLaplacian::invalidate_a_to_level (int lev)
     lev = (lev >= 0 ? lev : 0);
     for (int i = lev; i < numLevels(); i++)
         a_valid[i] = false;
+    for (int i = lev; i < ca_valid.size(); i++)
+        ca_valid[i] = false;
 }
 
 void
@@ -297,6 +359,8 @@ ABecLaplacian::invalidate_b_to_level (int lev)
     lev = (lev >= 0 ? lev : 0);
     for (int i = lev; i < numLevels(); i++)
         b_valid[i] = false;
+    for (int i = lev; i < ca_valid.size(); i++)
+        ca_valid[i] = false;
 }
 
 void
@@ -500,6 +564,198 @@ ABecLaplacian::Fsmooth (MultiFab&       solnL,
     }
 }
 
+bool
+ABecLaplacian::hasFsmooth_ca () const
+{
+#if (BL_SPACEDIM == 2)
+    //
+    // FORT_GSRB does line solves when the mesh is far from square;
+    // FORT_GSRBCA doesn't, so stick with the former then.
+    //
+    const Real hx = h[0][0], hy = h[0][1];
+
+    return !(hy > 1.5*hx || hx > 1.5*hy);
+#elif (BL_SPACEDIM == 3)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+ABecLaplacian::prepareCoefficients_ca (int level,
+                                       int ngrow)
+{
+    if (ca_valid.size() <= level)
+    {
+        const int N = ca_valid.size();
+
+        ca_valid.resize(level+1);
+        acoefs_ca.resize(level+1);
+        bcoefs_ca.resize(level+1);
+
+        for (int i = N; i <= level; i++)
+        {
+            ca_valid[i]  = false;
+            acoefs_ca[i] = 0;
+            for (int j = 0; j < BL_SPACEDIM; ++j)
+                bcoefs_ca[i][j] = 0;
+        }
+    }
+
+    if (ca_valid[level] && acoefs_ca[level]->nGrow() == ngrow)
+        return;
+
+    const MultiFab& a = aCoefficients(level);
+
+    delete acoefs_ca[level];
+    acoefs_ca[level] = new MultiFab(a.boxArray(), 1, ngrow);
+    acoefs_ca[level]->setVal(0, ngrow);
+    MultiFab::Copy(*acoefs_ca[level], a, 0, 0, 1, 0);
+    acoefs_ca[level]->FillBoundary();
+    geomarray[level].FillPeriodicBoundary(*acoefs_ca[level], true);
+
+    for (int j = 0; j < BL_SPACEDIM; ++j)
+    {
+        const MultiFab& b = bCoefficients(j,level);
+
+        delete bcoefs_ca[level][j];
+        bcoefs_ca[level][j] = new MultiFab(b.boxArray(), 1, ngrow);
+        bcoefs_ca[level][j]->setVal(0, ngrow);
+        MultiFab::Copy(*bcoefs_ca[level][j], b, 0, 0, 1, 0);
+        bcoefs_ca[level][j]->FillBoundary();
+        geomarray[level].FillPeriodicBoundary(*bcoefs_ca[level][j], true);
+    }
+
+    ca_valid[level] = true;
+}
+
+void
+ABecLaplacian::Fsmooth_ca (MultiFab&       solnL,
+                           const MultiFab& rhsL,
+                           const MultiFab& cov,
+                           int             level,
+                           int             redBlackFlag,
+                           int             ngrow)
+{
+    BL_PROFILE("ABecLaplacian::Fsmooth_ca()");
+
+    prepareCoefficients_ca(level, smoothNGrow()-1);
+
+    BL_ASSERT(solnL.nGrow() > ngrow);
+    BL_ASSERT(rhsL.nGrow() >= ngrow);
+    BL_ASSERT(cov.nGrow() > ngrow);
+    BL_ASSERT(acoefs_ca[level]->nGrow() >= ngrow);
+
+    OrientationIter oitr;
+
+    const FabSet& f0 = (*undrrelxr[level])[oitr()]; oitr++;
+    const FabSet& f1 = (*undrrelxr[level])[oitr()]; oitr++;
+    const FabSet& f2 = (*undrrelxr[level])[oitr()]; oitr++;
+    const FabSet& f3 = (*undrrelxr[level])[oitr()]; oitr++;
+#if (BL_SPACEDIM > 2)
+    const FabSet& f4 = (*undrrelxr[level])[oitr()]; oitr++;
+    const FabSet& f5 = (*undrrelxr[level])[oitr()]; oitr++;
+#endif    
+    const MultiFab& a = *acoefs_ca[level];
+
+    D_TERM(const MultiFab& bX = *bcoefs_ca[level][0];,
+           const MultiFab& bY = *bcoefs_ca[level][1];,
+           const MultiFab& bZ = *bcoefs_ca[level][2];);
+
+    const int nc = 1;
+
+    const bool tiling = true;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter solnLmfi(solnL,tiling); solnLmfi.isValid(); ++solnLmfi)
+    {
+	OrientationIter oitr;
+
+        const int gn = solnLmfi.index();
+
+        const LinOp::MaskTuple& mtuple = maskvals[level][gn];
+
+        const Mask& m0 = *mtuple[oitr()]; oitr++;
+        const Mask& m1 = *mtuple[oitr()]; oitr++;
+        const Mask& m2 = *mtuple[oitr()]; oitr++;
+        const Mask& m3 = *mtuple[oitr()]; oitr++;
+#if (BL_SPACEDIM > 2)
+        const Mask& m4 = *mtuple[oitr()]; oitr++;
+        const Mask& m5 = *mtuple[oitr()]; oitr++;
+#endif
+        //
+        // The tiles of the valid region grown by ngrow.
+        //
+	const Box&       tbx     = solnLmfi.growntilebox(ngrow);
+        const Box&       vbx     = solnLmfi.validbox();
+        FArrayBox&       solnfab = solnL[solnLmfi];
+        const FArrayBox& rhsfab  = rhsL[solnLmfi];
+        const FArrayBox& afab    = a[solnLmfi];
+        const FArrayBox& covfab  = cov[solnLmfi];
+
+        D_TERM(const FArrayBox& bxfab = bX[solnLmfi];,
+               const FArrayBox& byfab = bY[solnLmfi];,
+               const FArrayBox& bzfab = bZ[solnLmfi];);
+
+        const FArrayBox& f0fab = f0[solnLmfi];
+        const FArrayBox& f1fab = f1[solnLmfi];
+        const FArrayBox& f2fab = f2[solnLmfi];
+        const FArrayBox& f3fab = f3[solnLmfi];
+#if (BL_SPACEDIM > 2)
+        const FArrayBox& f4fab = f4[solnLmfi];
+        const FArrayBox& f5fab = f5[solnLmfi];
+#endif
+
+#if (BL_SPACEDIM == 2)
+        FORT_GSRBCA(solnfab.dataPtr(), ARLIM(solnfab.loVect()),ARLIM(solnfab.hiVect()),
+                    rhsfab.dataPtr(), ARLIM(rhsfab.loVect()), ARLIM(rhsfab.hiVect()),
+                    &alpha, &beta,
+                    afab.dataPtr(), ARLIM(afab.loVect()),    ARLIM(afab.hiVect()),
+                    bxfab.dataPtr(), ARLIM(bxfab.loVect()),   ARLIM(bxfab.hiVect()),
+                    byfab.dataPtr(), ARLIM(byfab.loVect()),   ARLIM(byfab.hiVect()),
+                    f0fab.dataPtr(), ARLIM(f0fab.loVect()),   ARLIM(f0fab.hiVect()),
+                    m0.dataPtr(), ARLIM(m0.loVect()),   ARLIM(m0.hiVect()),
+                    f1fab.dataPtr(), ARLIM(f1fab.loVect()),   ARLIM(f1fab.hiVect()),
+                    m1.dataPtr(), ARLIM(m1.loVect()),   ARLIM(m1.hiVect()),
+                    f2fab.dataPtr(), ARLIM(f2fab.loVect()),   ARLIM(f2fab.hiVect()),
+                    m2.dataPtr(), ARLIM(m2.loVect()),   ARLIM(m2.hiVect()),
+                    f3fab.dataPtr(), ARLIM(f3fab.loVect()),   ARLIM(f3fab.hiVect()),
+                    m3.dataPtr(), ARLIM(m3.loVect()),   ARLIM(m3.hiVect()),
+                    covfab.dataPtr(), ARLIM(covfab.loVect()), ARLIM(covfab.hiVect()),
+                    tbx.loVect(), tbx.hiVect(), vbx.loVect(), vbx.hiVect(),
+                    &nc, h[level], &redBlackFlag);
+#endif
+
+#if (BL_SPACEDIM == 3)
+        FORT_GSRBCA(solnfab.dataPtr(), ARLIM(solnfab.loVect()),ARLIM(solnfab.hiVect()),
+                    rhsfab.dataPtr(), ARLIM(rhsfab.loVect()), ARLIM(rhsfab.hiVect()),
+                    &alpha, &beta,
+                    afab.dataPtr(), ARLIM(afab.loVect()), ARLIM(afab.hiVect()),
+                    bxfab.dataPtr(), ARLIM(bxfab.loVect()), ARLIM(bxfab.hiVect()),
+                    byfab.dataPtr(), ARLIM(byfab.loVect()), ARLIM(byfab.hiVect()),
+                    bzfab.dataPtr(), ARLIM(bzfab.loVect()), ARLIM(bzfab.hiVect()),
+                    f0fab.dataPtr(), ARLIM(f0fab.loVect()), ARLIM(f0fab.hiVect()),
+                    m0.dataPtr(), ARLIM(m0.loVect()), ARLIM(m0.hiVect()),
+                    f1fab.dataPtr(), ARLIM(f1fab.loVect()), ARLIM(f1fab.hiVect()),
+                    m1.dataPtr(), ARLIM(m1.loVect()), ARLIM(m1.hiVect()),
+                    f2fab.dataPtr(), ARLIM(f2fab.loVect()), ARLIM(f2fab.hiVect()),
+                    m2.dataPtr(), ARLIM(m2.loVect()), ARLIM(m2.hiVect()),
+                    f3fab.dataPtr(), ARLIM(f3fab.loVect()), ARLIM(f3fab.hiVect()),
+                    m3.dataPtr(), ARLIM(m3.loVect()), ARLIM(m3.hiVect()),
+                    f4fab.dataPtr(), ARLIM(f4fab.loVect()), ARLIM(f4fab.hiVect()),
+                    m4.dataPtr(), ARLIM(m4.loVect()), ARLIM(m4.hiVect()),
+                    f5fab.dataPtr(), ARLIM(f5fab.loVect()), ARLIM(f5fab.hiVect()),
+                    m5.dataPtr(), ARLIM(m5.loVect()), ARLIM(m5.hiVect()),
+                    covfab.dataPtr(), ARLIM(covfab.loVect()), ARLIM(covfab.hiVect()),
+                    tbx.loVect(), tbx.hiVect(), vbx.loVect(), vbx.hiVect(),
+                    &nc, h[level], &redBlackFlag);
+#endif
+    }
+}
+
 void
 ABecLaplacian::Fsmooth_jacobi (MultiFab&       solnL,
                                const MultiFab& rhsL,
@@ -294,6 +294,174 @@ dotxy (const MultiFab& r,
     return dotxy(r,0,z,0,local);
 }
 
+//
+// The following fused kernels return local (unreduced) results so that
+// callers can gather them into a single ParallelDescriptor::ReduceBatch.
+// Per-fab partial dot products are summed in fab order so the results
+// don't depend on the number of threads.
+//
+
+//
+// ss = xx + a*yy, returning the local max norm of ss, and
+// optionally the local value of the dot product ss.ss.
+//
+static
+Real
+sxay_norm (MultiFab&       ss,
+           const MultiFab& xx,
+           Real            a,
+           const MultiFab& yy,
+           Real*           ssq = 0)
+{
+    BL_PROFILE("CGSolver::sxay_norm()");
+
+    const int ncomp = 1;
+
+    Array<Real> nrms(ss.local_size(), 0), ssqs(ss.local_size(), 0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(ss); mfi.isValid(); ++mfi)
+    {
+        const Box&       bx    = mfi.validbox();
+        FArrayBox&       ssfab = ss[mfi];
+        const FArrayBox& xxfab = xx[mfi];
+        const FArrayBox& yyfab = yy[mfi];
+
+        FORT_CGSXAYNRM(ssfab.dataPtr(),
+                       ARLIM(ssfab.loVect()), ARLIM(ssfab.hiVect()),
+                       xxfab.dataPtr(),
+                       ARLIM(xxfab.loVect()), ARLIM(xxfab.hiVect()),
+                       &a,
+                       yyfab.dataPtr(),
+                       ARLIM(yyfab.loVect()), ARLIM(yyfab.hiVect()),
+                       &nrms[mfi.LocalIndex()], &ssqs[mfi.LocalIndex()],
+                       bx.loVect(), bx.hiVect(),
+                       &ncomp);
+    }
+
+    Real nrm = 0;
+
+    for (int i = 0, N = nrms.size(); i < N; i++)
+        nrm = std::max(nrm, nrms[i]);
+
+    if (ssq)
+    {
+        *ssq = 0;
+        for (int i = 0, N = ssqs.size(); i < N; i++)
+            *ssq += ssqs[i];
+    }
+
+    return nrm;
+}
+
+//
+// ss = xx + a*yy, returning the local max norm of ss and the
+// local value of the dot product of the updated ss with zz.
+//
+static
+Real
+sxay_norm_dot (MultiFab&       ss,
+               const MultiFab& xx,
+               Real            a,
+               const MultiFab& yy,
+               const MultiFab& zz,
+               Real&           dot)
+{
+    BL_PROFILE("CGSolver::sxay_norm_dot()");
+
+    const int ncomp = 1;
+
+    Array<Real> nrms(ss.local_size(), 0), dots(ss.local_size(), 0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(ss); mfi.isValid(); ++mfi)
+    {
+        const Box&       bx    = mfi.validbox();
+        const int        li    = mfi.LocalIndex();
+        FArrayBox&       ssfab = ss[mfi];
+        const FArrayBox& xxfab = xx[mfi];
+        const FArrayBox& yyfab = yy[mfi];
+        const FArrayBox& zzfab = zz[mfi];
+
+        FORT_CGSXAYNRMDOT(ssfab.dataPtr(),
+                          ARLIM(ssfab.loVect()), ARLIM(ssfab.hiVect()),
+                          xxfab.dataPtr(),
+                          ARLIM(xxfab.loVect()), ARLIM(xxfab.hiVect()),
+                          &a,
+                          yyfab.dataPtr(),
+                          ARLIM(yyfab.loVect()), ARLIM(yyfab.hiVect()),
+                          zzfab.dataPtr(),
+                          ARLIM(zzfab.loVect()), ARLIM(zzfab.hiVect()),
+                          &nrms[li], &dots[li],
+                          bx.loVect(), bx.hiVect(),
+                          &ncomp);
+    }
+
+    Real nrm = 0;
+
+    dot = 0;
+
+    for (int i = 0, N = nrms.size(); i < N; i++)
+    {
+        nrm  = std::max(nrm, nrms[i]);
+        dot += dots[i];
+    }
+
+    return nrm;
+}
+
+//
+// Local values of the two dot products pp.ww1 & pp.ww2 in one pass over pp.
+//
+static
+void
+dotxy2 (const MultiFab& pp,
+        const MultiFab& ww1,
+        const MultiFab& ww2,
+        Real&           dot1,
+        Real&           dot2)
+{
+    BL_PROFILE("CGSolver::dotxy2()");
+
+    const int ncomp = 1;
+
+    Array<Real> dots1(pp.local_size(), 0), dots2(pp.local_size(), 0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(pp); mfi.isValid(); ++mfi)
+    {
+        const Box&       bx     = mfi.validbox();
+        const int        li     = mfi.LocalIndex();
+        const FArrayBox& ppfab  = pp[mfi];
+        const FArrayBox& ww1fab = ww1[mfi];
+        const FArrayBox& ww2fab = ww2[mfi];
+
+        FORT_CGXDOTY2(&dots1[li], &dots2[li],
+                      ppfab.dataPtr(),
+                      ARLIM(ppfab.loVect()), ARLIM(ppfab.hiVect()),
+                      ww1fab.dataPtr(),
+                      ARLIM(ww1fab.loVect()), ARLIM(ww1fab.hiVect()),
+                      ww2fab.dataPtr(),
+                      ARLIM(ww2fab.loVect()), ARLIM(ww2fab.hiVect()),
+                      bx.loVect(), bx.hiVect(),
+                      &ncomp);
+    }
+
+    dot1 = dot2 = 0;
+
+    for (int i = 0, N = dots1.size(); i < N; i++)
+    {
+        dot1 += dots1[i];
+        dot2 += dots2[i];
+    }
+}
+
 //
 // z[m] = A[m][n]*x[n]   [row][col]
 //
@@ -1422,21 +1590,31 @@ CGSolver::solve_bicgstab (MultiFab&       sol,
 
     const LinOp::BC_Mode temp_bc_mode = LinOp::Homogeneous_BC;
 
-#ifdef CG_USE_OLD_CONVERGENCE_CRITERIA
-    Real rnorm = norm_inf(r);
-#else
     //
-    // Calculate the local values of these norms & reduce their values together.
+    // Reductions are latency bound, so the local values needed at each
+    // step are gathered into a ReduceBatch and reduced together; that
+    // leaves four global reductions per iteration, down from seven.
+    // The reduction of the half-step norms is overlapped with the second
+    // preconditioner application when that's cheap.
     //
-    Real vals[2] = { norm_inf(r, true), Lp.norm(0, lev, true) };
+    ParallelDescriptor::ReduceBatch rb;
+
+    const int irnorm = rb.addMax(norm_inf(r, true));
+#ifndef CG_USE_OLD_CONVERGENCE_CRITERIA
+    const int ilp    = rb.addMax(Lp.norm(0, lev, true));
+#endif
+    const int irho   = rb.addSum(dotxy(rh, r, true));
 
-    ParallelDescriptor::ReduceRealMax(vals,2);
+    rb.reduce();
 
-    Real       rnorm    = vals[0];
-    const Real Lp_norm  = vals[1];
+    Real       rnorm    = rb[irnorm];
+    res_history.assign(1, rnorm);
+#ifndef CG_USE_OLD_CONVERGENCE_CRITERIA
+    const Real Lp_norm  = rb[ilp];
     Real       sol_norm = 0;
 #endif
     const Real rnorm0   = rnorm;
+    Real       rho      = rb[irho];
 
     if ( verbose > 0 && ParallelDescriptor::IOProcessor() )
     {
@@ -1460,7 +1638,6 @@ CGSolver::solve_bicgstab (MultiFab&       sol,
 
     for (; nit <= maxiter; ++nit)
     {
-        const Real rho = dotxy(rh,r);
         if ( rho == 0 ) 
 	{
             ret = 1; break;
@@ -1499,10 +1676,37 @@ CGSolver::solve_bicgstab (MultiFab&       sol,
 	{
             ret = 2; break;
 	}
-        sxay(sol, sol,  alpha, ph);
-        sxay(s,     r, -alpha,  v);
 
-        rnorm = norm_inf(s);
+        rb.clear();
+#ifdef CG_USE_OLD_CONVERGENCE_CRITERIA
+        sxay(sol, sol, alpha, ph);
+#else
+        const int ihsol = rb.addMax(sxay_norm(sol, sol, alpha, ph));
+#endif
+        const int ihs   = rb.addMax(sxay_norm(s, r, -alpha, v));
+        rb.post();
+        //
+        // The cheap preconditioners are applied while the reduction is
+        // in flight; an MG solve is too expensive to waste if we converge.
+        //
+        if ( !use_mg_precond )
+        {
+            if ( use_jacobi_precond )
+            {
+                sh.setVal(0);
+                Lp.jacobi_smooth(sh, s, lev, temp_bc_mode);
+            }
+            else
+            {
+                MultiFab::Copy(sh,s,0,0,1,0);
+            }
+            Lp.apply(t, sh, lev, temp_bc_mode);
+        }
+
+        rb.wait();
+
+        rnorm = rb[ihs];
+        res_history.push_back(rnorm);
 
         if ( verbose > 2 && ParallelDescriptor::IOProcessor() )
         {
@@ -1516,45 +1720,50 @@ CGSolver::solve_bicgstab (MultiFab&       sol,
 #ifdef CG_USE_OLD_CONVERGENCE_CRITERIA
         if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
 #else
-        sol_norm = norm_inf(sol);
+        sol_norm = rb[ihsol];
         if ( rnorm < eps_rel*(Lp_norm*sol_norm + rnorm0 ) || rnorm < eps_abs ) break;
 #endif
         if ( use_mg_precond )
         {
             sh.setVal(0);
             mg_precond->solve(sh, s, eps_rel, eps_abs, temp_bc_mode);
+            Lp.apply(t, sh, lev, temp_bc_mode);
         }
-        else if ( use_jacobi_precond )
-        {
-            sh.setVal(0);
-            Lp.jacobi_smooth(sh, s, lev, temp_bc_mode);
-        }
-        else
-        {
-            MultiFab::Copy(sh,s,0,0,1,0);
-        }
-        Lp.apply(t, sh, lev, temp_bc_mode);
-        //
-        // This is a little funky.  I want to elide one of the reductions
-        // in the following two dotxy()s.  We do that by calculating the "local"
-        // values and then reducing the two local values at the same time.
-        //
-        Real vals[2] = { dotxy(t,t,true), dotxy(t,s,true) };
 
-        ParallelDescriptor::ReduceRealSum(vals,2);
+        Real tt, ts;
+
+        dotxy2(t, t, s, tt, ts);
 
-        if ( vals[0] )
+        rb.clear();
+        const int itt = rb.addSum(tt);
+        const int its = rb.addSum(ts);
+        rb.reduce();
+
+        if ( rb[itt] )
 	{
-            omega = vals[1]/vals[0];
+            omega = rb[its]/rb[itt];
 	}
         else
 	{
             ret = 3; break;
 	}
-        sxay(sol, sol,  omega, sh);
-        sxay(r,     s, -omega,  t);
+        //
+        // Update sol & r, also picking up the norms and the next rho.
+        //
+        Real rhor;
+
+        rb.clear();
+#ifdef CG_USE_OLD_CONVERGENCE_CRITERIA
+        sxay(sol, sol, omega, sh);
+#else
+        const int isol = rb.addMax(sxay_norm(sol, sol, omega, sh));
+#endif
+        const int irn = rb.addMax(sxay_norm_dot(r, s, -omega, t, rh, rhor));
+        const int irh = rb.addSum(rhor);
+        rb.reduce();
 
-        rnorm = norm_inf(r);
+        rnorm = rb[irn];
+        res_history.push_back(rnorm);
 
         if ( verbose > 2 && ParallelDescriptor::IOProcessor() )
         {
@@ -1568,7 +1777,7 @@ CGSolver::solve_bicgstab (MultiFab&       sol,
 #ifdef CG_USE_OLD_CONVERGENCE_CRITERIA
         if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
 #else
-        sol_norm = norm_inf(sol);
+        sol_norm = rb[isol];
         if ( rnorm < eps_rel*(Lp_norm*sol_norm + rnorm0 ) || rnorm < eps_abs ) break;
 #endif
         if ( omega == 0 )
@@ -1576,6 +1785,7 @@ CGSolver::solve_bicgstab (MultiFab&       sol,
             ret = 4; break;
 	}
         rho_1 = rho;
+        rho   = rb[irh];
     }
 
     if ( verbose > 0 && ParallelDescriptor::IOProcessor() )
@@ -1645,7 +1855,22 @@ CGSolver::solve_cg (MultiFab&       sol,
 
     const LinOp::BC_Mode temp_bc_mode=LinOp::Homogeneous_BC;
 
-    Real       rnorm    = norm_inf(r);
+    //
+    // Without the jbb preconditioner z == r, so the next rho = r.r is
+    // picked up while updating r and reduced along with the norms.
+    //
+    const bool jbb = use_jbb_precond && ParallelDescriptor::NProcs() > 1;
+
+    ParallelDescriptor::ReduceBatch rb;
+
+    const int irnorm = rb.addMax(norm_inf(r, true));
+    const int ilp    = rb.addMax(Lp.norm(0, lev, true));
+    const int irho   = jbb ? -1 : rb.addSum(dotxy(r, r, true));
+
+    rb.reduce();
+
+    Real       rnorm    = rb[irnorm];
+    res_history.assign(1, rnorm);
     const Real rnorm0   = rnorm;
     Real       minrnorm = rnorm;
 
@@ -1655,8 +1880,9 @@ CGSolver::solve_cg (MultiFab&       sol,
         std::cout << "              CG: Initial error :        " << rnorm0 << '\n';
     }
 
-    const Real Lp_norm = Lp.norm(0, lev);
+    const Real Lp_norm = rb[ilp];
     Real sol_norm      = 0;
+    Real rho           = jbb ? 0 : rb[irho];
     Real rho_1         = 0;
     int  ret           = 0;
     int  nit           = 1;
@@ -1676,27 +1902,25 @@ CGSolver::solve_cg (MultiFab&       sol,
 
     for (; nit <= maxiter; ++nit)
     {
-        if (use_jbb_precond && ParallelDescriptor::NProcs() > 1)
+        if (jbb)
         {
             z.setVal(0);
 
             jbb_precond(z,r,lev,Lp);
-        }
-        else
-        {
-            MultiFab::Copy(z,r,0,0,1,0);
+
+            rho = dotxy(z,r);
         }
 
-        Real rho = dotxy(z,r);
+        const MultiFab& zz = jbb ? z : r;
 
         if (nit == 1)
         {
-            MultiFab::Copy(p,z,0,0,1,0);
+            MultiFab::Copy(p,zz,0,0,1,0);
         }
         else
         {
             Real beta = rho/rho_1;
-            sxay(p, z, beta, p);
+            sxay(p, zz, beta, p);
         }
         Lp.apply(q, p, lev, temp_bc_mode);
 
@@ -1718,10 +1942,16 @@ CGSolver::solve_cg (MultiFab&       sol,
                       << " rho " << rho
                       << " alpha " << alpha << '\n';
         }
-        sxay(sol, sol, alpha, p);
-        sxay(  r,   r,-alpha, q);
-        rnorm = norm_inf(r);
-        sol_norm = norm_inf(sol);
+        rb.clear();
+        Real rr;
+        const int isol = rb.addMax(sxay_norm(sol, sol, alpha, p));
+        const int irn  = rb.addMax(sxay_norm(r, r, -alpha, q, &rr));
+        const int irr  = jbb ? -1 : rb.addSum(rr);
+        rb.reduce();
+
+        rnorm    = rb[irn];
+        res_history.push_back(rnorm);
+        sol_norm = rb[isol];
 
         if ( verbose > 2 && ParallelDescriptor::IOProcessor() )
         {
@@ -1747,6 +1977,9 @@ CGSolver::solve_cg (MultiFab&       sol,
 	}
 
         rho_1 = rho;
+
+        if (!jbb)
+            rho = rb[irr];
     }
     
     if ( verbose > 0 && ParallelDescriptor::IOProcessor() )
@@ -1,5 +1,6 @@
 
 #include <winstd.H>
+#include <algorithm>
 #include <cstdlib>
 
 #include <ParmParse.H>
@@ -18,6 +19,7 @@ namespace
 int LinOp::def_harmavg;
 int LinOp::def_verbose;
 int LinOp::def_maxorder;
+int LinOp::def_smooth_ngrow;
 
 #ifndef NDEBUG
 //
@@ -38,17 +40,23 @@ LinOp::Initialize ()
     LinOp::def_harmavg  = 0;
     LinOp::def_verbose  = 0;
     LinOp::def_maxorder = 2;
+    LinOp::def_smooth_ngrow = 1;
 
     ParmParse pp("Lp");
 
     pp.query("harmavg",  def_harmavg);
     pp.query("v",        def_verbose);
     pp.query("maxorder", def_maxorder);
+    pp.query("smooth_ngrow", def_smooth_ngrow);
+
+    if (def_smooth_ngrow < 1)
+        BoxLib::Abort("LinOp::Initialize(): Lp.smooth_ngrow must be >= 1");
 
     if (ParallelDescriptor::IOProcessor() && def_verbose)
     {
         std::cout << "def_harmavg = "  << def_harmavg  << '\n';
         std::cout << "def_maxorder = " << def_maxorder << '\n';
+        std::cout << "def_smooth_ngrow = " << def_smooth_ngrow << '\n';
     }
 
     BoxLib::ExecOnFinalize(LinOp::Finalize);
@@ -138,12 +146,14 @@ LinOp::initConstruct (const Real* _h)
     h.reserve(N);
     gbox.reserve(N);
     undrrelxr.reserve(N);
+    smooth_cov.reserve(N);
     maskvals.reserve(N);
     lmaskvals.reserve(N);
     geomarray.reserve(N);
 
     harmavg = def_harmavg;
     verbose = def_verbose;
+    agg_nprocs = 0;
     gbox.resize(1);
     const int level = 0;
     gbox[level] = bgb->boxes();
@@ -151,6 +161,7 @@ LinOp::initConstruct (const Real* _h)
     geomarray[level] = bgb->getGeom();
     h.resize(1);
     maxorder = def_maxorder;
+    smooth_ngrow = def_smooth_ngrow;
 
     for (int i = 0; i < BL_SPACEDIM; i++)
     {
@@ -224,15 +235,6 @@ LinOp::applyBC (MultiFab&      inout,
     BL_ASSERT(level < numLevels());
     BL_ASSERT(!(level > 0 && bc_mode == Inhomogeneous_BC));
 
-    int flagden = 1; // Fill in undrrelxr.
-    int flagbc  = 1; // Fill boundary data.
-
-    if (bc_mode == LinOp::Homogeneous_BC)
-        //
-        // No data if homogeneous.
-        //
-        flagbc = 0;
-
     const bool cross = true;
 
     inout.FillBoundary(src_comp,num_comp,local,cross);
@@ -246,7 +248,32 @@ LinOp::applyBC (MultiFab&      inout,
     //
     // Fill boundary cells.
     //
+    applyBndryConds(inout,src_comp,num_comp,level,bc_mode,local,bndry_comp);
+}
+
+void
+LinOp::applyBndryConds (MultiFab&      inout,
+                        int            src_comp,
+                        int            num_comp,
+                        int            level,
+                        LinOp::BC_Mode bc_mode,
+                        bool           local,
+                        int            bndry_comp)
+{
+    BL_ASSERT(level < numLevels());
+    BL_ASSERT(!(level > 0 && bc_mode == Inhomogeneous_BC));
+
+    int flagden = 1; // Fill in undrrelxr.
+    int flagbc  = 1; // Fill boundary data.
+
+    if (bc_mode == LinOp::Homogeneous_BC)
+        //
+        // No data if homogeneous.
+        //
+        flagbc = 0;
+    //
     // OMP over boxes
+    //
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -348,13 +375,114 @@ void
 LinOp::smooth (MultiFab&       solnL,
                const MultiFab& rhsL,
                int             level,
-               LinOp::BC_Mode  bc_mode)
+               LinOp::BC_Mode  bc_mode,
+               int             nsmooth)
 {
-    for (int redBlackFlag = 0; redBlackFlag < 2; redBlackFlag++)
+    //
+    // Level 0 is bandwidth bound and the lagging ghost cells cost more
+    // iterations than the exchanges they save, so it's left alone.
+    //
+    if (smooth_ngrow <= 1 || !hasFsmooth_ca() || level == 0)
+    {
+        for (int i = 0; i < nsmooth; i++)
+        {
+            for (int redBlackFlag = 0; redBlackFlag < 2; redBlackFlag++)
+            {
+                applyBC(solnL, 0, 1, level, bc_mode);
+                Fsmooth(solnL, rhsL, level, redBlackFlag);
+            }
+        }
+        return;
+    }
+
+    BL_PROFILE("LinOp::smooth()");
+
+    prepareForLevel(level);
+
+    const MultiFab& cov = smoothCover(level);
+
+    const int ngrow = smooth_ngrow;
+    const int nhalf = 2*nsmooth;
+
+    MultiFab sol(gbox[level], 1, ngrow);
+    MultiFab rhs(gbox[level], 1, ngrow-1);
+
+    BL_ASSERT(sol.DistributionMap() == solnL.DistributionMap());
+
+    MultiFab::Copy(sol, solnL, 0, 0, 1, 0);
+    MultiFab::Copy(rhs, rhsL,  0, 0, 1, 0);
+
+    const Geometry& geom = geomarray[level];
+
+    for (int t0 = 0; t0 < nhalf; t0 += ngrow)
     {
-        applyBC(solnL, 0, 1, level, bc_mode);
-        Fsmooth(solnL, rhsL, level, redBlackFlag);
+        //
+        // Fill all the ghost cells, corners included.  The first time we
+        // need the ghost cells of rhs too, and get them in the same go.
+        //
+        sol.FillBoundary_nowait();
+        geom.FillPeriodicBoundary_nowait(sol, true);
+
+        if (t0 == 0)
+        {
+            rhs.FillBoundary_nowait();
+            geom.FillPeriodicBoundary_nowait(rhs, true);
+        }
+
+        sol.FillBoundary_finish();
+        geom.FillPeriodicBoundary_finish(sol);
+
+        if (t0 == 0)
+        {
+            rhs.FillBoundary_finish();
+            geom.FillPeriodicBoundary_finish(rhs);
+        }
+        //
+        // Each half-sweep spoils another layer of ghost cells.
+        //
+        const int tend = std::min(t0+ngrow, nhalf);
+
+        for (int t = t0; t < tend; t++)
+        {
+            applyBndryConds(sol, 0, 1, level, bc_mode, false, 0);
+            Fsmooth_ca(sol, rhs, cov, level, t%2, tend-1-t);
+        }
     }
+
+    MultiFab::Copy(solnL, sol, 0, 0, 1, 0);
+}
+
+void
+LinOp::Fsmooth_ca (MultiFab&       solnL,
+                   const MultiFab& rhsL,
+                   const MultiFab& cov,
+                   int             level,
+                   int             rgbflag,
+                   int             ngrow)
+{
+    BoxLib::Error("LinOp::Fsmooth_ca: not implemented for this LinOp");
+}
+
+const MultiFab&
+LinOp::smoothCover (int level)
+{
+    if (smooth_cov.size() <= level)
+        smooth_cov.resize(level+1);
+
+    if (smooth_cov[level].isNull() || smooth_cov[level]->nGrow() != smooth_ngrow)
+    {
+        MultiFab* cov = new MultiFab(gbox[level], 1, smooth_ngrow);
+
+        cov->setVal(0, smooth_ngrow);
+        cov->setVal(1, 0);
+
+        cov->FillBoundary();
+        geomarray[level].FillPeriodicBoundary(*cov, true);
+
+        smooth_cov[level] = cov;
+    }
+
+    return *smooth_cov[level];
 }
 
 void
@@ -709,6 +837,15 @@ LinOp::bCoefficients (int dir,int level)
     return junk;
 }
 
+int
+LinOp::smoothNGrow (int ngrow)
+{
+    BL_ASSERT(ngrow >= 1);
+    int ongrow = smooth_ngrow;
+    smooth_ngrow = (ngrow < 1 ? 1 : ngrow);
+    return ongrow;
+}
+
 int
 LinOp::maxOrder (int maxorder_)
 {
@@ -718,3 +855,116 @@ LinOp::maxOrder (int maxorder_)
     maxorder = maxorder_;
     return omaxorder;
 }
+
+LinOp*
+LinOp::agglomerate (int                        level,
+                    const DistributionMapping& dm,
+                    MPI_Comm                   comm)
+{
+    BoxLib::Error("LinOp::agglomerate(): not implemented");
+
+    return 0;
+}
+
+void
+LinOp::allBndryConds (Array<int>&                bct,
+                      Array<Real>&               bcl,
+                      const DistributionMapping& dm,
+                      MPI_Comm                   comm) const
+{
+    const int N  = gbox[0].size();
+    const int NC = bgb->nComp();
+
+    int nprocs = 0;
+    for (int i = 0; i < N; i++)
+        nprocs = std::max(nprocs, dm[i]+1);
+
+    if (agg_nprocs < nprocs)
+    {
+        agg_bct.resize(N*2*BL_SPACEDIM*NC);
+        agg_bcl.resize(N*2*BL_SPACEDIM);
+
+        std::fill(agg_bct.begin(), agg_bct.end(), 0);
+        std::fill(agg_bcl.begin(), agg_bcl.end(), 0);
+
+        for (FabSetIter bndryfsi((*bgb)[Orientation(0,Orientation::low)]);
+             bndryfsi.isValid();
+             ++bndryfsi)
+        {
+            const int                        gn  = bndryfsi.index();
+            const BndryData::RealTuple&      bdl = bgb->bndryLocs(gn);
+            const Array< Array<BoundCond> >& bdc = bgb->bndryConds(gn);
+
+            for (OrientationIter oitr; oitr; ++oitr)
+            {
+                const Orientation o = oitr();
+
+                agg_bcl[gn*2*BL_SPACEDIM+o] = bdl[o];
+
+                for (int n = 0; n < NC; n++)
+                    agg_bct[(gn*2*BL_SPACEDIM+o)*NC+n] = bdc[o][n];
+            }
+        }
+        //
+        // Each grid's entries are set by its owner only, so a sum onto
+        // processor 0, which is the first of comm, gathers them.  Only
+        // comm needs them from there.
+        //
+        ParallelDescriptor::ReduceIntSum(agg_bct.dataPtr(), agg_bct.size(), 0);
+        ParallelDescriptor::ReduceRealSum(agg_bcl.dataPtr(), agg_bcl.size(), 0);
+
+#ifdef BL_USE_MPI
+        if (comm != MPI_COMM_NULL)
+        {
+            BL_MPI_REQUIRE( MPI_Bcast(agg_bct.dataPtr(), agg_bct.size(), MPI_INT, 0, comm) );
+            BL_MPI_REQUIRE( MPI_Bcast(agg_bcl.dataPtr(), agg_bcl.size(),
+                                      ParallelDescriptor::Mpi_typemap<Real>::type(), 0, comm) );
+        }
+#endif
+
+        agg_nprocs = nprocs;
+    }
+
+    bct = agg_bct;
+    bcl = agg_bcl;
+}
+
+BndryData*
+LinOp::agglomeratedBndry (int                level,
+                          const Array<int>&  bct,
+                          const Array<Real>& bcl) const
+{
+    const int NC = bgb->nComp();
+
+    BndryData* bd = new BndryData(gbox[level], NC, geomarray[level]);
+
+    for (FabSetIter bndryfsi((*bd)[Orientation(0,Orientation::low)]);
+         bndryfsi.isValid();
+         ++bndryfsi)
+    {
+        const int gn = bndryfsi.index();
+
+        for (OrientationIter oitr; oitr; ++oitr)
+        {
+            const Orientation o = oitr();
+
+            bd->setValue(o, gn, 0);
+
+            bd->setBoundLoc(o, gn, bcl[gn*2*BL_SPACEDIM+o]);
+
+            for (int n = 0; n < NC; n++)
+                bd->setBoundCond(o, gn, n, bct[(gn*2*BL_SPACEDIM+o)*NC+n]);
+        }
+    }
+
+    return bd;
+}
+
+void
+LinOp::agglomerateSettings (LinOp& lp) const
+{
+    lp.harmavg      = harmavg;
+    lp.verbose      = verbose;
+    lp.maxorder     = maxorder;
+    lp.smooth_ngrow = smooth_ngrow;
+}
@@ -10,9 +10,30 @@
 #include <MG_F.H>
 #include <MultiGrid.H>
 
+#include <map>
+
 namespace
 {
     bool initialized = false;
+    //
+    // Sub-communicators for the bottom solve, by number of processors.
+    //
+    std::map<int,MPI_Comm> bottom_comms;
+
+    MPI_Comm
+    BottomCommunicator (int nprocs)
+    {
+        std::map<int,MPI_Comm>::const_iterator it = bottom_comms.find(nprocs);
+
+        if (it != bottom_comms.end())
+            return it->second;
+
+        MPI_Comm comm = ParallelDescriptor::SubCommunicator(nprocs);
+
+        bottom_comms[nprocs] = comm;
+
+        return comm;
+    }
 }
 //
 // Set default values for these in Initialize()!!!
@@ -31,6 +52,7 @@ int              MultiGrid::def_maxiter_b;
 int              MultiGrid::def_numLevelsMAX;
 int              MultiGrid::def_smooth_on_cg_unstable;
 int              MultiGrid::use_Anorm_for_convergence;
+int              MultiGrid::def_bottom_nprocs;
 
 void
 MultiGrid::Initialize ()
@@ -56,6 +78,7 @@ MultiGrid::Initialize ()
     MultiGrid::def_maxiter_b             = 120;
     MultiGrid::def_numLevelsMAX          = 1024;
     MultiGrid::def_smooth_on_cg_unstable = 1;
+    MultiGrid::def_bottom_nprocs         = 0;
 
     // This has traditionally been part of the stopping criteria, but for testing against
     //  other solvers it is convenient to be able to turn it off
@@ -77,6 +100,7 @@ MultiGrid::Initialize ()
     pp.query("maxiter_b",             def_maxiter_b);
     pp.query("numLevelsMAX",          def_numLevelsMAX);
     pp.query("smooth_on_cg_unstable", def_smooth_on_cg_unstable);
+    pp.query("bottom_nprocs",         def_bottom_nprocs);
 
     pp.query("use_Anorm_for_convergence", use_Anorm_for_convergence);
 #ifndef CG_USE_OLD_CONVERGENCE_CRITERIA
@@ -102,6 +126,7 @@ MultiGrid::Initialize ()
         std::cout << "   def_maxiter_b             = " << def_maxiter_b             << '\n';
         std::cout << "   def_numLevelsMAX          = " << def_numLevelsMAX          << '\n';
         std::cout << "   def_smooth_on_cg_unstable = " << def_smooth_on_cg_unstable << '\n';
+        std::cout << "   def_bottom_nprocs         = " << def_bottom_nprocs         << '\n';
         std::cout << "   use_Anorm_for_convergence = " << use_Anorm_for_convergence << '\n';
     }
 
@@ -113,7 +138,15 @@ MultiGrid::Initialize ()
 void
 MultiGrid::Finalize ()
 {
-    ;
+    for (std::map<int,MPI_Comm>::iterator it = bottom_comms.begin();
+         it != bottom_comms.end();
+         ++it)
+    {
+        ParallelDescriptor::Comm_free(it->second);
+    }
+    bottom_comms.clear();
+
+    initialized = false;
 }
 
 static
@@ -143,7 +176,12 @@ Spacer (std::ostream& os, int lev)
 MultiGrid::MultiGrid (LinOp &_Lp)
     :
     initialsolution(0),
-    Lp(_Lp)
+    Lp(_Lp),
+    bottom_comm(MPI_COMM_NULL),
+    bottom_sol(0),
+    bottom_rhs(0),
+    bottom_op(0),
+    bottom_mg(0)
 {
     Initialize();
 
@@ -160,6 +198,7 @@ MultiGrid::MultiGrid (LinOp &_Lp)
     nu_b         = def_nu_b;
     numLevelsMAX = def_numLevelsMAX;
     smooth_on_cg_unstable = def_smooth_on_cg_unstable;
+    bottom_nprocs = def_bottom_nprocs;
     numlevels    = numLevels();
 
     do_fixed_number_of_iters = 0;
@@ -206,6 +245,10 @@ MultiGrid::MultiGrid (LinOp &_Lp)
 MultiGrid::~MultiGrid ()
 {
     delete initialsolution;
+    delete bottom_mg;
+    delete bottom_op;
+    delete bottom_sol;
+    delete bottom_rhs;
 
     for (int i = 0; i < cor.size(); ++i)
     {
@@ -526,10 +569,7 @@ MultiGrid::relax (MultiFab&      solL,
               std::cout << "    DN:Norm before smooth " << rnorm << '\n';;
            }
         }
-        for (int i = preSmooth() ; i > 0 ; i--)
-        {
-            Lp.smooth(solL, rhsL, level, bc_mode);
-        }
+        Lp.smooth(solL, rhsL, level, bc_mode, preSmooth());
         Lp.residual(*res[level], rhsL, solL, level, bc_mode);
 
         if ( verbose > 2 )
@@ -559,10 +599,7 @@ MultiGrid::relax (MultiFab&      solL,
            }
         }
 
-        for (int i = postSmooth(); i > 0 ; i--)
-        {
-            Lp.smooth(solL, rhsL, level, bc_mode);
-        }
+        Lp.smooth(solL, rhsL, level, bc_mode, postSmooth());
         if ( verbose > 2 )
         {
            Lp.residual(*res[level], rhsL, solL, level, bc_mode);
@@ -608,6 +645,12 @@ MultiGrid::coarsestSmooth (MultiFab&      solL,
     BL_PROFILE("MultiGrid::coarsestSmooth()");
     prepareForLevel(level);
 
+    if ( bottom_nprocs > 0 && bottom_nprocs < ParallelDescriptor::NProcs() && Lp.canAgglomerate() )
+    {
+        agglomeratedSmooth(solL, rhsL, level, eps_rel, eps_abs, bc_mode, local_usecg, cg_time);
+        return;
+    }
+
     if ( local_usecg == 0 )
     {
         Real error0 = 0;
@@ -678,11 +721,89 @@ MultiGrid::coarsestSmooth (MultiFab&      solL,
                 }
             }
 	}
-        for (int i = 0; i < nu_b; i++)
+        Lp.smooth(solL, rhsL, level, bc_mode, nu_b);
+    }
+}
+
+void
+MultiGrid::agglomeratedSmooth (MultiFab&      solL,
+                               MultiFab&      rhsL,
+                               int            level,
+                               Real           eps_rel,
+                               Real           eps_abs,
+                               LinOp::BC_Mode bc_mode,
+                               int            local_usecg,
+                               Real&          cg_time)
+{
+    BL_PROFILE("MultiGrid::agglomeratedSmooth()");
+
+    if ( bottom_sol == 0 )
+    {
+        //
+        // Lay the coarsest level out over the first nprocs processors and
+        // copy the operator there.  The bottom MultiGrid is made and used
+        // only on the subset, where the distribution map cache lays its
+        // MultiFabs out by bottom_dm.
+        //
+        const BoxArray& ba     = Lp.boxArray(level);
+        const int       nprocs = std::min(bottom_nprocs, ba.size());
+
+        bottom_comm = BottomCommunicator(nprocs);
+
+        bottom_dm.defineSubset(ba, nprocs);
+
+        bottom_sol = new MultiFab(ba, 1, 1, bottom_dm, Fab_allocate);
+        bottom_rhs = new MultiFab(ba, 1, 1, bottom_dm, Fab_allocate);
+
+        bottom_op = Lp.agglomerate(level, bottom_dm, bottom_comm);
+
+        if ( bottom_op != 0 )
         {
-            Lp.smooth(solL, rhsL, level, bc_mode);
+            DistributionMapping::StartSubset(bottom_comm, bottom_dm);
+
+            bottom_mg = new MultiGrid(*bottom_op);
+
+            bottom_mg->numlevels             = 1;
+            bottom_mg->bottom_nprocs         = 0;
+            bottom_mg->verbose               = verbose;
+            bottom_mg->nu_f                  = nu_f;
+            bottom_mg->nu_b                  = nu_b;
+            bottom_mg->rtol_b                = rtol_b;
+            bottom_mg->atol_b                = atol_b;
+            bottom_mg->maxiter_b             = maxiter_b;
+            bottom_mg->smooth_on_cg_unstable = smooth_on_cg_unstable;
+
+            bottom_mg->prepareForLevel(0);
+
+            DistributionMapping::EndSubset();
         }
+
+        if ( ParallelDescriptor::IOProcessor() && verbose > 1 )
+            std::cout << "   MultiGrid: bottom solve on " << nprocs
+                      << " of " << ParallelDescriptor::NProcs() << " processors\n";
     }
+
+    bottom_sol->copy(solL);
+    bottom_rhs->copy(rhsL);
+
+    if ( bottom_mg != 0 )
+    {
+        DistributionMapping::StartSubset(bottom_comm, bottom_dm);
+
+        MultiFab& sol = *bottom_mg->cor[0];
+        MultiFab& rhs = *bottom_mg->rhs[0];
+
+        MultiFab::Copy(sol, *bottom_sol, 0, 0, 1, 0);
+        MultiFab::Copy(rhs, *bottom_rhs, 0, 0, 1, 0);
+
+        bottom_mg->coarsestSmooth(sol, rhs, 0, eps_rel, eps_abs, bc_mode, local_usecg, cg_time);
+
+        MultiFab::Copy(*bottom_sol, sol, 0, 0, 1, 0);
+
+        DistributionMapping::EndSubset();
+    }
+
+    solL.copy(*bottom_sol);
 }
 
 void
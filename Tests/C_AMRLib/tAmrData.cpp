@@ -0,0 +1,361 @@
+//
+// Check AmrData's FillVar() and MinMax() on a two-level plotfile we
+// write ourselves, against the values we wrote.  They have to come out
+// the same with no limit on the grid cache, with a budget smaller than
+// a grid, so every grid is dropped after each call and read again, and
+// with room for a few grids, and on one thread and on several.
+//
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include <Utility.H>
+#include <ParallelDescriptor.H>
+#include <MultiFab.H>
+#include <VisMF.H>
+
+#include <AmrData.H>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static const std::string PlotFile = "tAmrData_plt";
+
+static const int NComp = 2;
+
+static const char* VarNames[NComp] = { "density", "temp" };
+//
+// The value we write at cell iv of level lev.  A slope plus some noise,
+// so grids have ranges that overlap but aren't the same, and the VisMF
+// min and max settle MinMax() for some grids but not others.
+//
+static
+Real
+value (const IntVect& iv,
+       int            lev,
+       int            comp)
+{
+    long h = 0, slope = 0;
+    for (int d = 0; d < BL_SPACEDIM; d++)
+    {
+        h      = 31*h + iv[d];
+        slope += (d % 2 ? -3 : 5)*iv[d];
+    }
+    return 1000*lev + slope + (h*37 + 11) % 23 + 0.5*comp;
+}
+
+static
+BoxArray
+levelGrids (int lev)
+{
+    BoxList bl;
+
+    if (lev == 0)
+    {
+        bl.push_back(Box(IntVect::TheZeroVector(), 31*IntVect::TheUnitVector()));
+    }
+    else
+    {
+        bl.push_back(Box(IntVect(D_DECL(16,8,8)), IntVect(D_DECL(47,31,31))));
+        bl.push_back(Box(IntVect(D_DECL(4,40,4)), IntVect(D_DECL(19,59,19))));
+    }
+
+    BoxArray ba(bl);
+    ba.maxSize(8);
+    return ba;
+}
+
+static
+void
+writePlotFile ()
+{
+    const Box crse(IntVect::TheZeroVector(), 31*IntVect::TheUnitVector());
+
+    if (ParallelDescriptor::IOProcessor())
+        BoxLib::UtilCreateCleanDirectory(PlotFile, false);
+    ParallelDescriptor::Barrier();
+
+    for (int lev = 0; lev <= 1; lev++)
+    {
+        const std::string dir = PlotFile + "/Level_" + BoxLib::Concatenate("", lev, 1);
+
+        if (ParallelDescriptor::IOProcessor())
+            BoxLib::UtilCreateDirectory(dir, 0755);
+        ParallelDescriptor::Barrier();
+
+        MultiFab mf(levelGrids(lev), NComp, 0);
+
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+                for (int comp = 0; comp < NComp; comp++)
+                    mf[mfi](iv,comp) = value(iv, lev, comp);
+        }
+
+        VisMF::Write(mf, dir + "/Cell");
+    }
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        std::ofstream os((PlotFile + "/Header").c_str());
+
+        os << "HyperCLaw-V1.1\n" << NComp << '\n';
+        for (int comp = 0; comp < NComp; comp++)
+            os << VarNames[comp] << '\n';
+        os << BL_SPACEDIM << '\n' << 0 << '\n' << 1 << '\n';
+        for (int d = 0; d < BL_SPACEDIM; d++) os << 0 << ' ';
+        os << '\n';
+        for (int d = 0; d < BL_SPACEDIM; d++) os << 1 << ' ';
+        os << '\n' << 2 << '\n';
+        os << crse << ' ' << BoxLib::refine(crse,2) << '\n';
+        os << "0 0\n";
+        for (int lev = 0; lev <= 1; lev++)
+        {
+            for (int d = 0; d < BL_SPACEDIM; d++) os << 1.0/(32 << lev) << ' ';
+            os << '\n';
+        }
+        os << 0 << '\n' << 0 << '\n';
+
+        for (int lev = 0; lev <= 1; lev++)
+        {
+            const BoxArray ba = levelGrids(lev);
+
+            os << lev << ' ' << ba.size() << ' ' << 0 << '\n' << 0 << '\n';
+            for (int i = 0; i < ba.size(); i++)
+            {
+                for (int d = 0; d < BL_SPACEDIM; d++)
+                    os << ba[i].smallEnd(d)/Real(32 << lev) << ' '
+                       << (ba[i].bigEnd(d)+1)/Real(32 << lev) << '\n';
+            }
+            os << "Level_" << lev << "/Cell\n";
+        }
+    }
+    ParallelDescriptor::Barrier();
+}
+//
+// What FillVar() should give at cell iv of level 1: level 1 where it
+// has a grid, piecewise constant from level 0 where it hasn't.
+//
+static
+Real
+filled (const IntVect& iv,
+        int            comp)
+{
+    if (levelGrids(1).contains(iv))
+        return value(iv, 1, comp);
+    return value(BoxLib::coarsen(iv,2), 0, comp);
+}
+
+static
+bool
+bruteMinMax (const Box& onBox,
+             int        lev,
+             int        comp,
+             Real&      mn,
+             Real&      mx)
+{
+    const BoxArray ba = levelGrids(lev);
+
+    mn =  std::numeric_limits<Real>::max();
+    mx = -std::numeric_limits<Real>::max();
+
+    bool valid = false;
+
+    for (int i = 0; i < ba.size(); i++)
+    {
+        const Box isect = ba[i] & onBox;
+
+        if (!isect.ok()) continue;
+
+        valid = true;
+
+        for (IntVect iv = isect.smallEnd(); iv <= isect.bigEnd(); isect.next(iv))
+        {
+            mn = std::min(mn, value(iv, lev, comp));
+            mx = std::max(mx, value(iv, lev, comp));
+        }
+    }
+
+    return valid;
+}
+//
+// Everything once over with the given budget and number of threads,
+// returning how many answers were wrong.
+//
+static
+long
+checkAmrData (long budget,
+              int  nthreads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+    AmrData::SetFabCacheBudget(budget);
+
+    AmrData amrData;
+
+    if (!amrData.ReadData(PlotFile, Amrvis::NEWPLT))
+        BoxLib::Abort("tAmrData: can't read the plotfile");
+
+    long nbad = 0, worstBytes = 0;
+
+    const Box fine = BoxLib::refine(Box(IntVect::TheZeroVector(), 31*IntVect::TheUnitVector()), 2);
+    //
+    // Each variable on the whole of level 1, twice, as the second time
+    // round the grids come from the cache, or not, depending on the budget.
+    //
+    BoxArray dest(fine);
+    dest.maxSize(16);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int comp = 0; comp < NComp; comp++)
+        {
+            MultiFab mf(dest, 1, 0);
+            mf.setVal(-1);
+
+            amrData.FillVar(mf, 1, VarNames[comp]);
+
+            worstBytes = std::max(worstBytes, amrData.FabCacheBytes());
+
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+            {
+                const Box& bx = mfi.validbox();
+
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+                    if (mf[mfi](iv,0) != filled(iv, comp))
+                        nbad++;
+            }
+        }
+    }
+    //
+    // Odd boxes, some not lined up with the grids, into FABs on one processor.
+    //
+    Array<Box> boxes;
+    boxes.push_back(Box(IntVect(D_DECL(3,5,7)), IntVect(D_DECL(40,21,33))));
+    boxes.push_back(Box(IntVect(D_DECL(0,38,0)), IntVect(D_DECL(25,63,25))));
+    boxes.push_back(Box(IntVect(D_DECL(50,50,50)), IntVect(D_DECL(63,63,63))));
+
+    const int procWithFabs = ParallelDescriptor::NProcs() - 1;
+
+    for (int comp = NComp-1; comp >= 0; comp--)
+    {
+        Array<FArrayBox*> fabs(boxes.size(), 0);
+
+        if (ParallelDescriptor::MyProc() == procWithFabs)
+            for (int i = 0; i < boxes.size(); i++)
+                fabs[i] = new FArrayBox(boxes[i], 1);
+
+        amrData.FillVar(fabs, boxes, 1, VarNames[comp], procWithFabs);
+
+        worstBytes = std::max(worstBytes, amrData.FabCacheBytes());
+
+        for (int i = 0; i < boxes.size(); i++)
+        {
+            if (fabs[i] == 0) continue;
+
+            const Box& bx = boxes[i];
+
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+                if ((*fabs[i])(iv,0) != filled(iv, comp))
+                    nbad++;
+
+            delete fabs[i];
+        }
+    }
+    //
+    // MinMax() on boxes covering whole grids, parts of grids, both, and none.
+    //
+    for (int lev = 0; lev <= 1; lev++)
+    {
+        const Box domain = BoxLib::refine(Box(IntVect::TheZeroVector(), 31*IntVect::TheUnitVector()), 1 << lev);
+
+        Array<Box> onBoxes;
+        onBoxes.push_back(domain);
+        onBoxes.push_back(Box(IntVect(D_DECL(2,3,4)), IntVect(D_DECL(13,29,17))));
+        onBoxes.push_back(Box(IntVect(D_DECL(8,8,8)), IntVect(D_DECL(23,15,15))));
+        onBoxes.push_back(Box(IntVect(D_DECL(5,5,5)), IntVect(D_DECL(26,20,26))));
+        onBoxes.push_back(Box(IntVect(D_DECL(14,6,7)), IntVect(D_DECL(41,33,25))));
+        onBoxes.push_back(Box(IntVect(D_DECL(17,9,10)), IntVect(D_DECL(18,30,11))));
+        onBoxes.push_back(Box(IntVect(D_DECL(1,1,1)), IntVect(D_DECL(3,3,3))));
+
+        for (int b = 0; b < onBoxes.size(); b++)
+        {
+            for (int comp = 0; comp < NComp; comp++)
+            {
+                Real mn, mx, emn, emx;
+
+                bool valid = amrData.MinMax(onBoxes[b], VarNames[comp], lev, mn, mx);
+                //
+                // The min and max are over all processors, but whether
+                // onBox hit any grids is only for the ones we have.
+                //
+                ParallelDescriptor::ReduceBoolOr(valid);
+
+                const bool evalid = bruteMinMax(onBoxes[b], lev, comp, emn, emx);
+
+                worstBytes = std::max(worstBytes, amrData.FabCacheBytes());
+
+                if (valid != evalid || (evalid && (mn != emn || mx != emx)))
+                    nbad++;
+            }
+        }
+    }
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+    ParallelDescriptor::ReduceLongMax(worstBytes);
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "budget " << budget << " bytes, " << nthreads << " thread(s): "
+                  << nbad << " wrong values, at most " << worstBytes
+                  << " bytes of grids cached after a call" << std::endl;
+    //
+    // After each call the cache is back under the budget.
+    //
+    if (budget > 0 && worstBytes > budget)
+        nbad++;
+
+    return nbad;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    writePlotFile();
+
+#ifdef _OPENMP
+    const int maxthreads = std::max(4, omp_get_max_threads());
+#else
+    const int maxthreads = 1;
+#endif
+    //
+    // A grid is 8^D cells of one component.
+    //
+    long budget = sizeof(Real);
+    for (int d = 0; d < BL_SPACEDIM; d++)
+        budget *= 8;
+
+    long nbad = 0;
+
+    for (int nthreads = 1; nthreads <= maxthreads; nthreads += maxthreads-1)
+    {
+        nbad += checkAmrData(0, nthreads);
+        nbad += checkAmrData(budget/2, nthreads);
+        nbad += checkAmrData(3*budget, nthreads);
+
+        if (maxthreads == 1) break;
+    }
+
+    if (nbad > 0)
+        BoxLib::Abort("tAmrData: FillVar() or MinMax() got the plotfile wrong");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tAmrData: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,133 @@
+//
+// Check that ParticleContainer::AssignDensitySingleLevel() gives bitwise
+// the same density on one thread as on several, for the mass alone and
+// for mass and momentum, and that the deposit conserves mass.  Build
+// with USE_OMP=TRUE; without OpenMP both runs are on one thread.
+//
+#include <iostream>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <ParallelDescriptor.H>
+#include <Particles.H>
+
+#include "TestLevel.H"
+
+static
+void
+setThreads (int nthreads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+}
+
+//
+// The largest |value| over the whole of each FAB, ghost cells included.
+//
+static
+Real
+maxAbs (const MultiFab& mf)
+{
+    Real r = 0;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        r = std::max(r, mf[mfi].norm(0, 0, mf.nComp()));
+    ParallelDescriptor::ReduceRealMax(r);
+    return r;
+}
+
+static
+Real
+validSum (const MultiFab& mf,
+          int             comp)
+{
+    Real r = 0;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        r += mf[mfi].sum(mfi.validbox(), comp);
+    ParallelDescriptor::ReduceRealSum(r);
+    return r;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    setTestDefaults();
+
+    int ncount = 20000; int nthreads = 4;
+    {
+        ParmParse pp;
+        pp.query("ncount", ncount);
+        pp.query("nthreads", nthreads);
+    }
+
+    int nfail = 0;
+    {
+        Amr amr;
+
+        amr.init(0, 1);
+
+        ParticleContainer<BL_SPACEDIM+1> pc(&amr);
+        pc.SetVerbose(0);
+        pc.InitRandom(ncount, 451, 1.0);
+        //
+        // Give the particles velocities so the momentum deposit isn't zero.
+        //
+        MultiFab grav(amr.boxArray(0), BL_SPACEDIM, 2);
+        for (int d = 0; d < BL_SPACEDIM; d++)
+            grav.setVal(0.1*(d+1), d, 1, 2);
+        pc.moveKickDrift(grav, 0, 0.01);
+        pc.Redistribute();
+
+        const Real* dx   = amr.Geom(0).CellSize();
+        Real        dvol = 1;
+        for (int d = 0; d < BL_SPACEDIM; d++)
+            dvol *= dx[d];
+
+        const int ncomps[] = { 1, BL_SPACEDIM+1 };
+
+        for (int c = 0; c < 2; c++)
+        {
+            const int ncomp = ncomps[c];
+
+            MultiFab one(amr.boxArray(0), ncomp, 1), many(amr.boxArray(0), ncomp, 1);
+
+            setThreads(1);
+            pc.AssignDensitySingleLevel(one, 0, ncomp);
+
+            setThreads(nthreads);
+            pc.AssignDensitySingleLevel(many, 0, ncomp);
+
+            MultiFab::Subtract(many, one, 0, 0, ncomp, 1);
+
+            const Real diff = maxAbs(many);
+            //
+            // The domain is periodic, so all the mass lands in the valid cells.
+            //
+            const Real mass = validSum(one, 0) * dvol;
+            const Real want = pc.sumParticleMass(0);
+
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << "ncomp = " << ncomp
+                          << ": 1 vs " << nthreads << " threads max |difference| = " << diff
+                          << ", deposited mass = " << mass << " of " << want << std::endl;
+
+            if (diff != 0 || std::abs(mass - want) > 1.e-10 * want)
+                nfail++;
+        }
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tAssignDensity: AssignDensitySingleLevel() depends on the number of threads");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tAssignDensity: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,140 @@
+//
+// Check that FillCoarsePatch() and FillPatchIterator give bitwise the
+// same results with the FillPatch plans cached (amr.fillpatch_plans > 0)
+// as without, both when a plan is first built and when it's reused.
+// Level 1 covers part of the periodic domain, so its ghost cells come
+// from level 1 and from level 0, directly and through periodic images.
+//
+#include <iostream>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <ParallelDescriptor.H>
+
+#include "TestLevel.H"
+
+//
+// Values that depend only on the cell and the seed.
+//
+static
+void
+fillLevel (MultiFab& mf,
+           int       seed)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        FArrayBox& fab = mf[mfi];
+        const Box& bx  = mfi.validbox();
+
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+        {
+            Real v = seed;
+            for (int d = 0; d < BL_SPACEDIM; d++)
+                v = 100*v + iv[d];
+            fab(iv,0) = v;
+        }
+    }
+}
+
+static
+Real
+maxDiff (const MultiFab& a,
+         const MultiFab& b)
+{
+    MultiFab d(a.boxArray(), a.nComp(), a.nGrow(), a.DistributionMap());
+
+    MultiFab::Copy(d, a, 0, 0, a.nComp(), a.nGrow());
+    MultiFab::Subtract(d, b, 0, 0, a.nComp(), a.nGrow());
+
+    Real diff = 0;
+    for (MFIter mfi(d); mfi.isValid(); ++mfi)
+        diff = std::max(diff, d[mfi].norm(0, 0, d.nComp()));
+    ParallelDescriptor::ReduceRealMax(diff);
+
+    return diff;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    setTestDefaults(1);
+
+    const int nghost = 2;
+
+    int nfail = 0;
+    {
+        Amr amr;
+
+        amr.init(0, 1);
+
+        if (amr.finestLevel() < 1)
+            BoxLib::Abort("tFillPatch: expected a refined level");
+
+        AmrLevel& crse = amr.getLevel(0);
+        AmrLevel& fine = amr.getLevel(1);
+
+        fillLevel(crse.get_new_data(0), 1);
+        fillLevel(fine.get_new_data(0), 2);
+
+        const Real      time = amr.cumTime();
+        const BoxArray& ba   = fine.boxArray();
+        //
+        // [plans on/off][first/second call]
+        //
+        MultiFab cfill[2][2], pfill[2][2];
+
+        for (int c = 0; c < 2; c++)
+        {
+            AmrLevel::SetFillPatchPlans(c == 0 ? 8 : 0);
+
+            for (int call = 0; call < 2; call++)
+            {
+                MultiFab& cf = cfill[c][call];
+                MultiFab& pf = pfill[c][call];
+
+                cf.define(ba, 1, 0, Fab_allocate);
+                cf.setVal(-1);
+                fine.FillCoarsePatch(cf, 0, time, 0, 0, 1);
+
+                pf.define(ba, 1, nghost, Fab_allocate);
+                pf.setVal(-1);
+                for (FillPatchIterator fpi(fine, fine.get_new_data(0), nghost, time, 0, 0, 1);
+                     fpi.isValid();
+                     ++fpi)
+                {
+                    pf[fpi].copy(fpi());
+                }
+            }
+        }
+
+        for (int call = 0; call < 2; call++)
+        {
+            const Real cdiff = maxDiff(cfill[0][call], cfill[1][call]);
+            const Real pdiff = maxDiff(pfill[0][call], pfill[1][call]);
+            //
+            // Every value we fill is positive, so -1 is a cell left unfilled.
+            //
+            const Real cmin  = std::min(cfill[0][call].min(0), cfill[1][call].min(0));
+            const Real pmin  = std::min(pfill[0][call].min(0, nghost), pfill[1][call].min(0, nghost));
+
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << "call " << call
+                          << ": FillCoarsePatch() min = " << cmin << ", max |difference| = " << cdiff
+                          << "; FillPatchIterator min = " << pmin << ", max |difference| = " << pdiff
+                          << std::endl;
+
+            if (cdiff != 0 || pdiff != 0 || cmin < 0 || pmin < 0)
+                nfail++;
+        }
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tFillPatch: FillPatch with cached plans differs from without");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tFillPatch: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
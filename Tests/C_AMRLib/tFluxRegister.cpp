@@ -0,0 +1,162 @@
+//
+// Check that FluxRegister::Reflux() with the plan it cached on an
+// earlier call gives the same results as a FluxRegister working out its
+// plan from scratch, including after the plan has to be rebuilt for a
+// different coarse BoxArray.  The coarse domain is periodic and the fine
+// grids touch both of its ends, so registers are also found through
+// their periodic images.
+//
+#include <iostream>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <Geometry.H>
+#include <MultiFab.H>
+#include <FluxRegister.H>
+#include <ParallelDescriptor.H>
+
+//
+// Register values that depend only on the face, cell, component and seed,
+// so two FluxRegisters over the same grids get the same values.
+//
+static
+void
+fillRegisters (FluxRegister& fr,
+               int           seed)
+{
+    for (OrientationIter fi; fi; ++fi)
+    {
+        const Orientation face = fi();
+        FabSet&           fs   = fr[face];
+
+        for (FabSetIter fsi(fs); fsi.isValid(); ++fsi)
+        {
+            FArrayBox& fab = fs[fsi];
+            const Box& bx  = fab.box();
+
+            for (int n = 0; n < fab.nComp(); n++)
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+                {
+                    long k = seed + 7*int(face) + 101*n;
+                    for (int d = 0; d < BL_SPACEDIM; d++)
+                        k = 31*k + iv[d];
+                    fab(iv,n) = std::sin(Real(k));
+                }
+        }
+    }
+}
+
+static
+void
+reflux (FluxRegister&   fr,
+        MultiFab&       mf,
+        const Geometry& geom)
+{
+    MultiFab volume(mf.boxArray(), 1, 0, mf.DistributionMap());
+
+    volume.setVal(0.5);
+
+    mf.setVal(0);
+
+    fr.Reflux(mf, volume, 1.0, 0, 0, mf.nComp(), geom);
+}
+
+static
+Real
+maxDiff (const MultiFab& a,
+         const MultiFab& b)
+{
+    MultiFab d(a.boxArray(), a.nComp(), 0, a.DistributionMap());
+
+    MultiFab::Copy(d, a, 0, 0, a.nComp(), 0);
+    MultiFab::Subtract(d, b, 0, 0, a.nComp(), 0);
+
+    Real diff = 0;
+    for (int n = 0; n < d.nComp(); n++)
+        diff = std::max(diff, d.norm0(n));
+
+    return diff;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    ParmParse pp;
+
+    int n_cell = 32; pp.query("n_cell", n_cell);
+    int max_grid_size = 8; pp.query("max_grid_size", max_grid_size);
+
+    const int     ncomp = 2;
+    const IntVect ratio = 2*IntVect::TheUnitVector();
+
+    Box domain(IntVect::TheZeroVector(), (n_cell-1)*IntVect::TheUnitVector());
+
+    RealBox rb;
+    int     is_per[BL_SPACEDIM];
+    for (int d = 0; d < BL_SPACEDIM; d++)
+    {
+        rb.setLo(d, 0.0);
+        rb.setHi(d, 1.0);
+        is_per[d] = 1;
+    }
+
+    Geometry geom(domain, &rb, 0, is_per);
+
+    BoxArray cba(domain), cba2(domain);
+    cba.maxSize(max_grid_size);
+    cba2.maxSize(2*max_grid_size);
+    //
+    // Fine grids at both the low and the high end of the domain.
+    //
+    BoxList fbl;
+    fbl.push_back(BoxLib::refine(Box(IntVect::TheZeroVector(),
+                                     (n_cell/4)*IntVect::TheUnitVector()), ratio));
+    fbl.push_back(BoxLib::refine(Box((n_cell-n_cell/4)*IntVect::TheUnitVector(),
+                                     (n_cell-1)*IntVect::TheUnitVector()), ratio));
+    BoxArray fba(fbl);
+    fba.maxSize(2*max_grid_size);
+
+    FluxRegister fr(fba, ratio, 1, ncomp);
+
+    int nfail = 0;
+    //
+    // Reflux onto cba twice, then onto cba2 and back onto cba, with new
+    // register values each time, comparing with a fresh FluxRegister.
+    //
+    const BoxArray* targets[] = { &cba, &cba, &cba2, &cba };
+
+    for (int call = 0; call < 4; call++)
+    {
+        const BoxArray& ba = *targets[call];
+
+        MultiFab cached(ba, ncomp, 0), fresh(ba, ncomp, 0);
+
+        fillRegisters(fr, call);
+        reflux(fr, cached, geom);
+
+        FluxRegister fr_fresh(fba, ratio, 1, ncomp);
+        fillRegisters(fr_fresh, call);
+        reflux(fr_fresh, fresh, geom);
+
+        const Real diff = maxDiff(cached, fresh);
+        const Real size = fresh.norm0(0);
+
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << "Reflux() call " << call
+                      << ": max |result| = " << size
+                      << ", max |difference| = " << diff << std::endl;
+
+        if (diff != 0 || size == 0)
+            nfail++;
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tFluxRegister: Reflux() with a cached plan differs from a fresh one");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tFluxRegister: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,361 @@
+//
+// Check that Redistribute() leaves the same particles on each level and
+// grid, with the same data, whether it exchanges them sparsely
+// (particles.sparse_redistribute = 1) or with every CPU sending every
+// other CPU a count (= 0).  The particles are moved a little, which the
+// neighbor exchange handles, and then a long way, which needs the
+// general sparse exchange.  Run it on several CPUs, as with mpirun -np
+// 2, 3 and 4; on one there's nothing to exchange, and it says so.
+//
+// Before that, on any number of CPUs, it checks that the CPUs
+// ParticleBase::NeighborProcs() gives are symmetric for made-up
+// layouts of the grids over more CPUs than there are, including ones
+// in which CPUs only neighbor across levels or periodic boundaries.
+//
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <set>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <ParallelDescriptor.H>
+#include <Particles.H>
+
+#include "TestLevel.H"
+
+typedef ParticleContainer<BL_SPACEDIM+1> PC;
+
+static
+bool
+byCpuAndId (const PC::ParticleType& a,
+            const PC::ParticleType& b)
+{
+    return a.m_cpu < b.m_cpu || (a.m_cpu == b.m_cpu && a.m_id < b.m_id);
+}
+
+static
+bool
+same (const PC::ParticleType& p,
+      const PC::ParticleType& q)
+{
+    bool r = p.m_id == q.m_id && p.m_cpu == q.m_cpu &&
+             p.m_lev == q.m_lev && p.m_grid == q.m_grid && p.m_cell == q.m_cell;
+    for (int d = 0; d < BL_SPACEDIM; d++)
+        r = r && p.m_pos[d] == q.m_pos[d];
+    for (int j = 0; j < BL_SPACEDIM+1; j++)
+        r = r && p.m_data[j] == q.m_data[j];
+    return r;
+}
+//
+// The number of our particles that aren't in the other container, in
+// the same grid, with the same data.
+//
+static
+long
+countDifferent (const PC& a,
+                const PC& b,
+                int       finest_level)
+{
+    long nbad = 0;
+
+    for (int lev = 0; lev <= finest_level; lev++)
+    {
+        const PC::PMap& pa = a.GetParticles(lev);
+        const PC::PMap& pb = b.GetParticles(lev);
+
+        for (PC::PMap::const_iterator it = pa.begin(), End = pa.end(); it != End; ++it)
+        {
+            std::vector<PC::ParticleType> va(it->second.begin(), it->second.end()), vb;
+
+            PC::PMap::const_iterator jt = pb.find(it->first);
+
+            if (jt != pb.end())
+                vb.assign(jt->second.begin(), jt->second.end());
+
+            std::sort(va.begin(), va.end(), byCpuAndId);
+            std::sort(vb.begin(), vb.end(), byCpuAndId);
+
+            if (va.size() != vb.size())
+            {
+                nbad += std::max(va.size(), vb.size());
+                continue;
+            }
+
+            for (int i = 0, M = va.size(); i < M; i++)
+                if (!same(va[i], vb[i]))
+                    nbad++;
+        }
+        //
+        // Grids that only b has particles in.
+        //
+        for (PC::PMap::const_iterator jt = pb.begin(), End = pb.end(); jt != End; ++jt)
+            if (pa.find(jt->first) == pa.end())
+                nbad += jt->second.size();
+    }
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+
+    return nbad;
+}
+
+//
+// The number of pairs of CPUs in which the first has the second as a
+// neighbor but not the other way round, laying particle grid i of
+// level lev out on CPU pmaps[lev][i] of nprocs.  The pairs that have to
+// be neighbors and aren't count too.
+//
+static
+int
+checkNeighbors (Amr&                                 amr,
+                const Array< Array<int> >&           pmaps,
+                int                                  nprocs,
+                const std::set<std::pair<int,int> >& must)
+{
+    std::vector< std::set<int> > nbrs(nprocs);
+
+    for (int p = 0; p < nprocs; p++)
+    {
+        const Array<int> n = ParticleBase::NeighborProcs(&amr, amr.finestLevel(), pmaps, p);
+
+        nbrs[p].insert(n.begin(), n.end());
+
+        if (nbrs[p].count(p))
+            BoxLib::Abort("tRedistribute: a CPU is its own neighbor");
+    }
+
+    int nbad = 0;
+
+    for (int p = 0; p < nprocs; p++)
+        for (std::set<int>::const_iterator it = nbrs[p].begin(); it != nbrs[p].end(); ++it)
+            if (nbrs[*it].count(p) == 0)
+                nbad++;
+
+    for (std::set<std::pair<int,int> >::const_iterator it = must.begin(); it != must.end(); ++it)
+        if (nbrs[it->first].count(it->second) == 0)
+            nbad++;
+
+    return nbad;
+}
+
+static
+int
+checkNeighbors (Amr& amr)
+{
+    const int finest_level = amr.finestLevel();
+
+    Array< Array<int> > pmaps(finest_level+1);
+
+    int nbad = 0;
+    //
+    // The level 0 grids on the low x face on CPU 0, those on the high x
+    // face on CPU 1, the rest on CPU 2, and the finer grids, which are
+    // on the low x face, on CPU 3.  So 0 and 1 only neighbor across the
+    // periodic boundary, 0 and 3 across levels, and 1 and 3 both.
+    //
+    const Box& domain = amr.Geom(0).Domain();
+
+    for (int lev = 0; lev <= finest_level; lev++)
+    {
+        const BoxArray& ba = amr.ParticleBoxArray(lev);
+
+        pmaps[lev].resize(ba.size());
+
+        for (int i = 0; i < ba.size(); i++)
+        {
+            if (lev > 0)
+                pmaps[lev][i] = 3;
+            else if (ba[i].smallEnd(0) == domain.smallEnd(0))
+                pmaps[lev][i] = 0;
+            else if (ba[i].bigEnd(0) == domain.bigEnd(0))
+                pmaps[lev][i] = 1;
+            else
+                pmaps[lev][i] = 2;
+        }
+    }
+
+    std::set<std::pair<int,int> > must;
+    must.insert(std::make_pair(0,1));
+    if (finest_level > 0)
+    {
+        must.insert(std::make_pair(0,3));
+        must.insert(std::make_pair(1,3));
+    }
+
+    nbad += checkNeighbors(amr, pmaps, 4, must);
+    //
+    // A level 1 grid on CPU 1 and a level 0 grid on CPU 0 that are within
+    // a cell of each other, periodic images included, without
+    // overlapping, and the rest on CPU 2.
+    //
+    if (finest_level > 0)
+    {
+        const BoxArray& crse  = amr.ParticleBoxArray(0);
+        const BoxArray& fine  = amr.ParticleBoxArray(1);
+        const IntVect   ratio = amr.refRatio(0);
+        const Geometry& gm    = amr.Geom(1);
+
+        int ic = -1, jf = -1;
+
+        Array<IntVect> pshifts;
+
+        for (int i = 0; i < crse.size() && jf < 0; i++)
+        {
+            const Box bx = BoxLib::refine(crse[i], ratio);
+
+            gm.periodicShift(gm.Domain(), BoxLib::grow(bx, ratio), pshifts);
+            pshifts.push_back(IntVect::TheZeroVector());
+
+            for (int j = 0; j < fine.size() && jf < 0; j++)
+            {
+                bool near = false, over = false;
+
+                for (int k = 0; k < pshifts.size(); k++)
+                {
+                    near = near || fine[j].intersects(BoxLib::grow(bx, ratio) + pshifts[k]);
+                    over = over || fine[j].intersects(bx + pshifts[k]);
+                }
+
+                if (near && !over)
+                {
+                    ic = i;
+                    jf = j;
+                }
+            }
+        }
+
+        if (jf < 0)
+            BoxLib::Abort("tRedistribute: no level 0 grid is just next to a level 1 grid");
+
+        for (int lev = 0; lev <= finest_level; lev++)
+            for (int i = 0; i < pmaps[lev].size(); i++)
+                pmaps[lev][i] = 2;
+
+        pmaps[0][ic] = 0;
+        pmaps[1][jf] = 1;
+
+        must.clear();
+        must.insert(std::make_pair(0,1));
+        must.insert(std::make_pair(1,0));
+
+        nbad += checkNeighbors(amr, pmaps, 3, must);
+    }
+    //
+    // Random layouts.
+    //
+    for (int nprocs = 2; nprocs <= 9; nprocs++)
+    {
+        for (int lev = 0; lev <= finest_level; lev++)
+            for (int i = 0; i < pmaps[lev].size(); i++)
+                pmaps[lev][i] = BoxLib::Random_int(nprocs);
+
+        nbad += checkNeighbors(amr, pmaps, nprocs, std::set<std::pair<int,int> >());
+    }
+
+    return nbad;
+}
+
+static
+void
+drift (PC&  pc,
+       Amr& amr,
+       Real dt)
+{
+    for (int lev = 0; lev <= amr.finestLevel(); lev++)
+    {
+        MultiFab grav(amr.boxArray(lev), BL_SPACEDIM, 2);
+        for (int d = 0; d < BL_SPACEDIM; d++)
+            grav.setVal(0.1*(d+1), d, 1, 2);
+        pc.moveKickDrift(grav, lev, dt);
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+    {
+        //
+        // Small grids, so there are more of them to spread over the CPUs,
+        // and no subcycling, so moveKickDrift() lets particles on the fine
+        // level go anywhere.
+        //
+        ParmParse ppa("amr");
+        addDefault(ppa, "max_grid_size", 8);
+        if (!ppa.contains("subcycling_mode"))
+            ppa.add("subcycling_mode", std::string("None"));
+    }
+    setTestDefaults(1);
+
+    int ncount = 20000; { ParmParse pp; pp.query("ncount", ncount); }
+
+    int nfail = 0;
+    {
+        Amr amr;
+
+        amr.init(0, 1);
+
+        const int nasym = checkNeighbors(amr);
+
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << nasym << " CPU pairs neighbor one way only" << std::endl;
+
+        if (nasym > 0)
+            nfail++;
+
+        if (ParallelDescriptor::NProcs() == 1)
+        {
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << "tRedistribute: WARNING: on one CPU there's nothing to exchange;"
+                          << " run it on several to check Redistribute()" << std::endl;
+        }
+        else
+        {
+            PC sparse(&amr);
+            sparse.SetVerbose(0);
+            sparse.InitRandom(ncount, 451, 1.0);
+
+            PC dense(sparse);
+            //
+            // Two short steps, then one long enough to take particles
+            // a third of the way across the domain.
+            //
+            const Real dts[] = { 0.02, 0.02, 2.5 };
+
+            for (int step = 0; step < 3; step++)
+            {
+                drift(sparse, amr, dts[step]);
+                drift(dense,  amr, dts[step]);
+
+                //
+                // Particles cross the periodic boundaries, so they need the
+                // full Where().
+                //
+                ParticleBase::SetSparseRedistribute(true);
+                sparse.Redistribute(false, true);
+
+                ParticleBase::SetSparseRedistribute(false);
+                dense.Redistribute(false, true);
+
+                const long nbad    = countDifferent(sparse, dense, amr.finestLevel());
+                const long nsparse = sparse.TotalNumberOfParticles();
+                const long ndense  = dense.TotalNumberOfParticles();
+
+                if (ParallelDescriptor::IOProcessor())
+                    std::cout << "dt = " << dts[step] << ": " << nsparse << " and " << ndense
+                              << " particles, " << nbad << " differ" << std::endl;
+
+                if (nbad > 0 || nsparse != ncount || ndense != ncount)
+                    nfail++;
+            }
+        }
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tRedistribute: neighbors aren't symmetric, or sparse and all-to-all Redistribute() differ");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tRedistribute: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
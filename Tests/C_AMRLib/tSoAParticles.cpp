@@ -0,0 +1,309 @@
+//
+// Check that an SoAParticleContainer handled through a base pointer
+// does the right thing after moveKickDrift() has left its particles in
+// the SoA layout: the counts have to see them, and Checkpoint() has to
+// write them out.  The checkpoint is read back into a plain
+// ParticleContainer and compared with one that did the same steps on
+// the AoS layout.  Then both move far enough for most particles to
+// change grid, and CPU, and to cross the periodic boundaries, and
+// Redistribute() has to put them where the AoS container does without
+// leaving the SoA layout.  Last, it times a round trip between the
+// layouts against a moveKickDrift().
+//
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <ParallelDescriptor.H>
+#include <SoAParticles.H>
+
+#include "TestLevel.H"
+
+//
+// The particles of one level, grid by grid, in order of the CPU that
+// made them and then of id.
+//
+typedef std::map< int,std::vector< Particle<BL_SPACEDIM+1> > > Sorted;
+
+static
+bool
+byId (const Particle<BL_SPACEDIM+1>& a, const Particle<BL_SPACEDIM+1>& b)
+{
+    return a.m_cpu < b.m_cpu || (a.m_cpu == b.m_cpu && a.m_id < b.m_id);
+}
+
+static
+Sorted
+sortById (const ParticleContainer<BL_SPACEDIM+1>& pc)
+{
+    typedef ParticleContainer<BL_SPACEDIM+1>::PMap PMap;
+
+    Sorted result;
+
+    const PMap& pmap = pc.GetParticles(0);
+
+    for (PMap::const_iterator it = pmap.begin(), End = pmap.end(); it != End; ++it)
+    {
+        std::vector< Particle<BL_SPACEDIM+1> >& v = result[it->first];
+
+        for (int i = 0, M = it->second.size(); i < M; i++)
+            if (it->second[i].m_id > 0)
+                v.push_back(it->second[i]);
+
+        std::sort(v.begin(), v.end(), byId);
+    }
+
+    return result;
+}
+
+//
+// The number of particles in a that aren't bitwise the same in b.
+//
+static
+long
+countDifferent (const Sorted& a,
+                const Sorted& b)
+{
+    long nbad = 0;
+
+    for (Sorted::const_iterator it = a.begin(), End = a.end(); it != End; ++it)
+    {
+        Sorted::const_iterator jt = b.find(it->first);
+
+        if (jt == b.end() || jt->second.size() != it->second.size())
+        {
+            nbad += it->second.size();
+            continue;
+        }
+
+        for (int i = 0, M = it->second.size(); i < M; i++)
+        {
+            const Particle<BL_SPACEDIM+1>& p = it->second[i];
+            const Particle<BL_SPACEDIM+1>& q = jt->second[i];
+
+            bool same = p.m_cpu == q.m_cpu;
+            for (int d = 0; d < BL_SPACEDIM; d++)
+                same = same && p.m_pos[d] == q.m_pos[d];
+            for (int j = 0; j < BL_SPACEDIM+1; j++)
+                same = same && p.m_data[j] == q.m_data[j];
+
+            if (!same) nbad++;
+        }
+    }
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+
+    return nbad;
+}
+//
+// A container written against the original ParticleContainerBase, with
+// only its pure virtuals.  It has to go on compiling.
+//
+struct OldStyleContainer
+    :
+    public ParticleContainerBase
+{
+    virtual void AssignDensity (PArray<MultiFab>& mf, int lev_min = 0, int ncomp = 1, int finest_level = -1) const {}
+    virtual void AssignDensitySingleLevel (MultiFab& mf, int level, int ncomp=1, int particle_lvl_offset = 0) const {}
+    virtual Real sumParticleMass (int level) const { return 0; }
+    virtual void RemoveParticlesAtLevel (int level) {}
+    virtual void Redistribute (bool where_already_called = false,
+                               bool full_where           = false,
+                               int  lev_min              = 0,
+                               int  nGrow                = 0) {}
+    virtual void moveKickDrift (MultiFab& grav_vector, int level, Real timestep,
+                                Real a_old = 1.0, Real a_half = 1.0) {}
+    virtual void moveKick      (MultiFab& grav_vector, int level, Real timestep,
+                                Real a_new = 1.0, Real a_half = 1.0, int start_comp_for_accel = -1) {}
+    virtual void moveKickDrift (PArray<MultiFab>& grav_vector, int level, Real timestep,
+                                Real a_old = 1.0, Real a_half = 1.0) {}
+    virtual void moveKick      (PArray<MultiFab>& grav_vector, int level, Real timestep,
+                                Real a_new = 1.0, Real a_half = 1.0) {}
+};
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    setTestDefaults();
+
+    int ncount = 10000; { ParmParse pp; pp.query("ncount", ncount); }
+
+    const std::string dir = "tSoAParticles_chk";
+    const std::string name = "Tracer";
+
+    int nfail = 0;
+    {
+        Amr amr;
+
+        amr.init(0, 1);
+
+        MultiFab grav(amr.boxArray(0), BL_SPACEDIM, 2);
+        for (int d = 0; d < BL_SPACEDIM; d++)
+            grav.setVal(0.1*(d+1), d, 1, 2);
+
+        const Real dt = 0.01;
+
+        ParticleContainer<BL_SPACEDIM+1> ref(&amr);
+        ref.SetVerbose(0);
+        ref.InitRandom(ncount, 451, 1.0);
+        ref.moveKickDrift(grav, 0, dt);
+
+        SoAParticleContainer<BL_SPACEDIM+1> soa(&amr);
+        soa.SetVerbose(0);
+        soa.InitRandom(ncount, 451, 1.0);
+        soa.ToSoA();
+        soa.moveKickDrift(grav, 0, dt);
+        //
+        // Restart() keeps the particles in the grids they're written
+        // from, so put the few that crossed a grid edge in their new
+        // grids first.
+        //
+        ref.Redistribute(false, true);
+        soa.Redistribute(false, true);
+
+        if (!soa.IsSoA())
+            BoxLib::Abort("tSoAParticles: moveKickDrift() or Redistribute() left the SoA layout");
+
+        ParticleContainerBase* pcb = &soa;
+        ParticleContainer<BL_SPACEDIM+1>* pc = &soa;
+
+        const long ntotal = ref.TotalNumberOfParticles();
+
+        if (pcb->TotalNumberOfParticles() != ntotal || pc->TotalNumberOfParticles() != ntotal ||
+            pc->NumberOfParticlesAtLevel(0) != ntotal)
+        {
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << "particle counts through a base pointer are wrong\n";
+            nfail++;
+        }
+
+        if (ParallelDescriptor::IOProcessor())
+            if (!BoxLib::UtilCreateDirectory(dir, 0755))
+                BoxLib::CreateDirectoryFailed(dir);
+        ParallelDescriptor::Barrier();
+
+        pcb->Checkpoint(dir, name);
+
+        ParticleContainer<BL_SPACEDIM+1> restarted(&amr);
+        restarted.SetVerbose(0);
+        restarted.Restart(dir, name);
+
+        if (restarted.TotalNumberOfParticles() != ntotal)
+        {
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << "Checkpoint() through a base pointer wrote "
+                          << restarted.TotalNumberOfParticles() << " of "
+                          << ntotal << " particles\n";
+            nfail++;
+        }
+        //
+        // moveKickDrift() does the same arithmetic on both layouts.  Each
+        // CPU numbers its particles from its own counter, so the two
+        // containers number them in the same order but from different
+        // starts.
+        //
+        const long nbad = countDifferent(sortById(ref), sortById(restarted));
+
+        if (nbad > 0)
+        {
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << nbad << " particles differ after Checkpoint()/Restart()\n";
+            nfail++;
+        }
+        //
+        // A step long enough to move most particles to another grid.
+        //
+        soa.ToSoA();
+
+        ref.moveKickDrift(grav, 0, 1.0);
+        soa.moveKickDrift(grav, 0, 1.0);
+
+        std::map<int,int> grid_of;
+        {
+            const Sorted before = sortById(ref);
+            for (Sorted::const_iterator it = before.begin(), End = before.end(); it != End; ++it)
+                for (int i = 0, M = it->second.size(); i < M; i++)
+                    grid_of[it->second[i].m_id] = it->first;
+        }
+
+        soa.ToSoA();
+
+        ref.Redistribute(false, true);
+        soa.Redistribute(false, true);
+
+        if (!soa.IsSoA())
+        {
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << "Redistribute() left the SoA layout\n";
+            nfail++;
+        }
+
+        if (soa.TotalNumberOfParticles() != ntotal || ref.TotalNumberOfParticles() != ntotal)
+        {
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << "Redistribute() kept " << soa.TotalNumberOfParticles()
+                          << " of " << ntotal << " particles\n";
+            nfail++;
+        }
+
+        const Sorted after = sortById(ref);
+
+        long nmoved = 0;
+        for (Sorted::const_iterator it = after.begin(), End = after.end(); it != End; ++it)
+            for (int i = 0, M = it->second.size(); i < M; i++)
+                if (grid_of.count(it->second[i].m_id) == 0 || grid_of[it->second[i].m_id] != it->first)
+                    nmoved++;
+        ParallelDescriptor::ReduceLongSum(nmoved);
+
+        const long nbad_redist = countDifferent(after, sortById(soa));
+
+        if (!soa.OK())
+        {
+            if (ParallelDescriptor::IOProcessor())
+                std::cout << "OK() fails after Redistribute()\n";
+            nfail++;
+        }
+
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << nmoved << " of " << ntotal << " particles changed grid or CPU, "
+                      << nbad_redist << " differ after Redistribute()\n";
+
+        if (nmoved == 0 || nbad_redist > 0)
+            nfail++;
+        //
+        // What a round trip between the layouts costs.
+        //
+        soa.ToSoA();
+
+        Real strttime = ParallelDescriptor::second();
+        soa.ToAoS();
+        soa.ToSoA();
+        Real convtime = ParallelDescriptor::second() - strttime;
+
+        strttime = ParallelDescriptor::second();
+        soa.moveKickDrift(grav, 0, 0.0);
+        Real steptime = ParallelDescriptor::second() - strttime;
+
+        ParallelDescriptor::ReduceRealMax(convtime);
+        ParallelDescriptor::ReduceRealMax(steptime);
+
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << "SoA -> AoS -> SoA: " << convtime << " s, moveKickDrift(): "
+                      << steptime << " s for " << ntotal << " particles\n";
+
+        OldStyleContainer old_style;
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tSoAParticles: SoAParticleContainer differs from ParticleContainer");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tSoAParticles: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
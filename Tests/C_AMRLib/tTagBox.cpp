@@ -0,0 +1,111 @@
+//
+// Check that the distributed TagBoxArray::collate(parts,ptags) finds
+// the same tags as the gathering collate(), including buffer tags that
+// coarsen() leaves outside the validbox() of each TagBox.
+//
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <BoxArray.H>
+#include <TagBox.H>
+#include <Utility.H>
+#include <ParallelDescriptor.H>
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    const int N     = 64;
+    const int nbuf  = 2;
+    const int ngrow = 4;
+
+    Box domain(IntVect::TheZeroVector(), (N-1)*IntVect::TheUnitVector());
+
+    BoxArray ba(domain);
+    ba.maxSize(16);
+
+    TagBoxArray tags(ba, ngrow);
+
+    for (MFIter mfi(tags); mfi.isValid(); ++mfi)
+        tags[mfi].setVal(TagBox::CLEAR);
+    //
+    // Tag random cells away from the domain boundary, then buffer them
+    // into the ghost cells the way Amr::grid_places() does.
+    //
+    const Box interior = BoxLib::grow(domain, -(nbuf+ngrow));
+
+    for (MFIter mfi(tags); mfi.isValid(); ++mfi)
+    {
+        TagBox&    tb = tags[mfi];
+        const Box& vb = mfi.validbox();
+
+        for (IntVect iv = vb.smallEnd(); iv <= vb.bigEnd(); vb.next(iv))
+            if (interior.contains(iv) && BoxLib::Random() < 0.02)
+                tb(iv) = TagBox::SET;
+    }
+
+    tags.buffer(nbuf);
+    tags.coarsen(2*IntVect::TheUnitVector());
+
+    const Box cdomain = BoxLib::coarsen(domain, 2);
+    //
+    // The gathering version.
+    //
+    long     len = 0;
+    IntVect* pts = tags.collate(len);
+
+    std::vector<IntVect> serial(pts, pts+len);
+
+    delete [] pts;
+
+    std::sort(serial.begin(), serial.end(), IntVect::Compare());
+    //
+    // The distributed version.  The parts are disjoint, so it matches if
+    // every tag it returns is in the list above and the counts agree.
+    //
+    BoxArray parts(cdomain);
+    parts.maxSize(8);
+
+    std::map< int,std::vector<IntVect> > ptags;
+
+    tags.collate(parts, ptags);
+
+    long nfound = 0, nbad = 0;
+
+    for (std::map< int,std::vector<IntVect> >::const_iterator it = ptags.begin(), End = ptags.end();
+         it != End;
+         ++it)
+    {
+        for (int i = 0, M = it->second.size(); i < M; i++)
+        {
+            const IntVect& iv = it->second[i];
+
+            if (!parts[it->first].contains(iv) ||
+                !std::binary_search(serial.begin(), serial.end(), iv, IntVect::Compare()))
+                nbad++;
+        }
+
+        nfound += it->second.size();
+    }
+
+    ParallelDescriptor::ReduceLongSum(nfound);
+    ParallelDescriptor::ReduceLongSum(nbad);
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "collate(): " << serial.size()
+                  << " tags, collate(parts): " << nfound << " tags" << std::endl;
+
+    if (serial.empty())
+        BoxLib::Abort("tTagBox: no tags to compare");
+
+    if (nbad > 0 || nfound != serial.size())
+        BoxLib::Abort("tTagBox: collate(parts) and collate() found different tags");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tTagBox: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,137 @@
+//
+// Check that the batched ParticleBase::Where() finds the same level,
+// grid and cell as the one-particle Where() for every particle, and
+// misses the same ones.  There are two levels, and besides random
+// positions there are particles exactly on cell faces and domain
+// edges and particles outside the domain.
+//
+#include <iostream>
+#include <vector>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <ParallelDescriptor.H>
+#include <Particles.H>
+
+#include "TestLevel.H"
+
+static
+bool
+same (const ParticleBase& a,
+      const ParticleBase& b)
+{
+    return a.m_lev == b.m_lev && a.m_grid == b.m_grid && a.m_cell == b.m_cell;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    setTestDefaults(1);
+
+    int ncount = 20000; { ParmParse pp; pp.query("ncount", ncount); }
+
+    int nfail = 0;
+    {
+        Amr amr;
+
+        amr.init(0, 1);
+
+        if (amr.finestLevel() < 1)
+            BoxLib::Abort("tWhere: expected a refined level");
+
+        const Real* plo = Geometry::ProbLo();
+        const Real* phi = Geometry::ProbHi();
+        const Real* dx  = amr.Geom(amr.finestLevel()).CellSize();
+
+        BoxLib::InitRandom(17 + ParallelDescriptor::MyProc());
+
+        std::vector<ParticleBase> prts(ncount);
+
+        for (int i = 0; i < ncount; i++)
+        {
+            ParticleBase& p = prts[i];
+
+            p.m_id   = i+1;
+            p.m_cpu  = ParallelDescriptor::MyProc();
+            p.m_lev  = -1;
+            p.m_grid = -1;
+
+            for (int d = 0; d < BL_SPACEDIM; d++)
+            {
+                const Real r = BoxLib::Random();
+
+                switch (i % 5)
+                {
+                case 0:
+                    //
+                    // On a face of the finest cells.
+                    //
+                    p.m_pos[d] = plo[d] + dx[d] * long(r * (phi[d]-plo[d]) / dx[d]);
+                    break;
+                case 1:
+                    //
+                    // On or just inside a domain edge.
+                    //
+                    p.m_pos[d] = (r < 0.5) ? plo[d] : phi[d] - 1.e-12*(phi[d]-plo[d]);
+                    break;
+                case 2:
+                    //
+                    // Up to a tenth of the domain outside it in some direction.
+                    //
+                    p.m_pos[d] = plo[d] + (1.2*r - 0.1) * (phi[d]-plo[d]);
+                    break;
+                default:
+                    p.m_pos[d] = plo[d] + r * (phi[d]-plo[d]);
+                }
+            }
+        }
+
+        for (int lev_min = 0; lev_min <= amr.finestLevel(); lev_min++)
+        {
+            for (int finest = lev_min; finest <= amr.finestLevel(); finest++)
+            {
+                std::vector<ParticleBase>  one(prts), batch(prts);
+                std::vector<ParticleBase*> ptrs(ncount);
+
+                for (int i = 0; i < ncount; i++)
+                    ptrs[i] = &batch[i];
+
+                Array<int> found;
+
+                ParticleBase::Where(ptrs, &amr, found, lev_min, finest);
+
+                long nbad = 0, nfound = 0;
+
+                for (int i = 0; i < ncount; i++)
+                {
+                    const bool ok = ParticleBase::Where(one[i], &amr, lev_min, finest);
+
+                    if (ok != bool(found[i]) || (ok && !same(one[i], batch[i])))
+                        nbad++;
+
+                    if (ok) nfound++;
+                }
+
+                ParallelDescriptor::ReduceLongSum(nbad);
+                ParallelDescriptor::ReduceLongSum(nfound);
+
+                if (ParallelDescriptor::IOProcessor())
+                    std::cout << "lev_min = " << lev_min << ", finest_level = " << finest
+                              << ": " << nfound << " found, " << nbad << " differ" << std::endl;
+
+                if (nbad > 0 || nfound == 0)
+                    nfail++;
+            }
+        }
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tWhere: batched Where() differs from one-particle Where()");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tWhere: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,287 @@
+//
+// Check BoxArray::intersections(), one Box at a time and batched, and
+// BoxArray::removeOverlap() against brute force, on BoxArrays dense
+// enough that their spatial index is a grid of bins and on ones so
+// spread out that it keeps only the bins that aren't empty.
+//
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <set>
+
+#include <Utility.H>
+#include <BoxArray.H>
+#include <ParallelDescriptor.H>
+
+typedef std::vector< std::pair<int,Box> > Isects;
+
+static int nfail = 0;
+
+static
+bool
+byIndex (const std::pair<int,Box>& a,
+         const std::pair<int,Box>& b)
+{
+    return a.first < b.first;
+}
+
+static
+bool
+same (const std::pair<int,Box>& a,
+      const std::pair<int,Box>& b)
+{
+    return a.first == b.first && a.second == b.second;
+}
+
+struct Same
+{
+    Same (const std::pair<int,Box>& a) : m_a(a) {}
+    bool operator() (const std::pair<int,Box>& b) const { return same(m_a, b); }
+    std::pair<int,Box> m_a;
+};
+
+static
+Box
+randomBox (const Box& domain,
+           int        maxlen)
+{
+    IntVect lo, hi;
+
+    for (int n = 0; n < BL_SPACEDIM; n++)
+    {
+        lo[n] = domain.smallEnd(n) + BoxLib::Random_int(domain.length(n));
+        hi[n] = std::min(lo[n] + int(BoxLib::Random_int(maxlen)), domain.bigEnd(n));
+    }
+
+    return Box(lo,hi);
+}
+
+static
+BoxArray
+randomBoxArray (const Box& domain,
+                int        nboxes,
+                int        maxlen)
+{
+    BoxArray ba(nboxes);
+
+    for (int i = 0; i < nboxes; i++)
+        ba.set(i, randomBox(domain, maxlen));
+
+    return ba;
+}
+
+static
+Isects
+bruteIntersections (const BoxArray& ba,
+                    const Box&      bx)
+{
+    Isects isects;
+
+    for (int i = 0; i < ba.size(); i++)
+    {
+        const Box isect = ba[i] & bx;
+
+        if (isect.ok())
+            isects.push_back(std::pair<int,Box>(i,isect));
+    }
+
+    return isects;
+}
+
+static
+bool
+sameIntersections (Isects a,
+                   Isects b)
+{
+    std::sort(a.begin(), a.end(), byIndex);
+    std::sort(b.begin(), b.end(), byIndex);
+
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), same);
+}
+//
+// Query ba with Boxes all over the domain and a bit beyond it, and
+// return how many answers differ from brute force.
+//
+static
+int
+checkIntersections (const BoxArray& ba,
+                    const Box&      domain,
+                    int             nqueries,
+                    int             maxlen)
+{
+    const Box outer = BoxLib::grow(domain, maxlen);
+
+    std::vector<Box> queries(nqueries);
+
+    for (int q = 0; q < nqueries; q++)
+        queries[q] = randomBox(outer, maxlen);
+    //
+    // Boxes of the BoxArray itself, grown and not.
+    //
+    for (int i = 0; i < ba.size(); i += 7)
+    {
+        queries.push_back(ba[i]);
+        queries.push_back(BoxLib::grow(ba[i],1));
+    }
+
+    std::vector<Isects> batched;
+
+    ba.intersections(queries, batched);
+
+    int nbad = 0;
+
+    if (batched.size() != queries.size())
+        nbad++;
+
+    Isects isects;
+
+    for (int q = 0; q < queries.size(); q++)
+    {
+        const Isects brute = bruteIntersections(ba, queries[q]);
+
+        ba.intersections(queries[q], isects);
+
+        if (!sameIntersections(isects, brute))
+            nbad++;
+
+        if (q < batched.size() && !sameIntersections(batched[q], brute))
+            nbad++;
+
+        ba.intersections(queries[q], isects, true);
+
+        if (isects.size() != std::min(brute.size(), size_t(1)))
+            nbad++;
+        else if (!isects.empty() && std::find_if(brute.begin(), brute.end(), Same(isects[0])) == brute.end())
+            nbad++;
+
+        if (ba.intersects(queries[q]) != !brute.empty())
+            nbad++;
+    }
+
+    return nbad;
+}
+
+static
+void
+addCells (std::set<IntVect,IntVect::Compare>& cells,
+          const Box&                          bx)
+{
+    for (IntVect iv = bx.smallEnd(), End = bx.bigEnd(); iv <= End; bx.next(iv))
+        cells.insert(iv);
+}
+//
+// removeOverlap() has to leave disjoint Boxes covering the same cells.
+//
+static
+int
+checkRemoveOverlap (const BoxArray& ba)
+{
+    BoxArray nba(ba);
+
+    nba.removeOverlap();
+
+    std::set<IntVect,IntVect::Compare> before, after;
+
+    for (int i = 0; i < ba.size(); i++)
+        addCells(before, ba[i]);
+
+    long npts = 0;
+
+    for (int i = 0; i < nba.size(); i++)
+    {
+        addCells(after, nba[i]);
+        npts += nba[i].numPts();
+    }
+
+    int nbad = 0;
+
+    if (before != after)
+        nbad++;
+
+    if (npts != after.size())
+        nbad++;
+
+    return nbad;
+}
+
+static
+void
+runCase (const char*     what,
+         const BoxArray& ba,
+         const Box&      domain,
+         int             maxlen)
+{
+    const int nisects  = checkIntersections(ba, domain, 2000, maxlen);
+    const int noverlap = checkRemoveOverlap(ba);
+
+    std::cout << what << ": " << ba.size() << " boxes, "
+              << nisects << " intersections and "
+              << noverlap << " removeOverlap() results differ from brute force" << std::endl;
+
+    nfail += nisects + noverlap;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    BoxLib::InitRandom(12345);
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        //
+        // A domain chopped into grids, and the same with the grids shifted
+        // so they overlap.
+        //
+        const Box domain(IntVect::TheZeroVector(), 63*IntVect::TheUnitVector());
+
+        BoxArray ba(domain);
+        ba.maxSize(8);
+
+        runCase("dense, disjoint", ba, domain, 12);
+
+        BoxArray shifted(ba.size());
+        for (int i = 0; i < ba.size(); i++)
+            shifted.set(i, ba[i] + IntVect(D_DECL(i%3,i%5,i%2)));
+
+        runCase("dense, overlapping", shifted, domain, 12);
+
+        runCase("dense, random", randomBoxArray(domain, 400, 10), domain, 12);
+        //
+        // A few small Boxes spread over a big domain, with one big one to
+        // make the bins big too.
+        //
+        const Box big(IntVect::TheZeroVector(), 4095*IntVect::TheUnitVector());
+
+        runCase("sparse, random", randomBoxArray(big, 300, 4), big, 8);
+
+        BoxArray spread = randomBoxArray(big, 300, 4);
+        spread.set(0, Box(IntVect::TheZeroVector(), 40*IntVect::TheUnitVector()));
+
+        runCase("sparse, one big box", spread, big, 48);
+        //
+        // Clusters of overlapping Boxes far apart.
+        //
+        BoxList bl;
+        for (int c = 0; c < 20; c++)
+        {
+            const Box cluster = BoxLib::grow(randomBox(big, 1), 6) & big;
+
+            for (int i = 0; i < 15; i++)
+                bl.push_back(randomBox(cluster, 6));
+        }
+
+        runCase("sparse, clusters", BoxArray(bl), big, 8);
+    }
+
+    ParallelDescriptor::ReduceIntMax(nfail);
+
+    if (nfail > 0)
+        BoxLib::Abort("tBAisects: BoxArray::intersections() or removeOverlap() differ from brute force");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tBAisects: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,212 @@
+//
+// Check that VisMF::Read() with chunked reads turned on gives bitwise the
+// same MultiFab as without, when the MultiFab was written with a different
+// DistributionMapping than it's read into, as on a restart on a different
+// number of CPUs.  It's written in FAB_NATIVE format, which gives a
+// Version 1 header, and in FAB_COMPRESSED, which gives a Version_2 header
+// with the size of each FAB, each both one file per CPU and into fewer
+// files than CPUs.
+//
+// With write = 0 it reads the files written by an earlier run, which
+// may have been on a different number of CPUs:
+//
+//   mpirun -np 3 tChunkedRead.ex
+//   mpirun -np 4 tChunkedRead.ex write=0
+//
+// Chunked reads need MPI and more than one CPU; on one CPU both reads
+// are the same.
+//
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <MultiFab.H>
+#include <VisMF.H>
+#include <ParallelDescriptor.H>
+
+static
+void
+fillFabs (MultiFab& mf)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        FArrayBox& fab = mf[mfi];
+        const Box& bx  = fab.box();
+
+        for (int n = 0; n < fab.nComp(); n++)
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+            {
+                long k = 17*n + mfi.index();
+                for (int d = 0; d < BL_SPACEDIM; d++)
+                    k = 31*k + iv[d];
+                fab(iv,n) = std::sin(Real(k));
+            }
+    }
+}
+//
+// The number of FABs that aren't bitwise the same, over the whole FAB or
+// only the valid region.
+//
+static
+long
+countDifferent (const MultiFab& a,
+                const MultiFab& b,
+                bool            ghosts = true)
+{
+    long nbad = 0;
+
+    for (MFIter mfi(a); mfi.isValid(); ++mfi)
+    {
+        const FArrayBox& fa = a[mfi];
+        const FArrayBox& fb = b[mfi];
+        const Box        bx = ghosts ? fa.box() : mfi.validbox();
+
+        bool same = (fa.box() == fb.box() && fa.nComp() == fb.nComp());
+
+        for (int n = 0; same && n < fa.nComp(); n++)
+            for (IntVect iv = bx.smallEnd(); same && iv <= bx.bigEnd(); bx.next(iv))
+                same = std::memcmp(&fa(iv,n), &fb(iv,n), sizeof(Real)) == 0;
+
+        if (!same) nbad++;
+    }
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+
+    return nbad;
+}
+
+static
+int
+headerVersion (const std::string& mf_name)
+{
+    int vers = -1;
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        std::ifstream ifs((mf_name + "_H").c_str());
+
+        ifs >> vers;
+    }
+
+    ParallelDescriptor::Bcast(&vers, 1, ParallelDescriptor::IOProcessorNumber());
+
+    return vers;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    const int NProcs = ParallelDescriptor::NProcs();
+
+    int n_cell = 64; int max_grid_size = 8; int nfiles = 2; int write = 1;
+    {
+        ParmParse pp;
+        pp.query("n_cell", n_cell);
+        pp.query("max_grid_size", max_grid_size);
+        pp.query("nfiles", nfiles);
+        pp.query("write", write);
+    }
+
+    if (NProcs == 1 && ParallelDescriptor::IOProcessor())
+        std::cout << "tChunkedRead: WARNING: on one CPU there are no chunked reads to test" << std::endl;
+
+    Box domain(IntVect::TheZeroVector(), (n_cell-1)*IntVect::TheUnitVector());
+
+    BoxArray ba(domain);
+    ba.maxSize(max_grid_size);
+    //
+    // Written with the CPUs dealt out backwards, so that most FABs are
+    // read into a different CPU than wrote them.
+    //
+    Array<int> pmap(ba.size()+1);
+    for (int i = 0; i < ba.size(); i++)
+        pmap[i] = NProcs - 1 - (i % NProcs);
+    pmap[ba.size()] = ParallelDescriptor::MyProc();
+
+    DistributionMapping written_dm(pmap);
+
+    MultiFab mf(ba, 3, 1, written_dm);
+
+    fillFabs(mf);
+
+    const FABio::Format formats[]  = { FABio::FAB_NATIVE, FABio::FAB_COMPRESSED };
+    const int           versions[] = { VisMF::Header::Version, VisMF::Header::Version_2 };
+    const VisMF::How    hows[]     = { VisMF::OneFilePerCPU, VisMF::NFiles };
+
+    const FABio::Format thePrevFormat = FArrayBox::getFormat();
+
+    VisMF::SetNOutFiles(nfiles);
+
+    int nfail = 0;
+
+    for (int f = 0; f < 2; f++)
+    {
+        for (int h = 0; h < 2; h++)
+        {
+            const std::string mf_name = BoxLib::Concatenate("tChunkedRead_mf_", 2*f+h, 1);
+
+            if (write)
+            {
+                FArrayBox::setFormat(formats[f]);
+
+                VisMF::Write(mf, mf_name, hows[h]);
+
+                FArrayBox::setFormat(thePrevFormat);
+            }
+
+            const int vers = headerVersion(mf_name);
+
+            MultiFab plain, chunked;
+
+            VisMF::SetChunkedRead(false);
+            VisMF::Read(plain, mf_name);
+
+            VisMF::SetChunkedRead(true);
+            VisMF::Read(chunked, mf_name);
+
+            VisMF::SetChunkedRead(false);
+
+            if (chunked.boxArray() != ba)
+                BoxLib::Abort("tChunkedRead: the MultiFab on disk has different boxes");
+
+            long nmoved = 0;
+            for (int i = 0; i < ba.size(); i++)
+                if (chunked.DistributionMap()[i] != written_dm[i])
+                    nmoved++;
+
+            const long nbad = countDifferent(plain, chunked);
+            //
+            // And the plain read against what we wrote.
+            //
+            MultiFab orig(ba, mf.nComp(), mf.nGrow(), plain.DistributionMap());
+            orig.copy(mf);
+            const long nbad_orig = countDifferent(plain, orig, false);
+
+            if (ParallelDescriptor::IOProcessor())
+            {
+                std::cout << "format " << formats[f] << ", header version " << vers
+                          << ", " << (hows[h] == VisMF::NFiles ? "NFiles" : "OneFilePerCPU") << ": ";
+                if (write)
+                    std::cout << nmoved << " of " << ba.size() << " FABs on a different CPU, ";
+                std::cout << nbad << " differ, " << nbad_orig << " differ from what was written"
+                          << std::endl;
+            }
+
+            if (vers != versions[f] || nbad > 0 || nbad_orig > 0)
+                nfail++;
+        }
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tChunkedRead: chunked reads differ from plain reads");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tChunkedRead: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,297 @@
+//
+// Round trips through the FAB_COMPRESSED codecs:
+//
+//   1. The lossless codec, and the LZ77 coder under it, give back every
+//      bit, NaNs, infinities and denormals included.
+//
+//   2. The error-bounded codec gives back every value to within the
+//      tolerance, including when it has to fall back on another codec.
+//
+//   3. A MultiFab written in the FAB_COMPRESSED format has a Version_2
+//      header, and readFAB() reads any component of any FAB, in any
+//      order, as it was written, or to within the tolerance.
+//
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <Utility.H>
+#include <MultiFab.H>
+#include <VisMF.H>
+#include <FabCompress.H>
+
+static int nfail = 0;
+//
+// Data of a few kinds, n values of it.
+//
+static
+std::vector<Real>
+makeData (int  kind,
+          long n)
+{
+    std::vector<Real> v(n);
+
+    for (long i = 0; i < n; i++)
+    {
+        switch (kind)
+        {
+        case 0:  v[i] = 0; break;
+        case 1:  v[i] = 3.25; break;
+        case 2:  v[i] = std::sin(0.01*i) + 1.e-3*std::cos(0.37*i); break;
+        case 3:  v[i] = BoxLib::Random() - 0.5; break;
+        case 4:  v[i] = 1.e6*(BoxLib::Random() - 0.5); break;
+        case 5:  v[i] = (i % 3 == 0) ? 1.e300 : -1.e-300*i; break;
+        default:
+            //
+            // Values that aren't ordinary numbers.
+            //
+            switch (i % 5)
+            {
+            case 0:  v[i] = std::numeric_limits<Real>::quiet_NaN(); break;
+            case 1:  v[i] = std::numeric_limits<Real>::infinity(); break;
+            case 2:  v[i] = -std::numeric_limits<Real>::infinity(); break;
+            case 3:  v[i] = std::numeric_limits<Real>::denorm_min()*i; break;
+            default: v[i] = -0.0; break;
+            }
+        }
+    }
+
+    return v;
+}
+
+static const int NKinds = 7;
+
+static
+void
+checkLossless ()
+{
+    const long sizes[] = { 0, 1, 2, 7, 1000, 70000 };
+
+    long nbad = 0;
+
+    for (int s = 0; s < 6; s++)
+    {
+        for (int kind = 0; kind < NKinds; kind++)
+        {
+            const long n = sizes[s];
+
+            const std::vector<Real> src = makeData(kind, n);
+
+            std::vector<char> buf;
+            double            param;
+
+            const int codec = FabCompress::compress(n ? &src[0] : 0, n, 0, buf, param);
+
+            std::vector<Real> dst(n+1);
+
+            FabCompress::decompress(codec, param, buf.empty() ? 0 : &buf[0], buf.size(), &dst[0], n);
+
+            if (codec == FabCompress::Quantize_LZ ||
+                (n > 0 && std::memcmp(&src[0], &dst[0], n*sizeof(Real)) != 0))
+                nbad++;
+        }
+    }
+    //
+    // The LZ77 coder on its own, on bytes with long repeats and without.
+    //
+    for (int kind = 0; kind < 3; kind++)
+    {
+        const long n = 100000;
+
+        std::vector<unsigned char> src(n);
+
+        for (long i = 0; i < n; i++)
+            src[i] = kind == 0 ? 'a' : kind == 1 ? (i % 1000) % 7 : BoxLib::Random_int(256);
+
+        std::vector<char> buf;
+
+        FabCompress::lz_compress(&src[0], n, buf);
+
+        std::vector<unsigned char> dst(n);
+
+        const long len = FabCompress::lz_decompress(reinterpret_cast<const unsigned char*>(&buf[0]),
+                                                    buf.size(), &dst[0], n);
+
+        if (len != n || src != dst)
+            nbad++;
+    }
+
+    std::cout << "lossless codec: " << nbad << " round trips not bit for bit" << std::endl;
+
+    if (nbad > 0)
+        nfail++;
+}
+
+static
+void
+checkErrorBounded ()
+{
+    const Real tols[] = { 0.5, 1.e-3, 1.e-9 };
+
+    long nbad = 0, nquantized = 0;
+
+    Real worst = 0;
+
+    for (int t = 0; t < 3; t++)
+    {
+        //
+        // Not the kinds with NaNs and infinities, which have no bound.
+        //
+        for (int kind = 0; kind < NKinds-1; kind++)
+        {
+            const long n = 50000;
+
+            const std::vector<Real> src = makeData(kind, n);
+
+            std::vector<char> buf;
+            double            param;
+
+            const int codec = FabCompress::compress(&src[0], n, tols[t], buf, param);
+
+            if (codec == FabCompress::Quantize_LZ)
+                nquantized++;
+
+            std::vector<Real> dst(n);
+
+            FabCompress::decompress(codec, param, &buf[0], buf.size(), &dst[0], n);
+
+            for (long i = 0; i < n; i++)
+            {
+                const Real err = std::abs(dst[i] - src[i]);
+
+                worst = std::max(worst, err/tols[t]);
+
+                if (!(err <= tols[t]))
+                    nbad++;
+            }
+        }
+    }
+
+    std::cout << "error-bounded codec: " << nquantized << " quantized, " << nbad
+              << " values outside the tolerance, worst |error| / tolerance = " << worst << std::endl;
+
+    if (nbad > 0 || nquantized == 0)
+        nfail++;
+}
+
+static
+void
+checkReadFAB (Real tol)
+{
+    const std::string name = "tCompress_mf";
+
+    BoxArray ba(Box(IntVect::TheZeroVector(), 31*IntVect::TheUnitVector()));
+    ba.maxSize(8);
+
+    const int ncomp = NKinds-1;
+
+    MultiFab mf(ba, ncomp, 1);
+
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        const long n = mf[mfi].box().numPts();
+
+        for (int comp = 0; comp < ncomp; comp++)
+        {
+            const std::vector<Real> v = makeData(comp, n);
+
+            std::memcpy(mf[mfi].dataPtr(comp), &v[0], n*sizeof(Real));
+        }
+    }
+
+    FArrayBox::setFormat(FABio::FAB_COMPRESSED);
+    FArrayBox::setCompressionTolerance(tol);
+
+    VisMF::Write(mf, name);
+
+    FArrayBox::setFormat(FABio::FAB_NATIVE);
+    FArrayBox::setCompressionTolerance(0);
+
+    int vers = -1;
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        std::ifstream ifs((name + "_H").c_str());
+        ifs >> vers;
+    }
+    ParallelDescriptor::ReduceIntMax(vers);
+
+    VisMF vismf(name);
+
+    long nbad = 0;
+    //
+    // Our FABs backwards, components in a made-up order, each twice.
+    //
+    std::vector<int> ours;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        ours.push_back(mfi.index());
+
+    for (int k = ours.size()-1; k >= 0; k--)
+    {
+        const int        idx  = ours[k];
+        const FArrayBox& orig = mf[idx];
+
+        for (int j = 0; j < 2*ncomp; j++)
+        {
+            const int comp = (j*5 + idx) % ncomp;
+
+            FArrayBox* fab = vismf.readFAB(idx, comp);
+
+            if (fab->box() != orig.box())
+                nbad++;
+            else
+                for (long i = 0, N = orig.box().numPts(); i < N; i++)
+                    if (!(std::abs(fab->dataPtr()[i] - orig.dataPtr(comp)[i]) <= tol))
+                        nbad++;
+
+            delete fab;
+        }
+
+        FArrayBox* fab = vismf.readFAB(idx, name);
+
+        for (int comp = 0; comp < ncomp; comp++)
+            for (long i = 0, N = orig.box().numPts(); i < N; i++)
+                if (!(std::abs(fab->dataPtr(comp)[i] - orig.dataPtr(comp)[i]) <= tol))
+                    nbad++;
+
+        delete fab;
+    }
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "readFAB(), tolerance " << tol << ": header version " << vers << ", "
+                  << nbad << " values differ by more than the tolerance" << std::endl;
+
+    if (nbad > 0 || vers != VisMF::Header::Version_2)
+        nfail++;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    BoxLib::InitRandom(451);
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        checkLossless();
+        checkErrorBounded();
+    }
+
+    checkReadFAB(0);
+    checkReadFAB(1.e-6);
+
+    ParallelDescriptor::ReduceIntMax(nfail);
+
+    if (nfail > 0)
+        BoxLib::Abort("tCompress: compressed FABs don't come back as they were written");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tCompress: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,312 @@
+//
+// Check the BaseFab arithmetic against plain loops over the cells, done
+// one cell at a time in the order the cells are stored: on whole FABs,
+// where the loops fold into one, on boxes of whole rows, on sub-boxes
+// with several components, and with the destination also a source,
+// either exactly (x.plus(x)) or shifted so that the two overlap.  The
+// data are small integers, so the reductions are exact whatever order
+// the kernels add them in, and everything is compared bitwise.
+//
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cmath>
+
+#include <Utility.H>
+#include <FArrayBox.H>
+#include <ParallelDescriptor.H>
+
+enum Op { Copy, Plus, Minus, Mult, Divide, ProtectedDivide, Saxpy, Xpay, NumOps };
+
+static const char* OpName[NumOps] =
+{
+    "copy", "plus", "minus", "mult", "divide", "protected_divide", "saxpy", "xpay"
+};
+
+static const Real a     =  0.5;
+static const Real alpha =  0.5;
+static const Real beta  = -2.0;
+
+static int nfail = 0;
+
+//
+// Integers in [-8,8] that depend on the cell, the component and the
+// seed, with no zeros if zeros is false.
+//
+static
+void
+fill (FArrayBox& fab,
+      int        seed,
+      bool       zeros)
+{
+    const Box& bx = fab.box();
+
+    for (int n = 0; n < fab.nComp(); n++)
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+        {
+            long k = 17*n + seed;
+            for (int d = 0; d < BL_SPACEDIM; d++)
+                k = 31*k + iv[d];
+            int v = int((k%17 + 17)%17) - 8;
+            if (v == 0 && !zeros) v = 9;
+            fab(iv,n) = v;
+        }
+}
+
+static
+void
+apply (int              op,
+       FArrayBox&       d,
+       const FArrayBox& x,
+       const Box&       srcbox,
+       const Box&       destbox,
+       int              srccomp,
+       int              destcomp,
+       int              ncomp)
+{
+    switch (op)
+    {
+    case Copy:            d.copy(x,srcbox,srccomp,destbox,destcomp,ncomp);                 break;
+    case Plus:            d.plus(x,srcbox,destbox,srccomp,destcomp,ncomp);                 break;
+    case Minus:           d.minus(x,srcbox,destbox,srccomp,destcomp,ncomp);                break;
+    case Mult:            d.mult(x,srcbox,destbox,srccomp,destcomp,ncomp);                 break;
+    case Divide:          d.divide(x,srcbox,destbox,srccomp,destcomp,ncomp);               break;
+    case ProtectedDivide: d.protected_divide(x,srcbox,destbox,srccomp,destcomp,ncomp);     break;
+    case Saxpy:           d.saxpy(a,x,srcbox,destbox,srccomp,destcomp,ncomp);              break;
+    case Xpay:            d.xpay(a,x,srcbox,destbox,srccomp,destcomp,ncomp);               break;
+    }
+}
+
+static
+void
+reference (int              op,
+           FArrayBox&       d,
+           const FArrayBox& x,
+           const Box&       srcbox,
+           const Box&       destbox,
+           int              srccomp,
+           int              destcomp,
+           int              ncomp)
+{
+    const IntVect shift = srcbox.smallEnd() - destbox.smallEnd();
+
+    for (int n = 0; n < ncomp; n++)
+        for (IntVect iv = destbox.smallEnd(); iv <= destbox.bigEnd(); destbox.next(iv))
+        {
+            const Real xv = x(iv+shift,srccomp+n);
+            Real&      dv = d(iv,destcomp+n);
+
+            switch (op)
+            {
+            case Copy:            dv = xv;                break;
+            case Plus:            dv += xv;               break;
+            case Minus:           dv -= xv;               break;
+            case Mult:            dv *= xv;               break;
+            case Divide:          dv /= xv;               break;
+            case ProtectedDivide: if (xv) dv /= xv;       break;
+            case Saxpy:           dv += a*xv;             break;
+            case Xpay:            dv = xv + a*dv;         break;
+            }
+        }
+}
+
+static
+void
+checkSame (const FArrayBox&   got,
+           const FArrayBox&   want,
+           const std::string& what)
+{
+    BL_ASSERT(got.box() == want.box() && got.nComp() == want.nComp());
+
+    const long n = got.box().numPts()*got.nComp();
+
+    if (std::memcmp(got.dataPtr(), want.dataPtr(), n*sizeof(Real)) != 0)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        nfail++;
+    }
+}
+
+static
+void
+checkSame (Real               got,
+           Real               want,
+           const std::string& what)
+{
+    if (got != want)
+    {
+        std::cout << "FAILED: " << what << ": got " << got << ", want " << want << std::endl;
+        nfail++;
+    }
+}
+//
+// The destination is a FAB on dbox; the source is a different FAB on
+// xbox or, if alias, the destination itself.
+//
+static
+void
+runCase (int                op,
+         const std::string& what,
+         const Box&         dbox,
+         const Box&         xbox,
+         const Box&         srcbox,
+         const Box&         destbox,
+         int                srccomp,
+         int                destcomp,
+         int                ncomp,
+         bool               alias)
+{
+    const bool zeros = (op != Divide);
+
+    FArrayBox d(dbox,3), x(xbox,3), rd(dbox,3);
+
+    fill(d,1,zeros);
+    fill(x,2,zeros);
+    rd.copy(d);
+
+    if (alias)
+    {
+        apply(op,d,d,srcbox,destbox,srccomp,destcomp,ncomp);
+        reference(op,rd,rd,srcbox,destbox,srccomp,destcomp,ncomp);
+    }
+    else
+    {
+        apply(op,d,x,srcbox,destbox,srccomp,destcomp,ncomp);
+        reference(op,rd,x,srcbox,destbox,srccomp,destcomp,ncomp);
+    }
+
+    checkSame(d, rd, std::string(OpName[op]) + " " + what);
+}
+//
+// d = alpha*f1 + beta*f2 with d a FAB on dbox and the sources on b1 and
+// b2.  With dst = 1 or 2 the destination is f1 or f2 as well.
+//
+static
+void
+runLinComb (const std::string& what,
+            const Box&         dbox,
+            const Box&         xbox,
+            const Box&         b1,
+            const Box&         b2,
+            const Box&         b,
+            int                comp1,
+            int                comp2,
+            int                comp,
+            int                ncomp,
+            int                dst)
+{
+    FArrayBox d(dbox,3), f1(xbox,3), f2(xbox,3), rd(dbox,3);
+
+    fill(d,1,true);
+    fill(f1,2,true);
+    fill(f2,3,true);
+    rd.copy(d);
+
+    const FArrayBox& s1  = (dst == 1) ? d  : f1;
+    const FArrayBox& s2  = (dst == 2) ? d  : f2;
+    const FArrayBox& rs1 = (dst == 1) ? rd : f1;
+    const FArrayBox& rs2 = (dst == 2) ? rd : f2;
+
+    d.linComb(s1,b1,comp1,s2,b2,comp2,alpha,beta,b,comp,ncomp);
+
+    const IntVect sh1 = b1.smallEnd() - b.smallEnd();
+    const IntVect sh2 = b2.smallEnd() - b.smallEnd();
+
+    for (int n = 0; n < ncomp; n++)
+        for (IntVect iv = b.smallEnd(); iv <= b.bigEnd(); b.next(iv))
+            rd(iv,comp+n) = alpha*rs1(iv+sh1,comp1+n) + beta*rs2(iv+sh2,comp2+n);
+
+    checkSame(d, rd, "linComb " + what);
+}
+
+static
+void
+runReductions (const std::string& what,
+               const FArrayBox&   f,
+               const Box&         bx,
+               int                comp,
+               int                ncomp)
+{
+    Real sum = 0, nrm0 = 0, nrm1 = 0;
+
+    for (int n = comp; n < comp+ncomp; n++)
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+        {
+            sum += f(iv,n);
+            nrm1 += std::abs(f(iv,n));
+            nrm0  = std::max(nrm0, std::abs(f(iv,n)));
+        }
+
+    Real mn = f(bx.smallEnd(),comp), mx = mn;
+
+    for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+    {
+        mn = std::min(mn, f(iv,comp));
+        mx = std::max(mx, f(iv,comp));
+    }
+
+    checkSame(f.sum(bx,comp,ncomp),    sum,  "sum "     + what);
+    checkSame(f.norm(bx,0,comp,ncomp), nrm0, "norm(0) " + what);
+    checkSame(f.norm(bx,1,comp,ncomp), nrm1, "norm(1) " + what);
+    checkSame(f.min(bx,comp),          mn,   "min "     + what);
+    checkSame(f.max(bx,comp),          mx,   "max "     + what);
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    const IntVect unit = IntVect::TheUnitVector();
+    //
+    // The destination FAB, a source FAB of another shape, a sub-box of
+    // each of the same size, and a box of whole rows of the destination.
+    //
+    const Box dbox(IntVect::TheZeroVector(), 11*unit);
+    const Box xbox(-3*unit, 10*unit);
+
+    Box sub(2*unit, 8*unit);
+    sub.growHi(0,1);
+
+    const Box xsub = Box(sub).shift(0,-5).shift(1,-4);
+
+    Box rows(dbox);
+    rows.growLo(BL_SPACEDIM-1,-2).growHi(BL_SPACEDIM-1,-3);
+
+    BL_ASSERT(xbox.contains(xsub));
+
+    for (int op = 0; op < NumOps; op++)
+    {
+        runCase(op, "on whole FABs",                dbox, dbox, dbox, dbox, 0, 0, 3, false);
+        runCase(op, "on whole rows",                dbox, dbox, rows, rows, 0, 1, 2, false);
+        runCase(op, "on sub-boxes",                 dbox, xbox, xsub, sub,  1, 0, 2, false);
+        runCase(op, "of a FAB with itself",         dbox, dbox, dbox, dbox, 0, 0, 3, true);
+        runCase(op, "of a sub-box with itself",     dbox, dbox, sub,  sub,  1, 1, 2, true);
+        runCase(op, "reading behind along x",       dbox, dbox, Box(sub).shift(0,-1), sub, 0, 0, 2, true);
+        runCase(op, "reading ahead along x",        dbox, dbox, Box(sub).shift(0, 1), sub, 0, 0, 2, true);
+        runCase(op, "reading behind along y",       dbox, dbox, Box(sub).shift(1,-1), sub, 0, 0, 2, true);
+        runCase(op, "into the next component",      dbox, dbox, dbox, dbox, 0, 1, 2, true);
+    }
+
+    runLinComb("on whole FABs",          dbox, dbox, dbox, dbox, dbox, 0, 0, 0, 3, 0);
+    runLinComb("on sub-boxes",           dbox, xbox, xsub, xsub, sub,  1, 0, 0, 2, 0);
+    runLinComb("with dst as f1",         dbox, dbox, dbox, dbox, dbox, 0, 0, 0, 3, 1);
+    runLinComb("with dst as f2",         dbox, dbox, dbox, dbox, dbox, 0, 0, 0, 3, 2);
+    runLinComb("with dst as f1 shifted", dbox, dbox, Box(sub).shift(0,-1), sub, sub, 0, 1, 0, 2, 1);
+
+    FArrayBox f(dbox,3);
+    fill(f,4,true);
+
+    runReductions("on the whole FAB", f, dbox, 0, 3);
+    runReductions("on whole rows",    f, rows, 1, 2);
+    runReductions("on a sub-box",     f, sub,  1, 2);
+    runReductions("on one cell",      f, Box(sub.smallEnd(),sub.smallEnd()), 2, 1);
+
+    if (nfail > 0)
+        BoxLib::Abort("tFabKernels: the BaseFab arithmetic differs from plain loops");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tFabKernels: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,168 @@
+//
+// Check that FabSet::copyFrom() and plusFrom() with nghost > 0, which
+// copy straight out of the ghost cells of the source, give the same
+// results as copying the source into a temporary MultiFab over its
+// grown boxes first.
+//
+// The source holds integer values that depend only on the cell, so it
+// doesn't matter which of several overlapping grown boxes a value
+// comes from, and sums are exact in any order.
+//
+#include <iostream>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <MultiFab.H>
+#include <FabSet.H>
+#include <ParallelDescriptor.H>
+
+static
+void
+fillIndex (MultiFab& mf)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        FArrayBox& fab = mf[mfi];
+        const Box& bx  = fab.box();
+
+        for (int n = 0; n < fab.nComp(); n++)
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+            {
+                Real v = 1000*n;
+                for (int d = 0; d < BL_SPACEDIM; d++)
+                    v += (d+2)*(d+3)*iv[d];
+                fab(iv,n) = v;
+            }
+    }
+}
+//
+// The old way: copy src, ghost cells and all, into a temporary over its
+// grown boxes and copy from that with no ghost cells.
+//
+static
+void
+viaTemporary (FabSet&         fs,
+              const MultiFab& src,
+              int             nghost,
+              int             scomp,
+              int             dcomp,
+              int             ncomp,
+              bool            plus)
+{
+    BoxArray ba = src.boxArray();
+
+    ba.grow(nghost);
+
+    MultiFab tmpsrc(ba, ncomp, 0, src.DistributionMap());
+
+    for (MFIter mfi(tmpsrc); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.validbox();
+        tmpsrc[mfi].copy(src[mfi], bx, scomp, bx, 0, ncomp);
+    }
+
+    if (plus)
+        fs.plusFrom(tmpsrc, 0, 0, dcomp, ncomp);
+    else
+        fs.copyFrom(tmpsrc, 0, 0, dcomp, ncomp);
+}
+
+static
+Real
+maxDiff (const FabSet& a,
+         const FabSet& b)
+{
+    Real diff = 0;
+
+    for (FabSetIter fsi(a); fsi.isValid(); ++fsi)
+    {
+        FArrayBox d(a[fsi].box(), a[fsi].nComp());
+        d.copy(a[fsi]);
+        d.minus(b[fsi]);
+        diff = std::max(diff, d.norm(0, 0, d.nComp()));
+    }
+
+    ParallelDescriptor::ReduceRealMax(diff);
+
+    return diff;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    ParmParse pp;
+
+    int n_cell = 32; pp.query("n_cell", n_cell);
+    int max_grid_size = 8; pp.query("max_grid_size", max_grid_size);
+
+    const int ncomp = 2;
+
+    Box domain(IntVect::TheZeroVector(), (n_cell-1)*IntVect::TheUnitVector());
+
+    BoxArray ba(domain);
+    ba.maxSize(max_grid_size);
+
+    MultiFab src(ba, ncomp+1, 3);
+    fillIndex(src);
+    //
+    // The faces just outside each grid, as a BndryRegister has them,
+    // plus a coarser layout whose boxes straddle several source grids.
+    //
+    BoxList bl;
+    for (int i = 0; i < ba.size(); i++)
+        for (int d = 0; d < BL_SPACEDIM; d++)
+        {
+            bl.push_back(BoxLib::adjCellLo(ba[i], d, 1));
+            bl.push_back(BoxLib::adjCellHi(ba[i], d, 1));
+        }
+    BoxArray fba(bl);
+
+    BoxArray cba(BoxLib::grow(domain, 2));
+    cba.maxSize(3*max_grid_size/2);
+
+    const BoxArray* layouts[] = { &fba, &cba };
+
+    int nfail = 0;
+
+    for (int l = 0; l < 2; l++)
+    {
+        for (int nghost = 1; nghost <= 3; nghost++)
+        {
+            for (int plus = 0; plus <= 1; plus++)
+            {
+                FabSet fs_new(*layouts[l], ncomp), fs_old(*layouts[l], ncomp);
+
+                fs_new.setVal(-1);
+                fs_old.setVal(-1);
+
+                if (plus)
+                    fs_new.plusFrom(src, nghost, 1, 0, ncomp);
+                else
+                    fs_new.copyFrom(src, nghost, 1, 0, ncomp);
+
+                viaTemporary(fs_old, src, nghost, 1, 0, ncomp, plus);
+
+                const Real diff = maxDiff(fs_new, fs_old);
+
+                if (ParallelDescriptor::IOProcessor())
+                    std::cout << (l == 0 ? "faces" : "coarse boxes")
+                              << ", nghost = " << nghost
+                              << (plus ? ", plusFrom" : ", copyFrom")
+                              << ": max |difference| = " << diff << std::endl;
+
+                if (diff != 0)
+                    nfail++;
+            }
+        }
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tFabSet: copying from ghost cells differs from copying via a temporary");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tFabSet: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
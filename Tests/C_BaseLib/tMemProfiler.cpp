@@ -0,0 +1,205 @@
+//
+// Check MemProfiler's counts: that FABs are charged to the tag in force
+// in the thread that allocates them and to no other, that the counts
+// come back down when they're freed, and that the high-water marks are
+// exact when the threads free what they allocate and never too low when
+// they free each other's.  Build with USE_OMP=TRUE to run it on several
+// threads.
+//
+#include <iostream>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <FArrayBox.H>
+#include <MemProfiler.H>
+#include <ParallelDescriptor.H>
+
+static int nfail = 0;
+
+static
+void
+check (bool        ok,
+       const char* what,
+       long        got,
+       long        want)
+{
+    if (!ok)
+    {
+        std::cout << "FAILED: " << what << ": got " << got << ", want " << want << std::endl;
+        nfail++;
+    }
+}
+
+static
+int
+threadNum ()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+static
+int
+numThreads ()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    int nfabs = 10; int n_cell = 16;
+    {
+        ParmParse pp;
+        pp.query("nfabs", nfabs);
+        pp.query("n_cell", n_cell);
+    }
+
+    const int  nthreads = numThreads();
+    const Box  bx(IntVect::TheZeroVector(), (n_cell-1)*IntVect::TheUnitVector());
+    const int  ncomp    = 2;
+    const long fabbytes = bx.numPts()*ncomp*sizeof(Real);
+    const long fabcells = bx.numPts();
+
+    long base[MemProfiler::NumTags];
+    for (int t = 0; t < MemProfiler::NumTags; t++)
+        base[t] = MemProfiler::Bytes(t);
+    const long basefab   = MemProfiler::FabBytes();
+    const long basecells = MemProfiler::FabCells();
+    //
+    // One thread: each tag gets what's allocated under it.
+    //
+    {
+        FArrayBox scratch(bx, ncomp);
+
+        check(MemProfiler::Bytes(MemProfiler::Scratch) - base[MemProfiler::Scratch] == fabbytes,
+              "Scratch bytes", MemProfiler::Bytes(MemProfiler::Scratch) - base[MemProfiler::Scratch], fabbytes);
+
+        MemProfiler::TagScope mts(MemProfiler::State);
+
+        FArrayBox state(bx, ncomp);
+
+        check(MemProfiler::Bytes(MemProfiler::State) - base[MemProfiler::State] == fabbytes,
+              "State bytes", MemProfiler::Bytes(MemProfiler::State) - base[MemProfiler::State], fabbytes);
+        check(MemProfiler::Bytes(MemProfiler::Scratch) - base[MemProfiler::Scratch] == fabbytes,
+              "Scratch bytes after a State FAB", MemProfiler::Bytes(MemProfiler::Scratch) - base[MemProfiler::Scratch], fabbytes);
+
+        MemProfiler::Add(MemProfiler::CommBuffer, 1000);
+
+        check(MemProfiler::Bytes(MemProfiler::CommBuffer) - base[MemProfiler::CommBuffer] == 1000,
+              "CommBuffer bytes", MemProfiler::Bytes(MemProfiler::CommBuffer) - base[MemProfiler::CommBuffer], 1000);
+        check(MemProfiler::FabBytes() - basefab == 2*fabbytes,
+              "FAB bytes", MemProfiler::FabBytes() - basefab, 2*fabbytes);
+        check(MemProfiler::FabCells() - basecells == 2*fabcells,
+              "FAB cells", MemProfiler::FabCells() - basecells, 2*fabcells);
+
+        MemProfiler::Remove(MemProfiler::CommBuffer, 1000);
+    }
+
+    check(MemProfiler::FabBytes() == basefab, "FAB bytes after freeing", MemProfiler::FabBytes(), basefab);
+    check(MemProfiler::CurrentTag() == MemProfiler::Scratch, "tag after a TagScope",
+          MemProfiler::CurrentTag(), MemProfiler::Scratch);
+    //
+    // Several threads, the even ones allocating State FABs and the odd
+    // ones Scratch at the same time, each freeing its own.
+    //
+    MemProfiler::ReportStep(0);
+
+    const long nalloc0 = MemProfiler::NumAllocs(MemProfiler::State);
+
+    check(nalloc0 == 0, "State allocations after ReportStep()", nalloc0, 0);
+
+    int neven = 0;
+    for (int i = 0; i < nthreads; i += 2)
+        neven++;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        MemProfiler::TagScope mts(threadNum() % 2 == 0 ? MemProfiler::State : MemProfiler::Scratch);
+
+        std::vector<FArrayBox*> fabs(nfabs);
+
+        for (int i = 0; i < nfabs; i++)
+            fabs[i] = new FArrayBox(bx, ncomp);
+
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+        for (int i = 0; i < nfabs; i++)
+            delete fabs[i];
+    }
+
+    const long state_hwm   = MemProfiler::BytesHWM(MemProfiler::State) - base[MemProfiler::State];
+    const long scratch_hwm = MemProfiler::BytesHWM(MemProfiler::Scratch) - base[MemProfiler::Scratch];
+    const long fab_hwm     = MemProfiler::FabBytesHWM() - basefab;
+
+    check(state_hwm == neven*nfabs*fabbytes, "State high-water mark", state_hwm, neven*nfabs*fabbytes);
+    check(scratch_hwm == (nthreads-neven)*nfabs*fabbytes, "Scratch high-water mark",
+          scratch_hwm, (nthreads-neven)*nfabs*fabbytes);
+    check(fab_hwm == nthreads*nfabs*fabbytes, "FAB high-water mark", fab_hwm, nthreads*nfabs*fabbytes);
+    check(MemProfiler::NumAllocs(MemProfiler::State) == neven*nfabs, "State allocations",
+          MemProfiler::NumAllocs(MemProfiler::State), neven*nfabs);
+    check(MemProfiler::FabBytes() == basefab, "FAB bytes after the threads", MemProfiler::FabBytes(), basefab);
+    //
+    // The threads allocate and this thread frees, twice.  The marks may
+    // be too high but never too low, and ResetHWM() brings them back.
+    //
+    MemProfiler::ReportStep(1);
+
+    for (int rep = 0; rep < 2; rep++)
+    {
+        std::vector<FArrayBox*> fabs(nthreads*nfabs);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < nthreads*nfabs; i++)
+            fabs[i] = new FArrayBox(bx, ncomp);
+
+        check(MemProfiler::FabBytes() - basefab == nthreads*nfabs*fabbytes, "FAB bytes from the threads",
+              MemProfiler::FabBytes() - basefab, nthreads*nfabs*fabbytes);
+
+        for (int i = 0; i < nthreads*nfabs; i++)
+            delete fabs[i];
+    }
+
+    check(MemProfiler::FabBytesHWM() - basefab >= nthreads*nfabs*fabbytes,
+          "FAB high-water mark with frees by another thread",
+          MemProfiler::FabBytesHWM() - basefab, nthreads*nfabs*fabbytes);
+    check(MemProfiler::FabBytes() == basefab, "FAB bytes after freeing the threads' FABs",
+          MemProfiler::FabBytes(), basefab);
+
+    MemProfiler::ResetHWM();
+
+    check(MemProfiler::FabBytesHWM() == basefab, "FAB high-water mark after ResetHWM()",
+          MemProfiler::FabBytesHWM(), basefab);
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << nthreads << " threads, " << nfabs << " FABs of " << fabbytes << " bytes each" << std::endl;
+
+    ParallelDescriptor::ReduceIntSum(nfail);
+
+    if (nfail > 0)
+        BoxLib::Abort("tMemProfiler: wrong counts");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tMemProfiler: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
@@ -0,0 +1,256 @@
+//
+// With fabarray.numa_first_touch=1 FabArray::AllocFabs() has the threads
+// write each FAB's memory tile by tile instead of letting the FArrayBox
+// constructor do it.  Check that every value, ghost cells included, is
+// what it would have been without, for MultiFabs with and without
+// initial values and for iMultiFabs, and that the FArrayBox settings
+// are left as they were.  Then check that NumaDomain() names a NUMA node
+// that exists for memory that's been touched, and -1 for memory that
+// hasn't or when the OS can't tell.
+//
+#include <iostream>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <cstring>
+#include <cstdlib>
+
+#include <Utility.H>
+#include <ParallelDescriptor.H>
+#include <ParmParse.H>
+#include <MultiFab.H>
+#include <iMultiFab.H>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static int nfail = 0;
+//
+// How many NUMA nodes there are, or 0 if we can't tell.
+//
+static
+int
+numNodes ()
+{
+    int n = 0;
+
+    if (DIR* dir = opendir("/sys/devices/system/node"))
+    {
+        while (dirent* e = readdir(dir))
+            if (std::strncmp(e->d_name, "node", 4) == 0 && std::isdigit(e->d_name[4]))
+                n = std::max(n, std::atoi(e->d_name + 4) + 1);
+
+        closedir(dir);
+    }
+
+    return n;
+}
+//
+// How many values in the FABs of mf, ghost cells and all, aren't val.
+//
+template <class FAB>
+static
+long
+countNot (const FabArray<FAB>&                  mf,
+          typename FAB::value_type              val)
+{
+    long nbad = 0;
+
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        const FAB& fab = mf[mfi];
+
+        const long N = fab.box().numPts()*fab.nComp();
+
+        for (long i = 0; i < N; i++)
+            if (fab.dataPtr()[i] != val)
+                nbad++;
+    }
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+
+    return nbad;
+}
+
+static
+void
+checkValues (const BoxArray& ba)
+{
+    const int ncomp = 3, ngrow = 2;
+
+    const bool do_initval = FArrayBox::get_do_initval();
+    const Real initval    = FArrayBox::get_initval();
+    //
+    // With initial values, and without, when the FABs get zeros.
+    //
+    FArrayBox::set_do_initval(true);
+    FArrayBox::set_initval(3.5);
+
+    long nbad = 0;
+
+    {
+        MultiFab mf(ba, ncomp, ngrow);
+        nbad += countNot(mf, 3.5);
+    }
+
+    if (!FArrayBox::get_do_initval() || FArrayBox::get_initval() != 3.5)
+        nbad++;
+
+    FArrayBox::set_do_initval(false);
+
+    {
+        MultiFab mf(ba, ncomp, ngrow);
+        nbad += countNot(mf, Real(0));
+    }
+
+    if (FArrayBox::get_do_initval())
+        nbad++;
+
+    {
+        iMultiFab imf(ba, ncomp, ngrow);
+        nbad += countNot(imf, 0);
+    }
+    //
+    // Values written after the first touch stay put.
+    //
+    {
+        MultiFab mf(ba, ncomp, ngrow);
+
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+            mf[mfi].setVal(mfi.index() + 0.25);
+
+        mf.FillBoundary();
+
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+            if (mf[mfi].min(mfi.validbox(), 0) != mfi.index() + 0.25 ||
+                mf[mfi].max(mfi.validbox(), ncomp-1) != mfi.index() + 0.25)
+                nbad++;
+    }
+
+    FArrayBox::set_do_initval(do_initval);
+    FArrayBox::set_initval(initval);
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "first touch: " << nbad << " values not what they'd be without it" << std::endl;
+
+    if (nbad > 0)
+        nfail++;
+}
+
+static
+void
+checkNumaDomain (const BoxArray& ba)
+{
+    const int nnodes = numNodes();
+    //
+    // A page we've written to has a node, if the OS will say which,
+    // and one we've never touched hasn't.
+    //
+    const std::size_t pagesize = sysconf(_SC_PAGESIZE);
+
+    char* p = static_cast<char*>(::mmap(0, 4*pagesize, PROT_READ|PROT_WRITE,
+                                        MAP_PRIVATE|MAP_ANONYMOUS, -1, 0));
+    if (p == MAP_FAILED)
+        BoxLib::Abort("tNumaFirstTouch: mmap() failed");
+
+    p[0] = 1;
+
+    const int touched   = FabArrayBase::NumaDomain(p, 1);
+    const int untouched = FabArrayBase::NumaDomain(p + 2*pagesize, 2*pagesize);
+
+    ::munmap(p, 4*pagesize);
+
+    const bool known = touched >= 0;
+
+    long nbad = 0;
+
+    if (known && (nnodes > 0 && touched >= nnodes))
+        nbad++;
+
+    if (untouched != -1)
+        nbad++;
+
+    if (FabArrayBase::NumaDomain(0, 100) != -1 || FabArrayBase::NumaDomain(p, 0) != -1)
+        nbad++;
+    //
+    // Every local FAB is somewhere, and the same place however we ask.
+    //
+    MultiFab mf(ba, 2, 1);
+
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        const int node = mf.NumaDomain(mfi);
+
+        if (node != mf.NumaDomain(mfi.index()))
+            nbad++;
+
+        if (known ? (node < 0 || (nnodes > 0 && node >= nnodes)) : node != -1)
+            nbad++;
+    }
+
+    ParallelDescriptor::ReduceLongSum(nbad);
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        if (known)
+            std::cout << "NumaDomain(): " << nnodes << " node(s), ";
+        else
+            std::cout << "NumaDomain(): the OS won't say where pages are, ";
+        std::cout << nbad << " wrong answers" << std::endl;
+    }
+
+    if (nbad > 0)
+        nfail++;
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+#ifdef _OPENMP
+    //
+    // AllocFabs() only first-touches with more than one thread.
+    //
+    if (omp_get_max_threads() < 2)
+        omp_set_num_threads(4);
+#endif
+    //
+    // As if from the inputs file, since FabArrayBase reads them when the
+    // first FabArray is built.  Tiles smaller than the boxes, so each FAB
+    // is touched by several threads.
+    //
+    {
+        ParmParse pp("fabarray");
+
+        pp.add("numa_first_touch", true);
+
+        std::vector<int> tile_size(BL_SPACEDIM, 4);
+        tile_size[0] = 8;
+        pp.addarr("mfiter_tile_size", tile_size);
+    }
+
+    Box domain(IntVect::TheZeroVector(), 63*IntVect::TheUnitVector());
+
+    BoxArray ba(domain);
+    ba.maxSize(32);
+
+    checkValues(ba);
+    checkNumaDomain(ba);
+
+    if (!FabArrayBase::numa_first_touch)
+        BoxLib::Abort("tNumaFirstTouch: fabarray.numa_first_touch didn't take");
+
+    if (nfail > 0)
+        BoxLib::Abort("tNumaFirstTouch: first touch changed FAB values or NumaDomain() got it wrong");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tNumaFirstTouch: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
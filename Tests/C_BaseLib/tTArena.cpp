@@ -0,0 +1,306 @@
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+#include <REAL.H>
+#include <TArena.H>
+#include <Utility.H>
+
+#include <list>
+#include <new>
+#include <vector>
+using std::list;
+
+#include <pthread.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//
+// A simple class emulating how we use FABs.
+//
+class FB
+{
+public:
+    FB ();
+    ~FB ();
+
+    bool ok () const;
+
+    enum { CHUNKSIZE = 1024 };
+
+private:
+    //
+    // Disallowed
+    //
+    FB (const FB& rhs);
+    FB& operator= (const FB&);
+
+    static TArena m_TArena;
+
+    size_t  m_size;
+    double* m_data;
+};
+
+TArena FB::m_TArena;
+
+FB::FB ()
+{
+#ifdef _OPENMP
+#pragma omp critical(tTArena_random)
+#endif
+    m_size = size_t(CHUNKSIZE*BoxLib::Random());
+    m_data = (double*) m_TArena.alloc(m_size*sizeof(double));
+    //
+    // Set specific values in the data.
+    //
+    for (int i = 0; i < m_size; i++)
+        m_data[i] = m_size;
+}
+
+FB::~FB ()
+{
+    ok();
+    m_TArena.free(m_data);
+}
+
+bool
+FB::ok () const
+{
+    for (int i = 0; i < m_size; i++)
+        BL_ASSERT(m_data[i] == m_size);
+    return true;
+}
+
+//
+// Allocate NBLOCKS blocks of made-up sizes, wait, check and free them,
+// wait, and do it again with the same sizes.  No thread frees anything
+// until they've all allocated, and once they've all freed their blocks
+// there's a cached block of the right size class for every one of the
+// second lot, so exactly half the alloc()s are cache hits.
+// They all fit in a thread's cache, so with a cache of its own they're
+// all hits in it.
+//
+enum { NBLOCKS = 20000, MAXBLOCK = 2*1024 };
+
+static
+long
+twoPasses (TArena&  arena,
+           unsigned seed,
+           void     (*wait)())
+{
+    std::vector<size_t>  sizes(NBLOCKS);
+    std::vector<double*> blocks(NBLOCKS);
+
+    for (int i = 0; i < NBLOCKS; i++)
+    {
+        seed = seed*1103515245u + 12345u;
+        sizes[i] = (seed >> 8) % (MAXBLOCK/sizeof(double));
+    }
+
+    long nbad = 0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < NBLOCKS; i++)
+        {
+            blocks[i] = static_cast<double*>(arena.alloc((sizes[i]+1)*sizeof(double)));
+            //
+            // Just the ends, so threads spend their time in the arena.
+            //
+            blocks[i][0] = blocks[i][sizes[i]] = i + seed;
+        }
+
+        wait();
+
+        for (int i = 0; i < NBLOCKS; i++)
+        {
+            if (blocks[i][0] != i + seed || blocks[i][sizes[i]] != i + seed)
+                nbad++;
+
+            arena.free(blocks[i]);
+        }
+
+        wait();
+    }
+
+    return nbad;
+}
+
+static
+int
+checkStats (const char*   what,
+            const TArena& arena,
+            long          nbad,
+            bool          own_caches)
+{
+    const double hit  = arena.hit_rate();
+    const double thit = arena.thread_hit_rate();
+    const double frag = arena.fragmentation();
+
+    std::cout << what << ": " << nbad << " bad values, hit rate = " << hit
+              << ", thread hit rate = " << thit
+              << ", fragmentation with everything freed = " << frag << std::endl;
+
+    int nfail = 0;
+
+    if (nbad > 0 || hit != 0.5 || arena.heap_space_actually_used() != 0 || frag != 1)
+        nfail++;
+
+    if (own_caches && thit != hit)
+        nfail++;
+
+    return nfail;
+}
+
+#ifdef _OPENMP
+static void ompBarrier () {
+#pragma omp barrier
+}
+#else
+static void noWait () {}
+#endif
+
+static pthread_barrier_t the_barrier;
+
+static void pthreadBarrier () { pthread_barrier_wait(&the_barrier); }
+
+static TArena* the_pthread_arena;
+
+static
+void*
+pthreadMain (void* arg)
+{
+    const long id = reinterpret_cast<long>(arg);
+
+    return reinterpret_cast<void*>(twoPasses(*the_pthread_arena, 17*id+1, pthreadBarrier));
+}
+
+int
+main ()
+{
+    int nfail = 0;
+    //
+    // A single thread: with everything handed out, and nothing cached,
+    // no more than a quarter of the heap is lost to rounding, besides
+    // the 64-byte headers.
+    //
+    {
+        TArena arena;
+
+        std::vector<size_t> sizes(NBLOCKS);
+        std::vector<void*>  blocks(NBLOCKS);
+
+        size_t requested = 0;
+
+        for (int i = 0; i < NBLOCKS; i++)
+        {
+            sizes[i]   = 1 + (i*7919) % MAXBLOCK;
+            blocks[i]  = arena.alloc(sizes[i]);
+            requested += sizes[i];
+        }
+
+        const double frag  = arena.fragmentation();
+        const double bound = 1 - requested / (1.25 * (requested + 2*64*NBLOCKS));
+
+        std::cout << "Everything handed out: fragmentation = " << frag
+                  << " (at most " << bound << "), hit rate = " << arena.hit_rate() << std::endl;
+
+        if (frag > bound || frag < 0 || arena.hit_rate() != 0 ||
+            arena.heap_space_actually_used() != arena.heap_space_used())
+            nfail++;
+
+        for (int i = 0; i < NBLOCKS; i++)
+            arena.free(blocks[i]);
+    }
+    //
+    // OpenMP threads, each of which should get a cache of its own.
+    //
+    {
+        TArena arena;
+
+        long nbad = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:nbad)
+        nbad += twoPasses(arena, 17*omp_get_thread_num()+1, ompBarrier);
+#else
+        nbad += twoPasses(arena, 1, noWait);
+#endif
+
+        nfail += checkStats("OpenMP threads", arena, nbad, true);
+    }
+    //
+    // Threads of our own, which OpenMP would number all the same, a few
+    // times over as races don't always show.
+    //
+    for (int rep = 0; rep < 20; rep++)
+    {
+        const int nthreads = 4;
+
+        TArena arena;
+
+        the_pthread_arena = &arena;
+
+        pthread_barrier_init(&the_barrier, 0, nthreads);
+
+        std::vector<pthread_t> threads(nthreads);
+
+        for (long i = 0; i < nthreads; i++)
+            pthread_create(&threads[i], 0, pthreadMain, reinterpret_cast<void*>(i));
+
+        long nbad = 0;
+
+        for (int i = 0; i < nthreads; i++)
+        {
+            void* r;
+            pthread_join(threads[i], &r);
+            nbad += reinterpret_cast<long>(r);
+        }
+
+        pthread_barrier_destroy(&the_barrier);
+
+        if (rep == 0 || nbad > 0 || arena.hit_rate() != 0.5)
+            nfail += checkStats("pthreads", arena, nbad, false);
+    }
+    //
+    // Each thread allocates and frees its own FBs through the shared arena.
+    //
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        list<FB*> fbl;
+
+        for (int j = 0; j < 10; j++)
+        {
+#ifdef _OPENMP
+#pragma omp master
+#endif
+            std::cout << "Loop == " << j << std::endl;
+
+            for (int i = 0; i < 1000; i++)
+            {
+                fbl.push_back(new FB);
+            }
+
+            while (!fbl.empty())
+            {
+                delete fbl.back();
+                fbl.pop_back();
+            }
+        }
+    }
+
+    if (nfail > 0)
+    {
+        std::cout << "tTArena: FAILED" << std::endl;
+        return 1;
+    }
+
+    std::cout << "tTArena: OK" << std::endl;
+
+    return 0;
+}
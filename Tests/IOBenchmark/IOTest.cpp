@@ -66,18 +66,23 @@ BoxArray MakeBoxArray(int maxgrid,  int nboxes) {
 
 // -------------------------------------------------------------
 void TestWriteNFiles(int nfiles, int maxgrid, int ncomps, int nboxes,
-                     bool raninit, bool mb2)
+                     bool raninit, bool mb2, int naggregators)
 {
   int myProc(ParallelDescriptor::MyProc());
 
   VisMF::SetNOutFiles(nfiles);
+  VisMF::SetAggregatorsPerNode(naggregators);
   if(mb2) {
     bytesPerMB = pow(2.0, 20);
   }
 
   BoxArray bArray(MakeBoxArray(maxgrid, nboxes));
   if(ParallelDescriptor::IOProcessor()) {
-    cout << "  Timings for writing to " << nfiles << " files:" << endl;
+    cout << "  Timings for writing to " << nfiles << " files";
+    if(naggregators > 0) {
+      cout << " with " << naggregators << " aggregators per node";
+    }
+    cout << ":" << endl;
   }
 
   // make a MultiFab
@@ -106,6 +111,8 @@ void TestWriteNFiles(int nfiles, int maxgrid, int ncomps, int nboxes,
 
   double wallTime(ParallelDescriptor::second() - wallTimeStart);
 
+  VisMF::SetAggregatorsPerNode(0);
+
   double wallTimeMax(wallTime);
   double wallTimeMin(wallTime);
 
@@ -121,6 +128,27 @@ void TestWriteNFiles(int nfiles, int maxgrid, int ncomps, int nboxes,
     cout << "  Min wall clock time = " << wallTimeMin << endl;
     cout << "  Max wall clock time = " << wallTimeMax << endl;
   }
+
+  // read it back and check it's what was written
+  MultiFab mfin;
+  VisMF::Read(mfin, mfName);
+
+  MultiFab mfcheck(bArray, ncomps, 0);
+  mfcheck.copy(mfin);
+
+  Real maxDiff(0.0);
+  for(MFIter mfi(mfcheck); mfi.isValid(); ++mfi) {
+    mfcheck[mfi].minus(mfout[mfi]);
+    maxDiff = std::max(maxDiff, mfcheck[mfi].norm(0, 0, ncomps));
+  }
+  ParallelDescriptor::ReduceRealMax(maxDiff);
+
+  if(ParallelDescriptor::IOProcessor()) {
+    cout << "  Read back:  max difference = " << maxDiff << endl;
+  }
+  if(maxDiff != 0.0) {
+    BoxLib::Abort("TestWriteNFiles:  the MultiFab read back differs from the one written");
+  }
 }
 
 
@@ -22,7 +22,7 @@ using std::endl;
 
 
 void TestWriteNFiles(int nfiles, int maxgrid, int ncomps, int nboxes,
-                     bool raninit, bool mb2);
+                     bool raninit, bool mb2, int naggregators);
 void TestReadMF();
 
 
@@ -40,6 +40,7 @@ static void PrintUsage(const char *progName) {
     cout << "   [ntimes = ntimes]" << '\n';
     cout << "   [raninit = tf]" << '\n';
     cout << "   [mb2    = tf]" << '\n';
+    cout << "   [naggregators = naggregators]" << '\n';
     cout << '\n';
     cout << "Running with default values." << '\n';
     cout << '\n';
@@ -62,7 +63,7 @@ int main(int argc, char *argv[]) {
   int myproc(ParallelDescriptor::MyProc());
   int nprocs(ParallelDescriptor::NProcs());
   int nsleep(0), nfiles(std::min(nprocs, 128));  // limit default to max of 128
-  int maxgrid(32), ncomps(4), nboxes(nprocs), ntimes(1);
+  int maxgrid(32), ncomps(4), nboxes(nprocs), ntimes(1), naggregators(1);
   bool raninit(false), mb2(false);
 
   pp.query("nfiles", nfiles);
@@ -83,6 +84,9 @@ int main(int argc, char *argv[]) {
   pp.query("raninit", raninit);
   pp.query("mb2", mb2);
 
+  pp.query("naggregators", naggregators);
+  naggregators = std::max(0, naggregators);
+
   if(ParallelDescriptor::IOProcessor()) {
     cout << endl;
     cout << "**************************************************" << endl;
@@ -94,6 +98,7 @@ int main(int argc, char *argv[]) {
     cout << "ntimes = " << ntimes << endl;
     cout << "raninit = " << raninit << endl;
     cout << "mb2 = " << mb2 << endl;
+    cout << "naggregators = " << naggregators << endl;
   }
 
   pp.query("nsleep", nsleep);
@@ -113,7 +118,7 @@ int main(int argc, char *argv[]) {
       cout << "Testing NFiles Write" << endl;
     }
 
-    TestWriteNFiles(nfiles, maxgrid, ncomps, nboxes, raninit, mb2);
+    TestWriteNFiles(nfiles, maxgrid, ncomps, nboxes, raninit, mb2, 0);
 
     if(ParallelDescriptor::IOProcessor()) {
       cout << "==================================================" << endl;
@@ -121,6 +126,22 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  if(naggregators > 0) {
+    for(int itimes(0); itimes < ntimes; ++itimes) {
+      if(ParallelDescriptor::IOProcessor()) {
+        cout << endl << "--------------------------------------------------" << endl;
+        cout << "Testing Aggregated Write" << endl;
+      }
+
+      TestWriteNFiles(nfiles, maxgrid, ncomps, nboxes, raninit, mb2, naggregators);
+
+      if(ParallelDescriptor::IOProcessor()) {
+        cout << "==================================================" << endl;
+        cout << endl;
+      }
+    }
+  }
+
   for(int itimes(0); itimes < ntimes; ++itimes) {
     if(ParallelDescriptor::IOProcessor()) {
       cout << endl << "++++++++++++++++++++++++++++++++++++++++++++++++++" << endl;
@@ -0,0 +1,178 @@
+//
+// Check that MultiGrid with the bottom solve gathered onto a subset of
+// the processors (mg.bottom_nprocs > 0) converges to the same solution
+// as with it spread over all of them.  The summation order in the
+// bottom CGSolver changes with the number of processors, so they agree
+// to the solver tolerance rather than bitwise.  The same ABecLaplacian
+// is used for every solve, so the later ones reuse the boundary
+// conditions it gathered for the first, or gather them again for a
+// bigger subset.  The domain isn't periodic, with Dirichlet boundaries
+// on the low faces and Neumann on the high ones.
+//
+//   mpirun -np 4 tBottomSubset.ex
+//
+#include <iostream>
+#include <cmath>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <LO_BCTYPES.H>
+#include <BndryData.H>
+#include <ABecLaplacian.H>
+#include <MultiGrid.H>
+#include <ParallelDescriptor.H>
+
+//
+// A function of the index only, so it doesn't depend on the layout.
+//
+static
+void
+fillFunc (MultiFab& mf,
+          Real      base,
+          Real      scale)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        FArrayBox& fab = mf[mfi];
+        const Box& bx  = fab.box();
+
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+        {
+            long k = 0;
+            for (int n = 0; n < BL_SPACEDIM; n++)
+                k = 37*k + iv[n];
+            fab(iv) = base + scale*std::sin(Real(k));
+        }
+    }
+}
+
+static
+Real
+solve (ABecLaplacian&  lp,
+       const MultiFab& rhs,
+       MultiFab&       soln,
+       int             bottom_nprocs,
+       int             verbose)
+{
+    soln.setVal(0);
+
+    MultiGrid mg(lp);
+
+    mg.setVerbose(verbose);
+    mg.set_bottom_nprocs(bottom_nprocs);
+    mg.solve(soln, rhs, 1.e-11, 0.0);
+
+    return soln.norm0();
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    ParmParse pp;
+
+    int n_cell = 64; pp.query("n_cell", n_cell);
+    int max_grid_size = 16; pp.query("max_grid_size", max_grid_size);
+    int verbose = 0; pp.query("verbose", verbose);
+
+    const int NProcs = ParallelDescriptor::NProcs();
+
+    if (NProcs == 1 && ParallelDescriptor::IOProcessor())
+        std::cout << "tBottomSubset: WARNING: on one CPU there's no subset to gather onto" << std::endl;
+
+    Box domain(IntVect::TheZeroVector(), (n_cell-1)*IntVect::TheUnitVector());
+
+    BoxArray ba(domain);
+    ba.maxSize(max_grid_size);
+
+    RealBox rb;
+    for (int n = 0; n < BL_SPACEDIM; n++)
+    {
+        rb.setLo(n, 0.0);
+        rb.setHi(n, 1.0);
+    }
+    int is_per[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+        is_per[n] = 0;
+
+    Geometry geom(domain, &rb, 0, is_per);
+
+    Real dx[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+        dx[n] = geom.CellSize(n);
+
+    MultiFab acoefs(ba, 1, 0);
+    fillFunc(acoefs, 1.0, 0.5);
+
+    BndryData bd(ba, 1, geom);
+
+    for (MFIter mfi(acoefs); mfi.isValid(); ++mfi)
+    {
+        const int i = mfi.index();
+
+        for (int n = 0; n < BL_SPACEDIM; n++)
+        {
+            const Orientation lo(n,Orientation::low), hi(n,Orientation::high);
+
+            bd.setBoundLoc(lo, i, 0.0);
+            bd.setBoundLoc(hi, i, 0.0);
+            bd.setBoundCond(lo, i, 0, LO_DIRICHLET);
+            bd.setBoundCond(hi, i, 0, LO_NEUMANN);
+            bd.setValue(lo, i, 0.0);
+            bd.setValue(hi, i, 0.0);
+        }
+    }
+
+    MultiFab bcoefs[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+    {
+        BoxArray eba(ba);
+        bcoefs[n].define(eba.surroundingNodes(n), 1, 0, Fab_allocate);
+        fillFunc(bcoefs[n], 1.0, 0.5);
+    }
+
+    ABecLaplacian lp(bd, dx);
+    lp.setScalars(1.0, 1.0);
+    lp.setCoefficients(acoefs, bcoefs);
+
+    MultiFab rhs(ba, 1, 0), soln0(ba, 1, 1), soln(ba, 1, 1);
+    fillFunc(rhs, 0.0, 1.0);
+
+    const Real norm0 = solve(lp, rhs, soln0, 0, verbose);
+    //
+    // One processor twice, the second time with what the first gathered,
+    // then two, which has to gather again, and all but one.
+    //
+    const int subsets[] = { 1, 1, 2, NProcs-1 };
+
+    int nfail = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        const int nprocs = subsets[i];
+
+        if (nprocs < 1 || nprocs >= NProcs) continue;
+
+        solve(lp, rhs, soln, nprocs, verbose);
+
+        MultiFab::Subtract(soln, soln0, 0, 0, 1, 0);
+
+        const Real diff = soln.norm0() / norm0;
+
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << "bottom_nprocs = " << nprocs << " of " << NProcs
+                      << ": max |difference| / max |solution| = " << diff << std::endl;
+
+        if (!(diff < 1.e-8))
+            nfail++;
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tBottomSubset: the bottom solve on a subset gives a different solution");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tBottomSubset: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
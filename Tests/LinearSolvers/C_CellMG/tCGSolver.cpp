@@ -0,0 +1,563 @@
+//
+// Check that CGSolver's CG and BiCGStab, with their reductions batched
+// and fused, take the same iterations as they did when every dot
+// product and norm was reduced on its own.  The solvers as they were
+// are copied below, with the kernels they used, and both are run on a
+// small ABecLaplacian problem: CG and BiCGStab unpreconditioned, and
+// BiCGStab preconditioned with a V-cycle.  The residual histories and
+// the solutions have to agree bitwise on one CPU; on more the MPI
+// library may add up the batched sums in another order, so they have
+// to agree to rounding.
+//
+//   mpirun -np 3 tCGSolver.ex
+//
+#include <iostream>
+#include <cmath>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <LO_BCTYPES.H>
+#include <BndryData.H>
+#include <ABecLaplacian.H>
+#include <CGSolver.H>
+#include <MultiGrid.H>
+#include <CG_F.H>
+#include <ParallelDescriptor.H>
+
+static int nfail = 0;
+//
+// For the protected solvers, so they can be run whatever cg.cg_solver says.
+//
+class TestCGSolver
+    :
+    public CGSolver
+{
+public:
+
+    TestCGSolver (LinOp& lp, bool use_mg_precond) : CGSolver(lp, use_mg_precond) {}
+
+    using CGSolver::solve_cg;
+    using CGSolver::solve_bicgstab;
+};
+
+static
+void
+fillFunc (MultiFab& mf,
+          Real      base,
+          Real      scale)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        FArrayBox& fab = mf[mfi];
+        const Box& bx  = fab.box();
+
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+        {
+            long k = 0;
+            for (int n = 0; n < BL_SPACEDIM; n++)
+                k = 37*k + iv[n];
+            fab(iv) = base + scale*std::sin(Real(k));
+        }
+    }
+}
+//
+// The kernels the solvers used before the reductions were fused.
+//
+static
+Real
+norm_inf (const MultiFab& res)
+{
+    Real restot = 0;
+
+    for (MFIter mfi(res); mfi.isValid(); ++mfi)
+        restot = std::max(restot, res[mfi].norm(mfi.validbox(), 0));
+
+    ParallelDescriptor::ReduceRealMax(restot);
+
+    return restot;
+}
+
+static
+void
+sxay (MultiFab&       ss,
+      const MultiFab& xx,
+      Real            a,
+      const MultiFab& yy)
+{
+    const int ncomp = 1;
+
+    for (MFIter mfi(ss); mfi.isValid(); ++mfi)
+    {
+        const Box&       bx    = mfi.validbox();
+        FArrayBox&       ssfab = ss[mfi];
+        const FArrayBox& xxfab = xx[mfi];
+        const FArrayBox& yyfab = yy[mfi];
+
+        FORT_CGSXAY(ssfab.dataPtr(),
+                    ARLIM(ssfab.loVect()), ARLIM(ssfab.hiVect()),
+                    xxfab.dataPtr(),
+                    ARLIM(xxfab.loVect()), ARLIM(xxfab.hiVect()),
+                    &a,
+                    yyfab.dataPtr(),
+                    ARLIM(yyfab.loVect()), ARLIM(yyfab.hiVect()),
+                    bx.loVect(), bx.hiVect(),
+                    &ncomp);
+    }
+}
+
+static
+Real
+dotxy (const MultiFab& r,
+       const MultiFab& z,
+       bool            local = false)
+{
+    const int ncomp = 1;
+
+    Real dot = 0;
+
+    for (MFIter mfi(r); mfi.isValid(); ++mfi)
+    {
+        const Box&       rbx  = mfi.validbox();
+        const FArrayBox& rfab = r[mfi];
+        const FArrayBox& zfab = z[mfi];
+
+        Real tdot;
+
+        FORT_CGXDOTY(&tdot,
+                     zfab.dataPtr(),
+                     ARLIM(zfab.loVect()),ARLIM(zfab.hiVect()),
+                     rfab.dataPtr(),
+                     ARLIM(rfab.loVect()),ARLIM(rfab.hiVect()),
+                     rbx.loVect(),rbx.hiVect(),
+                     &ncomp);
+        dot += tdot;
+    }
+
+    if ( !local )
+        ParallelDescriptor::ReduceRealSum(dot);
+
+    return dot;
+}
+//
+// CGSolver::solve_bicgstab() as it was, without the Jacobi preconditioner.
+//
+static
+int
+oldBiCGStab (LinOp&          Lp,
+             MultiGrid*      mg_precond,
+             MultiFab&       sol,
+             const MultiFab& rhs,
+             Real            eps_rel,
+             Real            eps_abs,
+             int             maxiter,
+             Array<Real>&    hist)
+{
+    const int nghost = 1, ncomp = 1, lev = 0;
+
+    MultiFab ph(sol.boxArray(), ncomp, nghost);
+    MultiFab sh(sol.boxArray(), ncomp, nghost);
+
+    MultiFab sorig(sol.boxArray(), ncomp, 0);
+    MultiFab p    (sol.boxArray(), ncomp, 0);
+    MultiFab r    (sol.boxArray(), ncomp, 0);
+    MultiFab s    (sol.boxArray(), ncomp, 0);
+    MultiFab rh   (sol.boxArray(), ncomp, 0);
+    MultiFab v    (sol.boxArray(), ncomp, 0);
+    MultiFab t    (sol.boxArray(), ncomp, 0);
+
+    Lp.residual(r, rhs, sol, lev, LinOp::Inhomogeneous_BC);
+
+    MultiFab::Copy(sorig,sol,0,0,1,0);
+    MultiFab::Copy(rh,   r,  0,0,1,0);
+
+    sol.setVal(0);
+
+    const LinOp::BC_Mode temp_bc_mode = LinOp::Homogeneous_BC;
+
+    Real vals[2] = { norm_inf(r), Lp.norm(0, lev, true) };
+
+    ParallelDescriptor::ReduceRealMax(vals,2);
+
+    Real       rnorm    = vals[0];
+    const Real Lp_norm  = vals[1];
+    Real       sol_norm = 0;
+    const Real rnorm0   = rnorm;
+
+    hist.assign(1, rnorm);
+
+    int ret = 0, nit = 1;
+    Real rho_1 = 0, alpha = 0, omega = 0;
+
+    if ( rnorm0 == 0 || rnorm0 < eps_abs )
+        return ret;
+
+    for (; nit <= maxiter; ++nit)
+    {
+        const Real rho = dotxy(rh,r);
+        if ( rho == 0 )
+	{
+            ret = 1; break;
+	}
+        if ( nit == 1 )
+        {
+            MultiFab::Copy(p,r,0,0,1,0);
+        }
+        else
+        {
+            const Real beta = (rho/rho_1)*(alpha/omega);
+            sxay(p, p, -omega, v);
+            sxay(p, r,   beta, p);
+        }
+        if ( mg_precond )
+        {
+            ph.setVal(0);
+            mg_precond->solve(ph, p, eps_rel, eps_abs, temp_bc_mode);
+        }
+        else
+        {
+            MultiFab::Copy(ph,p,0,0,1,0);
+        }
+        Lp.apply(v, ph, lev, temp_bc_mode);
+
+        if ( Real rhTv = dotxy(rh,v) )
+	{
+            alpha = rho/rhTv;
+	}
+        else
+	{
+            ret = 2; break;
+	}
+        sxay(sol, sol,  alpha, ph);
+        sxay(s,     r, -alpha,  v);
+
+        rnorm = norm_inf(s);
+        hist.push_back(rnorm);
+
+        sol_norm = norm_inf(sol);
+        if ( rnorm < eps_rel*(Lp_norm*sol_norm + rnorm0 ) || rnorm < eps_abs ) break;
+
+        if ( mg_precond )
+        {
+            sh.setVal(0);
+            mg_precond->solve(sh, s, eps_rel, eps_abs, temp_bc_mode);
+        }
+        else
+        {
+            MultiFab::Copy(sh,s,0,0,1,0);
+        }
+        Lp.apply(t, sh, lev, temp_bc_mode);
+
+        Real vals[2] = { dotxy(t,t,true), dotxy(t,s,true) };
+
+        ParallelDescriptor::ReduceRealSum(vals,2);
+
+        if ( vals[0] )
+	{
+            omega = vals[1]/vals[0];
+	}
+        else
+	{
+            ret = 3; break;
+	}
+        sxay(sol, sol,  omega, sh);
+        sxay(r,     s, -omega,  t);
+
+        rnorm = norm_inf(r);
+        hist.push_back(rnorm);
+
+        sol_norm = norm_inf(sol);
+        if ( rnorm < eps_rel*(Lp_norm*sol_norm + rnorm0 ) || rnorm < eps_abs ) break;
+
+        if ( omega == 0 )
+	{
+            ret = 4; break;
+	}
+        rho_1 = rho;
+    }
+
+    if ( ret == 0 && rnorm > eps_rel*(Lp_norm*sol_norm + rnorm0 ) && rnorm > eps_abs )
+        ret = 8;
+
+    if ( ( ret == 0 || ret == 8 ) && (rnorm < rnorm0) )
+    {
+        sol.plus(sorig, 0, 1, 0);
+    }
+    else
+    {
+        sol.setVal(0);
+        sol.plus(sorig, 0, 1, 0);
+    }
+
+    return ret;
+}
+//
+// CGSolver::solve_cg() as it was, without the jbb preconditioner.
+//
+static
+int
+oldCG (LinOp&          Lp,
+       MultiFab&       sol,
+       const MultiFab& rhs,
+       Real            eps_rel,
+       Real            eps_abs,
+       int             maxiter,
+       Real            unstable_criterion,
+       Array<Real>&    hist)
+{
+    const int nghost = 1, ncomp = 1, lev = 0;
+
+    MultiFab sorig(sol.boxArray(), ncomp, nghost);
+    MultiFab r(sol.boxArray(), ncomp, nghost);
+    MultiFab q(sol.boxArray(), ncomp, nghost);
+    MultiFab p(sol.boxArray(), ncomp, nghost);
+
+    MultiFab::Copy(sorig,sol,0,0,1,0);
+
+    Lp.residual(r, rhs, sorig, lev, LinOp::Inhomogeneous_BC);
+
+    sol.setVal(0);
+
+    const LinOp::BC_Mode temp_bc_mode=LinOp::Homogeneous_BC;
+
+    Real       rnorm    = norm_inf(r);
+    const Real rnorm0   = rnorm;
+    Real       minrnorm = rnorm;
+
+    hist.assign(1, rnorm);
+
+    const Real Lp_norm = Lp.norm(0, lev);
+    Real sol_norm      = 0;
+    Real rho_1         = 0;
+    int  ret           = 0;
+    int  nit           = 1;
+
+    if ( rnorm == 0 || rnorm < eps_abs )
+        return 0;
+
+    for (; nit <= maxiter; ++nit)
+    {
+        Real rho = dotxy(r,r);
+
+        if (nit == 1)
+        {
+            MultiFab::Copy(p,r,0,0,1,0);
+        }
+        else
+        {
+            Real beta = rho/rho_1;
+            sxay(p, r, beta, p);
+        }
+        Lp.apply(q, p, lev, temp_bc_mode);
+
+        Real alpha;
+        if ( Real pw = dotxy(p,q) )
+	{
+            alpha = rho/pw;
+	}
+        else
+	{
+            ret = 1; break;
+	}
+
+        sxay(sol, sol, alpha, p);
+        sxay(  r,   r,-alpha, q);
+        rnorm = norm_inf(r);
+        sol_norm = norm_inf(sol);
+
+        hist.push_back(rnorm);
+
+        if ( rnorm < eps_rel*(Lp_norm*sol_norm + rnorm0) || rnorm < eps_abs ) break;
+
+        if ( rnorm > unstable_criterion*minrnorm )
+	{
+            ret = 2; break;
+	}
+        else if ( rnorm < minrnorm )
+	{
+            minrnorm = rnorm;
+	}
+
+        rho_1 = rho;
+    }
+
+    if ( ret == 0 && rnorm > eps_rel*(Lp_norm*sol_norm + rnorm0) && rnorm > eps_abs )
+        ret = 8;
+
+    if ( ( ret == 0 || ret == 8 ) && (rnorm < rnorm0) )
+    {
+        sol.plus(sorig, 0, 1, 0);
+    }
+    else
+    {
+        sol.setVal(0);
+        sol.plus(sorig, 0, 1, 0);
+    }
+
+    return ret;
+}
+
+static
+void
+compare (const char*        what,
+         int                ret,
+         int                oldret,
+         const Array<Real>& hist,
+         const Array<Real>& oldhist,
+         const MultiFab&    soln,
+         const MultiFab&    oldsoln,
+         Real               tol)
+{
+    Real maxdiff = 0;
+
+    const int n = std::min(hist.size(), oldhist.size());
+
+    for (int i = 0; i < n; i++)
+        maxdiff = std::max(maxdiff, std::abs(hist[i] - oldhist[i]) / oldhist[0]);
+
+    MultiFab diff(soln.boxArray(), 1, 0);
+    MultiFab::Copy(diff, soln, 0, 0, 1, 0);
+    MultiFab::Subtract(diff, oldsoln, 0, 0, 1, 0);
+
+    const Real soldiff = diff.norm0() / oldsoln.norm0();
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << what << ": returned " << ret << " (" << oldret << " before), "
+                  << hist.size() << " residuals (" << oldhist.size() << " before), "
+                  << "final residual / initial = " << hist[hist.size()-1] / hist[0]
+                  << ", max difference in the residuals = " << maxdiff
+                  << ", in the solution = " << soldiff << std::endl;
+
+    if (ret != oldret || hist.size() != oldhist.size() || maxdiff > tol || soldiff > tol)
+    {
+        if (ParallelDescriptor::IOProcessor())
+            std::cout << "FAILED: " << what << std::endl;
+        nfail++;
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    ParmParse pp;
+
+    int n_cell = 32; pp.query("n_cell", n_cell);
+    int max_grid_size = 8; pp.query("max_grid_size", max_grid_size);
+
+    const Real tol = (ParallelDescriptor::NProcs() == 1) ? 0 : 1.e-10;
+
+    Box domain(IntVect::TheZeroVector(), (n_cell-1)*IntVect::TheUnitVector());
+
+    BoxArray ba(domain);
+    ba.maxSize(max_grid_size);
+
+    RealBox rb;
+    for (int n = 0; n < BL_SPACEDIM; n++)
+    {
+        rb.setLo(n, 0.0);
+        rb.setHi(n, 1.0);
+    }
+    int is_per[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+        is_per[n] = 0;
+
+    Geometry geom(domain, &rb, 0, is_per);
+
+    Real dx[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+        dx[n] = geom.CellSize(n);
+
+    MultiFab acoefs(ba, 1, 0);
+    fillFunc(acoefs, 1.0, 0.5);
+
+    BndryData bd(ba, 1, geom);
+
+    for (MFIter mfi(acoefs); mfi.isValid(); ++mfi)
+    {
+        const int i = mfi.index();
+
+        for (int n = 0; n < BL_SPACEDIM; n++)
+        {
+            const Orientation lo(n,Orientation::low), hi(n,Orientation::high);
+
+            bd.setBoundLoc(lo, i, 0.0);
+            bd.setBoundLoc(hi, i, 0.0);
+            bd.setBoundCond(lo, i, 0, LO_DIRICHLET);
+            bd.setBoundCond(hi, i, 0, LO_NEUMANN);
+            bd.setValue(lo, i, 0.0);
+            bd.setValue(hi, i, 0.0);
+        }
+    }
+
+    MultiFab bcoefs[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+    {
+        BoxArray eba(ba);
+        bcoefs[n].define(eba.surroundingNodes(n), 1, 0, Fab_allocate);
+        fillFunc(bcoefs[n], 1.0, 0.5);
+    }
+
+    ABecLaplacian lp(bd, dx);
+    lp.setScalars(1.0, 1.0);
+    lp.setCoefficients(acoefs, bcoefs);
+    lp.maxOrder(2);
+
+    MultiFab rhs(ba, 1, 0), guess(ba, 1, 1), soln(ba, 1, 1), oldsoln(ba, 1, 1);
+    fillFunc(rhs, 0.0, 1.0);
+    //
+    // A guess that isn't zero, so the solvers work on the correction.
+    //
+    fillFunc(guess, 0.0, 1.e-3);
+
+    const Real eps_rel = 1.e-10, eps_abs = 0;
+
+    for (int mg = 0; mg < 2; mg++)
+    {
+        TestCGSolver cg(lp, mg);
+        MultiGrid    mg_precond(lp);
+        Array<Real>  oldhist;
+
+        cg.setMaxIter(400);
+
+        MultiFab::Copy(soln,    guess, 0, 0, 1, 1);
+        MultiFab::Copy(oldsoln, guess, 0, 0, 1, 1);
+
+        const int ret    = cg.solve_bicgstab(soln, rhs, eps_rel, eps_abs, LinOp::Inhomogeneous_BC);
+        const int oldret = oldBiCGStab(lp, mg ? &mg_precond : 0, oldsoln, rhs,
+                                       eps_rel, eps_abs, cg.getMaxIter(), oldhist);
+
+        compare(mg ? "BiCGStab with MG" : "BiCGStab", ret, oldret,
+                cg.residualHistory(), oldhist, soln, oldsoln, tol);
+    }
+
+    {
+        TestCGSolver cg(lp, false);
+        Array<Real>  oldhist;
+
+        cg.setMaxIter(400);
+
+        MultiFab::Copy(soln,    guess, 0, 0, 1, 1);
+        MultiFab::Copy(oldsoln, guess, 0, 0, 1, 1);
+
+        Real unstable_criterion = 10;
+        {
+            ParmParse ppcg("cg");
+            ppcg.query("unstable_criterion", unstable_criterion);
+        }
+
+        const int ret    = cg.solve_cg(soln, rhs, eps_rel, eps_abs, LinOp::Inhomogeneous_BC);
+        const int oldret = oldCG(lp, oldsoln, rhs, eps_rel, eps_abs, cg.getMaxIter(),
+                                 unstable_criterion, oldhist);
+
+        compare("CG", ret, oldret, cg.residualHistory(), oldhist, soln, oldsoln, tol);
+    }
+
+    if (nfail > 0)
+        BoxLib::Abort("tCGSolver: the solvers don't iterate as they did");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tCGSolver: OK" << std::endl;
+
+    BoxLib::Finalize();
+}
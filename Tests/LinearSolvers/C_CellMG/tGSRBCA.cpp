@@ -0,0 +1,311 @@
+//
+// Check the communication-avoiding GSRB smoother (Lp.smooth_ngrow > 1)
+// against the standard one, on the coarsened levels 1 and 2 of three
+// problems:
+//
+//   1. A domain periodic in every direction, so every ghost cell is
+//      covered by a grid and the two have to agree everywhere.  The
+//      grids start at index 0, so the grown tiles reach into negative
+//      indices, where the red/black parity has to come out right.
+//
+//   2. A domain that isn't periodic, with Dirichlet boundaries on the
+//      low faces and Neumann on the high ones.  Ghost cells of other
+//      grids next to the domain boundary aren't relaxed, and lag behind,
+//      so the two only have to agree more than one cell per half-sweep
+//      away from the domain boundary.
+//
+//   3. The same, with the grids in one corner of the domain taken out,
+//      as on a fine level, so that there are ghost cells inside the
+//      domain not covered by any grid, with Dirichlet values on them.
+//      Here the two only have to agree more than one cell per half-sweep
+//      away from those as well.
+//
+// Closer in they only have to converge to the same thing, so MultiGrid
+// solves with the two smoothers are compared as well.
+//
+#include <iostream>
+
+#include <Utility.H>
+#include <ParmParse.H>
+#include <LO_BCTYPES.H>
+#include <BndryData.H>
+#include <ABecLaplacian.H>
+#include <MultiGrid.H>
+#include <ParallelDescriptor.H>
+
+static int nfail = 0;
+
+static
+void
+fillRandom (MultiFab& mf)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        FArrayBox& fab = mf[mfi];
+        Real*      dp  = fab.dataPtr();
+        const long N   = fab.box().numPts() * fab.nComp();
+
+        for (long i = 0; i < N; i++)
+            dp[i] = BoxLib::Random() - 0.5;
+    }
+}
+
+//
+// Coefficients have to agree where grids share a face, periodic images
+// included, so they're a function of the (periodic) index.
+//
+static
+void
+fillCoef (MultiFab& mf,
+          int       n_cell)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        FArrayBox& fab = mf[mfi];
+        const Box& bx  = fab.box();
+
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+        {
+            int k = 0;
+            for (int n = 0; n < BL_SPACEDIM; n++)
+                k += (2*n+3) * (((iv[n] % n_cell) + n_cell) % n_cell);
+            fab(iv) = 1.0 + 0.1*(k % 11);
+        }
+    }
+}
+//
+// Smooth soln0 both ways and return the largest difference, and in
+// nfar the number of cells that differ more than reach cells away from
+// any cell the grids don't cover, outside the domain included.  Cells
+// that aren't finite count wherever they are, as they come from using
+// ghost cells that weren't filled, and norm0() doesn't see them.
+//
+static
+Real
+smoothDiff (ABecLaplacian&  lp,
+            const MultiFab& soln0,
+            const MultiFab& rhs,
+            int             level,
+            int             ngrow,
+            int             nsmooth,
+            int             reach,
+            long&           nfar)
+{
+    const BoxArray& ba = lp.boxArray(level);
+
+    MultiFab s1(ba, 1, 1), s2(ba, 1, 1);
+
+    MultiFab::Copy(s1, soln0, 0, 0, 1, 1);
+    MultiFab::Copy(s2, soln0, 0, 0, 1, 1);
+
+    lp.smoothNGrow(1);
+    lp.smooth(s1, rhs, level, LinOp::Homogeneous_BC, nsmooth);
+
+    lp.smoothNGrow(ngrow);
+    lp.smooth(s2, rhs, level, LinOp::Homogeneous_BC, nsmooth);
+
+    MultiFab::Subtract(s2, s1, 0, 0, 1, 0);
+
+    nfar = 0;
+
+    for (MFIter mfi(s2); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.validbox();
+
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+        {
+            const Real d = s2[mfi](iv);
+
+            if (d != d || (d != 0 && ba.contains(Box(iv,iv).grow(reach))))
+                nfar++;
+        }
+    }
+
+    ParallelDescriptor::ReduceLongSum(nfar);
+
+    return s2.norm0();
+}
+
+static
+void
+mgSolve (ABecLaplacian&  lp,
+         MultiFab&       soln,
+         const MultiFab& rhs,
+         int             ngrow)
+{
+    lp.smoothNGrow(ngrow);
+
+    soln.setVal(0);
+
+    MultiGrid mg(lp);
+    mg.solve(soln, rhs, 1.e-11, 0.0);
+}
+
+static
+void
+runCase (const char*     what,
+         const BoxArray& ba,
+         bool            periodic,
+         int             n_cell,
+         bool            everywhere)
+{
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << what << ":" << std::endl;
+    //
+    // The periodicity is static, and only set up by the first Geometry
+    // defined after a Finalize().
+    //
+    Geometry::Finalize();
+
+    RealBox rb;
+    int     is_per[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+    {
+        rb.setLo(n, 0.0);
+        rb.setHi(n, 1.0);
+        is_per[n] = periodic;
+    }
+    const Box domain(IntVect::TheZeroVector(), (n_cell-1)*IntVect::TheUnitVector());
+
+    Geometry geom(domain, &rb, 0, is_per);
+
+    BL_ASSERT(Geometry::isAllPeriodic() == periodic);
+
+    Real dx[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+        dx[n] = geom.CellSize(n);
+
+    MultiFab acoefs(ba, 1, 0);
+    fillCoef(acoefs, n_cell);
+    //
+    // Dirichlet on the low faces and Neumann on the high ones where the
+    // grids meet the domain boundary, Dirichlet with a value where they
+    // meet cells no grid covers.  Faces between grids and on periodic
+    // boundaries are masked off, whatever they're set to.
+    //
+    BndryData bd(ba, 1, geom);
+
+    for (MFIter mfi(acoefs); mfi.isValid(); ++mfi)
+    {
+        const int  i  = mfi.index();
+        const Box& bx = mfi.validbox();
+
+        for (int n = 0; n < BL_SPACEDIM; n++)
+        {
+            const Orientation lo(n,Orientation::low), hi(n,Orientation::high);
+
+            const bool physlo = bx.smallEnd(n) == domain.smallEnd(n);
+            const bool physhi = bx.bigEnd(n)   == domain.bigEnd(n);
+
+            bd.setBoundLoc(lo, i, 0.0);
+            bd.setBoundLoc(hi, i, 0.0);
+            bd.setBoundCond(lo, i, 0, LO_DIRICHLET);
+            bd.setBoundCond(hi, i, 0, physhi ? LO_NEUMANN : LO_DIRICHLET);
+            bd.setValue(lo, i, physlo ? 0.0 : 1.0);
+            bd.setValue(hi, i, physhi ? 0.0 : 1.0);
+        }
+    }
+
+    MultiFab bcoefs[BL_SPACEDIM];
+    for (int n = 0; n < BL_SPACEDIM; n++)
+    {
+        BoxArray eba(ba);
+        bcoefs[n].define(eba.surroundingNodes(n), 1, 0, Fab_allocate);
+        fillCoef(bcoefs[n], n_cell);
+    }
+
+    ABecLaplacian lp(bd, dx);
+    lp.setScalars(1.0, 1.0);
+    lp.setCoefficients(acoefs, bcoefs);
+    //
+    // The deep-ghost smoother is only used on the coarsened levels.
+    //
+    for (int level = 1; level <= 2; level++)
+    {
+        lp.prepareForLevel(level);
+
+        MultiFab soln(lp.boxArray(level), 1, 1), rhs(lp.boxArray(level), 1, 1);
+        fillRandom(soln);
+        fillRandom(rhs);
+
+        for (int ngrow = 2; ngrow <= 3; ngrow++)
+        {
+            for (int nsmooth = 1; nsmooth <= 4; nsmooth++)
+            {
+                long nfar;
+
+                const Real diff = smoothDiff(lp, soln, rhs, level, ngrow, nsmooth, 2*nsmooth, nfar);
+
+                if (ParallelDescriptor::IOProcessor())
+                    std::cout << "  level " << level
+                              << ", smooth_ngrow = " << ngrow
+                              << ", nsmooth = " << nsmooth
+                              << ": max |difference| = " << diff
+                              << ", cells differing away from the boundary = " << nfar << std::endl;
+
+                if (nfar > 0 || (everywhere && diff != 0))
+                    nfail++;
+            }
+        }
+    }
+
+    lp.smoothNGrow(1);
+
+    MultiFab rhs(ba, 1, 0), soln1(ba, 1, 1), soln3(ba, 1, 1);
+    fillCoef(rhs, n_cell);
+    rhs.plus(-1.5, 0);
+
+    mgSolve(lp, soln1, rhs, 1);
+    mgSolve(lp, soln3, rhs, 3);
+
+    MultiFab::Subtract(soln3, soln1, 0, 0, 1, 0);
+
+    const Real mgdiff = soln3.norm0() / soln1.norm0();
+
+    int nan = soln3.contains_nan(0, 1, 0);
+    ParallelDescriptor::ReduceIntMax(nan);
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "  MultiGrid, smooth_ngrow = 3 against 1: max |difference| / max |solution| = "
+                  << mgdiff << std::endl;
+
+    if (nan || !(mgdiff < 1.e-8))
+        nfail++;
+
+    lp.smoothNGrow(1);
+}
+
+int
+main (int argc, char* argv[])
+{
+    BoxLib::Initialize(argc, argv);
+
+    ParmParse pp;
+
+    int n_cell = 64; pp.query("n_cell", n_cell);
+    int max_grid_size = 8; pp.query("max_grid_size", max_grid_size);
+
+    BoxArray ba(Box(IntVect::TheZeroVector(), (n_cell-1)*IntVect::TheUnitVector()));
+    ba.maxSize(max_grid_size);
+    //
+    // The grids with every index in the upper half of the domain.
+    //
+    BoxList bl;
+    for (int i = 0; i < ba.size(); i++)
+        if (!(ba[i].smallEnd() >= (n_cell/2)*IntVect::TheUnitVector()))
+            bl.push_back(ba[i]);
+
+    BoxArray partial(bl);
+
+    runCase("periodic",                                    ba,      true,  n_cell, true);
+    runCase("Dirichlet and Neumann",                       ba,      false, n_cell, false);
+    runCase("Dirichlet and Neumann, one corner uncovered", partial, false, n_cell, false);
+
+    if (nfail > 0)
+        BoxLib::Abort("tGSRBCA: deep-ghost GSRB differs from the standard GSRB");
+
+    if (ParallelDescriptor::IOProcessor())
+        std::cout << "tGSRBCA: OK" << std::endl;
+
+    BoxLib::Finalize();
+}